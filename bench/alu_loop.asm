@@ -0,0 +1,22 @@
+; bench/alu_loop.asm - register ALU ops in a counted inner loop
+;
+; Every bench workload is a flat image loaded and entered at 0000:7C00
+; and loops forever; the harness stops it by instruction budget.
+
+bits 16
+org 0x7C00
+
+start:
+    mov cx, 1000
+.inner:
+    add ax, cx
+    xor bx, ax
+    sub dx, bx
+    adc si, 3
+    and di, 0x7FFF
+    or  bp, dx
+    sbb al, bl
+    cmp ax, bx
+    dec cx
+    jnz .inner
+    jmp start
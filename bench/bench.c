@@ -0,0 +1,301 @@
+// bench/bench.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * In-process benchmark harness.
+ *
+ *   x64-bench [--budget N] [--repeat N] [--jit] [--json out.json]
+ *             [--baseline base.json] [--max-regress PCT] image.bin...
+ *
+ * Each image is loaded at 0000:7C00 in a fresh VM and run from there
+ * for `budget` instructions (I/O exits are absorbed, anything else
+ * that stops the guest is an error). The best of `repeat` runs is
+ * reported as instructions/second and ns/instruction, with the peak
+ * RSS of the process after the workload.
+ *
+ * With --baseline, each workload's IPS is compared against the same
+ * name in an earlier --json output; a drop of more than --max-regress
+ * percent (default 10) makes the exit status 1.
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE     // getrusage() under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "vm/vm.h"
+#include "vm/stats.h"       // stats_clock_ns()
+#include "jit/jit.h"
+
+#define BENCH_LOAD      0x7C00u
+#define BENCH_RAM       (1u << 20)
+
+typedef struct bench_result {
+    char     name[64];
+    uint64_t retired;
+    uint64_t ns;
+    uint64_t rss_kb;
+    bool     ok;
+} bench_result_t;
+
+static VMManager g_vms;
+
+/* ============================================================
+ * helpers
+ * ============================================================ */
+
+static uint64_t peak_rss_kb(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return (uint64_t)pmc.PeakWorkingSetSize / 1024u;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return (uint64_t)ru.ru_maxrss / 1024u;     // bytes on macOS
+#else
+    return (uint64_t)ru.ru_maxrss;             // KiB on Linux
+#endif
+#endif
+}
+
+// "bench/build/alu_loop.bin" -> "alu_loop"
+static void base_name(const char *path, char *out, size_t n)
+{
+    const char *s = path;
+    for (const char *p = path; *p; p++)
+        if (*p == '/' || *p == '\\') s = p + 1;
+
+    size_t len = strcspn(s, ".");
+    if (len >= n) len = n - 1u;
+    memcpy(out, s, len);
+    out[len] = 0;
+}
+
+static bool load_image(VM *vm, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    size_t n = fread(vm->mem + BENCH_LOAD, 1, vm->mem_size - BENCH_LOAD, f);
+    fclose(f);
+    vm_code_flush(vm);
+    return n > 0;
+}
+
+/* ============================================================
+ * one workload
+ * ============================================================ */
+
+static bool run_once(const char *path, uint64_t budget, bool jit, uint64_t *ns, uint64_t *retired)
+{
+    int id = vm_create_default(&g_vms, BENCH_RAM, "bench");
+    if (id < 0) return false;
+    VM *vm = vm_get(&g_vms, id);
+
+    bool ok = load_image(vm, path) && (!jit || vm_set_jit(vm, true));
+    if (!ok) {
+        vm_destroy(&g_vms, id);
+        return false;
+    }
+    vm->cpu.cs = 0;
+    vm->cpu.ip = BENCH_LOAD;
+
+    vm_exit_t x = {0};
+    uint64_t done = 0;
+    const uint64_t t0 = stats_clock_ns();
+
+    while (done < budget) {
+        vm_run(vm, budget - done, &x);
+        done += x.retired;
+        if (x.reason == VM_EXIT_IO) continue;
+        if (x.reason != VM_EXIT_BUDGET) break;
+    }
+    *ns = stats_clock_ns() - t0;
+    *retired = done;
+
+    if (done < budget) {
+        fprintf(stderr, "bench: %s stopped at %04X:%04X after %llu insns (status %d)\n",
+                path, x.cs, x.ip, (unsigned long long)done, (int)x.status);
+        ok = false;
+    }
+    vm_destroy(&g_vms, id);
+    return ok;
+}
+
+static bench_result_t run_workload(const char *path, uint64_t budget, unsigned repeat, bool jit)
+{
+    bench_result_t r;
+    memset(&r, 0, sizeof(r));
+    base_name(path, r.name, sizeof(r.name));
+
+    for (unsigned i = 0; i < repeat; i++) {
+        uint64_t ns = 0, n = 0;
+        if (!run_once(path, budget, jit, &ns, &n)) return r;
+        if (!r.ok || ns < r.ns) {
+            r.ns = ns ? ns : 1u;
+            r.retired = n;
+        }
+        r.ok = true;
+    }
+    r.rss_kb = peak_rss_kb();
+    return r;
+}
+
+static double ips_of(const bench_result_t *r)
+{
+    return (double)r->retired * 1e9 / (double)r->ns;
+}
+
+/* ============================================================
+ * baseline
+ * ============================================================ */
+
+static char *read_text(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    long len = -1;
+    if (fseek(f, 0, SEEK_END) == 0) len = ftell(f);
+    if (len < 0 || fseek(f, 0, SEEK_SET) != 0) { fclose(f); return NULL; }
+
+    char *buf = (char*)malloc((size_t)len + 1u);
+    if (buf && fread(buf, 1, (size_t)len, f) != (size_t)len) { free(buf); buf = NULL; }
+    fclose(f);
+    if (buf) buf[len] = 0;
+    return buf;
+}
+
+// IPS recorded for `name` in a file written by write_json(), or 0
+static double baseline_ips(const char *json, const char *name)
+{
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\":\"%.63s\"", name);
+
+    const char *p = json ? strstr(json, key) : NULL;
+    if (!p) return 0.0;
+    p = strstr(p, "\"ips\":");
+    return p ? strtod(p + 6, NULL) : 0.0;
+}
+
+static bool write_json(const char *path, const bench_result_t *r, unsigned n, uint64_t budget, bool jit)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "{\"budget\":%llu,\"jit\":%s,\"workloads\":[", (unsigned long long)budget, jit ? "true" : "false");
+    for (unsigned i = 0; i < n; i++) {
+        fprintf(f, "%s\n  {\"name\":\"%s\",\"ok\":%s,\"retired\":%llu,\"ns\":%llu,"
+                   "\"ips\":%.0f,\"ns_per_insn\":%.3f,\"peak_rss_kb\":%llu}",
+                i ? "," : "", r[i].name, r[i].ok ? "true" : "false",
+                (unsigned long long)r[i].retired, (unsigned long long)r[i].ns,
+                r[i].ok ? ips_of(&r[i]) : 0.0, r[i].ok ? (double)r[i].ns / (double)r[i].retired : 0.0,
+                (unsigned long long)r[i].rss_kb);
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+/* ============================================================
+ * main
+ * ============================================================ */
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--budget N] [--repeat N] [--jit] [--json out.json]\n"
+                    "       [--baseline base.json] [--max-regress PCT] image.bin...\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t budget = 10000000u;
+    unsigned repeat = 3;
+    bool jit = false;
+    const char *json = NULL, *baseline = NULL;
+    double max_regress = 10.0;
+
+    const char *images[64];
+    unsigned nimages = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const bool more = i + 1 < argc;
+        if (!strcmp(argv[i], "--budget") && more)           budget = strtoull(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--repeat") && more)      repeat = (unsigned)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--jit"))                 jit = true;
+        else if (!strcmp(argv[i], "--json") && more)        json = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && more)    baseline = argv[++i];
+        else if (!strcmp(argv[i], "--max-regress") && more) max_regress = strtod(argv[++i], NULL);
+        else if (argv[i][0] != '-' && nimages < 64)         images[nimages++] = argv[i];
+        else { usage(argv[0]); return 2; }
+    }
+    if (!nimages || !budget || !repeat) { usage(argv[0]); return 2; }
+    if (jit && !jit_available()) fprintf(stderr, "bench: no JIT backend on this host, interpreting\n");
+
+    vmman_init(&g_vms);
+    char *base = baseline ? read_text(baseline) : NULL;
+    if (baseline && !base) fprintf(stderr, "bench: cannot read baseline %s\n", baseline);
+
+    bench_result_t res[64];
+    int rc = 0;
+
+    printf("%-14s %14s %10s %10s %10s %9s\n", "workload", "insns", "MIPS", "ns/insn", "rss KiB", "vs base");
+    for (unsigned i = 0; i < nimages; i++) {
+        res[i] = run_workload(images[i], budget, repeat, jit);
+        const bench_result_t *r = &res[i];
+
+        if (!r->ok) {
+            printf("%-14s %14s\n", r->name, "FAILED");
+            rc = 1;
+            continue;
+        }
+
+        const double ips = ips_of(r);
+        const double was = baseline_ips(base, r->name);
+        char delta[16] = "-";
+        if (was > 0.0) {
+            const double pct = 100.0 * (ips - was) / was;
+            snprintf(delta, sizeof(delta), "%+.1f%%", pct);
+            if (pct < -max_regress) rc = 1;
+        }
+        printf("%-14s %14llu %10.2f %10.3f %10llu %9s\n", r->name, (unsigned long long)r->retired,
+               ips / 1e6, (double)r->ns / (double)r->retired, (unsigned long long)r->rss_kb, delta);
+    }
+
+    if (json && !write_json(json, res, nimages, budget, jit)) {
+        fprintf(stderr, "bench: cannot write %s\n", json);
+        rc = 1;
+    }
+    free(base);
+    vmman_free(&g_vms);
+    if (rc && baseline) fprintf(stderr, "bench: failure or regression beyond %.1f%%\n", max_regress);
+    return rc;
+}
@@ -0,0 +1,89 @@
+; bench/boot_replay.asm - the shape of an MBR boot path, replayed
+;
+; What a boot sector does before handing off: set up a stack, relocate
+; itself to 0000:0600, print a banner through INT 10h teletype, "read"
+; sectors through INT 13h into a buffer and checksum them. The BIOS
+; services are small local stubs installed in the IVT: INT 10h writes
+; to COM1 (an I/O exit, as in the real shim), INT 13h fills the buffer
+; with REP STOSW. Then it starts over.
+
+bits 16
+org 0x7C00
+
+RELOC   equ 0x0600
+BUFFER  equ 0x8000
+SECTORS equ 4
+
+start:
+    cli
+    mov sp, 0x7C00
+    sti
+    cld
+
+    ; install the service stubs
+    mov di, 0x10 * 4
+    mov ax, int10
+    stosw
+    xor ax, ax
+    stosw
+    mov di, 0x13 * 4
+    mov ax, int13
+    stosw
+    xor ax, ax
+    stosw
+
+    ; relocate the sector
+    mov si, 0x7C00
+    mov di, RELOC
+    mov cx, 256
+    rep movsw
+
+    ; banner
+    mov si, banner
+.print:
+    lodsb
+    test al, al
+    jz .read
+    and ax, 0x00FF
+    or  ax, 0x0E00
+    int 0x10
+    jmp .print
+
+    ; read and checksum
+.read:
+    mov dx, SECTORS
+.sector:
+    int 0x13
+    mov si, BUFFER
+    mov cx, 256
+    xor bx, bx
+.sum:
+    lodsw
+    add bx, ax
+    adc bx, 0
+    loop .sum
+    dec dx
+    jnz .sector
+    jmp start
+
+int10:                      ; AL = character
+    push dx
+    mov dx, 0x3F8
+    out dx, al
+    pop dx
+    iret
+
+int13:                      ; fill one 512-byte sector at BUFFER
+    push di
+    push cx
+    mov di, BUFFER
+    xor ax, ax              ; fill word = sectors left
+    add ax, dx
+    mov cx, 256
+    rep stosw
+    pop cx
+    pop di
+    iret
+
+banner:
+    db "boot", 13, 10, 0
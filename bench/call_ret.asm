@@ -0,0 +1,37 @@
+; bench/call_ret.asm - CALL/RET-heavy code: three-deep call chains
+
+bits 16
+org 0x7C00
+
+start:
+    mov sp, 0xFFFE
+    mov cx, 500
+.inner:
+    call leaf_a
+    call mid
+    call leaf_b
+    dec cx
+    jnz .inner
+    jmp start
+
+mid:
+    push cx
+    call leaf_a
+    call deep
+    pop cx
+    ret
+
+deep:
+    call leaf_b
+    add ax, 1
+    ret
+
+leaf_a:
+    add ax, cx
+    ret
+
+leaf_b:
+    push bx
+    xor bx, ax
+    pop bx
+    ret 0
@@ -0,0 +1,40 @@
+; bench/int_loop.asm - software interrupt round trips (INT/IRET)
+;
+; Points vectors 30h/31h at local handlers (STOSW into the IVT at
+; 0000:0000, ES=0), then calls them in a loop.
+
+bits 16
+org 0x7C00
+
+start:
+    cld
+    mov di, 0x30 * 4
+    mov ax, handler30
+    stosw
+    xor ax, ax
+    stosw
+    mov ax, handler31
+    stosw
+    xor ax, ax
+    stosw
+
+.outer:
+    mov cx, 1000
+.inner:
+    int 0x30
+    int 0x31
+    dec cx
+    jnz .inner
+    jmp .outer
+
+handler30:
+    add ax, 1
+    iret
+
+handler31:
+    push bx
+    xor bx, bx
+    add bx, ax
+    sub bx, 3
+    pop bx
+    iret
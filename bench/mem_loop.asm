@@ -0,0 +1,30 @@
+; bench/mem_loop.asm - ModRM memory operands over a 4 KiB table
+;
+; Mixes the common EA forms ([bx+si], [bp+di+disp8], [disp16],
+; [si+disp16]) in read-modify-write and load-op shapes.
+
+bits 16
+org 0x7C00
+
+TABLE equ 0x4000
+
+start:
+    mov bx, TABLE
+    mov bp, TABLE
+    xor si, si
+    xor di, di
+    mov cx, 2048
+.inner:
+    add [bx+si], ax
+    xor ax, [bx+si+2]
+    sub word [bp+di+8], 1
+    adc dx, [TABLE+0x10]
+    cmp byte [si+TABLE+1], 0x7F
+    or  [bx+di], dx
+    add si, 2
+    and si, 0x0FFE
+    add di, 6
+    and di, 0x0FFE
+    dec cx
+    jnz .inner
+    jmp start
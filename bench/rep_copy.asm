@@ -0,0 +1,36 @@
+; bench/rep_copy.asm - bulk REP string operations
+;
+; 16 KiB forward copy, backward fill, and a compare over equal
+; buffers. The harness counts each REP dispatch as one instruction,
+; so compare this workload against itself rather than the others.
+
+bits 16
+org 0x7C00
+
+SRC equ 0x4000
+DST equ 0x8000
+
+start:
+    cld
+    mov si, SRC
+    mov di, DST
+    mov cx, 0x2000
+    rep movsw
+
+    std
+    mov di, SRC + 0x3FFE
+    mov ax, 0x5AA5
+    mov cx, 0x2000
+    rep stosw
+
+    cld
+    mov si, SRC
+    mov di, SRC
+    mov cx, 0x2000
+    repe cmpsw
+
+    mov di, DST
+    mov al, 0xFF
+    mov cx, 0x4000
+    repne scasb
+    jmp start
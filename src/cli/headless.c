@@ -0,0 +1,131 @@
+// src/cli/headless.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vm/vm.h"
+#include "vm/vga.h"
+#include "cli/headless.h"
+
+#define BOOT_ADDR   0x7C00u
+#define BOOT_SECTOR 512u
+
+/* -----------------------------------------------------------------------------
+   image loading
+----------------------------------------------------------------------------- */
+
+/* Copy up to `max` bytes of `path` (0: the whole file) to RAM at `addr` */
+static bool load_image(VM *vm, const char *path, uint32_t addr, size_t max) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "error: cannot open %s\n", path);
+        return false;
+    }
+
+    size_t room = addr < vm->mem_size ? vm->mem_size - addr : 0;
+    if (max && max < room) room = max;
+
+    size_t n = room ? fread(vm->mem + addr, 1, room, f) : 0;
+    bool   ok = n > 0 && (max || fgetc(f) == EOF);
+    fclose(f);
+
+    if (!ok) fprintf(stderr, "error: %s does not fit at %05X\n", path, (unsigned)addr);
+    return ok;
+}
+
+/* -----------------------------------------------------------------------------
+   run
+----------------------------------------------------------------------------- */
+
+void headless_defaults(headless_opts_t *o) {
+    memset(o, 0, sizeof(*o));
+    o->boot      = HEADLESS_BOOT_IMG;
+    o->load_addr = 0x1000u;
+    o->ip        = 0x1000u;
+    o->max_steps = HEADLESS_MAX_STEPS;
+    o->ram       = HEADLESS_RAM;
+}
+
+int headless_run(const headless_opts_t *o) {
+    // VMs live in heap slabs; the manager is only a few pointers
+    VMManager vmman;
+    vmman_init(&vmman);
+
+    int id = vm_create_default(&vmman, o->ram, "headless");
+    if (id < 0) {
+        vmman_free(&vmman);
+        fprintf(stderr, "error: cannot create VM with %zu bytes of RAM\n", o->ram);
+        return 2;
+    }
+    VM *vm = vm_get(&vmman, id);
+
+    bool ok;
+    if (o->bin) {
+        ok = load_image(vm, o->bin, o->load_addr, 0);
+        vm->cpu.cs = o->cs;
+        vm->cpu.ip = o->ip;
+        vm->cpu.ds = o->ds;
+        vm->cpu.es = o->es;
+        vm->cpu.ss = o->ss;
+    } else {
+        ok = load_image(vm, o->boot, BOOT_ADDR, BOOT_SECTOR);
+        vm->cpu.cs = 0;
+        vm->cpu.ip = (uint16_t)BOOT_ADDR;
+        vm->cpu.dx = 0;                 // DL = boot drive A:
+    }
+    vm_code_flush(vm);                  // loaded straight into RAM
+
+    if (ok && o->vga && !vga_attach(vm)) {
+        fprintf(stderr, "error: cannot map the VGA text window\n");
+        ok = false;
+    }
+    if (ok && o->jit && !vm_set_jit(vm, true))
+        fprintf(stderr, "warning: JIT not available on this host, interpreting\n");
+    if (!ok) {
+        vmman_free(&vmman);
+        return 2;
+    }
+
+    vm_exit_t x = {0};
+    uint64_t done = 0;
+
+    while (done < o->max_steps) {
+        vm_run(vm, o->max_steps - done, &x);
+        done += x.retired;
+
+        if (x.reason != VM_EXIT_IO) {
+            if (x.reason != VM_EXIT_BUDGET) break;
+            continue;
+        }
+        // COM1 transmit is the guest's console, as in the REPL
+        if (!x.io_in && x.port == 0x3F8) fputc((int)(x.io_value & 0xFFu), stdout);
+    }
+
+    const x86_cpu_t *c = &vm->cpu;
+    const bool err = (x.reason == VM_EXIT_FAULT);
+    printf("HALT=%d ERR=%d AX=%04x BX=%04x CX=%04x DX=%04x CS:IP=%04X:%04X\n",
+           c->halted ? 1 : 0, err ? 1 : 0, c->ax, c->bx, c->cx, c->dx, c->cs, c->ip);
+    if (vm->vga) vga_dump(vm->vga, stdout);
+
+    vmman_free(&vmman);
+    return err ? 1 : 0;
+}
@@ -0,0 +1,60 @@
+// src/cli/headless.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Non-interactive runner behind the command-line flags:
+ *
+ *   x64-vm --bin prog.bin --load-addr 0x1000 --cs 0 --ip 0x1000 --max-steps 32
+ *
+ * One VM with just the requested RAM, no session or prompt; the image
+ * runs until HLT, a fault or the step budget and a single summary line
+ *
+ *   HALT=1 ERR=0 AX=beef BX=0000 CX=0000 DX=0000 CS:IP=0000:1004
+ *
+ * goes to stdout. Without --bin the first sector of the boot image
+ * (floopy.img by default) is loaded at 0000:7C00 and started there.
+ * With --vga the B800 text window is attached (vm/vga.h) and the
+ * screen is printed after the summary line.
+ */
+
+#define HEADLESS_BOOT_IMG   "floopy.img"
+#define HEADLESS_RAM        (1u << 20)
+#define HEADLESS_MAX_STEPS  1000000u
+
+typedef struct headless_opts {
+    const char *bin;        /* NULL: boot from `boot` */
+    const char *boot;       /* boot image (HEADLESS_BOOT_IMG) */
+    uint32_t    load_addr;  /* linear address for `bin` */
+    uint16_t    cs, ip;
+    uint16_t    ds, es, ss; /* --bin only */
+    uint64_t    max_steps;
+    size_t      ram;        /* bytes of guest RAM */
+    bool        jit;
+    bool        vga;        /* attach the text window, print it at exit */
+} headless_opts_t;
+
+void headless_defaults(headless_opts_t *o);
+
+/* process exit code: 0 ok, 1 guest error, 2 setup failure */
+int headless_run(const headless_opts_t *o);
@@ -25,6 +25,9 @@
 #include <stdbool.h>
 
 #include "vm/vm.h"
+#include "vm/snapshot.h"
+#include "vm/sched.h"
+#include "vm/vga.h"
 #include "cli/repl.h"
 #include "version.h"
 #include "cpu/x86_cpu.h"   // x86_cpu_t, x86_init, x86_step, x86_status_t, X86_OK, etc.
@@ -40,8 +43,11 @@ struct repl_state {
     char img_path[512];          // kept for future (boot/disk)
     uint32_t default_max_steps;
 
-    bool trace;
+    unsigned trace;              // TRACE_* tier applied to the VM on run
+    bool jit;                    // new VMs get the JIT tier (--jit)
     FILE *log;
+
+    sched_t *sched;              // worker pool, started by the first 'vm start'
 };
 
 // forward decalares
@@ -151,40 +157,48 @@ static size_t parse_memsize(const char *s, int *ok) {
    VM ensure - local
 ----------------------------------------------------------------------------- */
 
+/* Apply per-session VM options to a freshly created VM */
+static void setup_vm(repl_state_t *s, VM *vm) {
+    if (s->jit && !vm_set_jit(vm, true))
+        fprintf(stderr, "warning: JIT not available on this host, interpreting\n");
+}
+
+/* A VM the scheduler is running belongs to its workers until paused */
+static bool vm_busy(repl_state_t *s, int id) {
+    if (!sched_running(s->sched, id)) return false;
+    fprintf(stderr, "vm %d is running (vm pause %d first)\n", id, id);
+    return true;
+}
+
+/* The current VM, if there is one and it is not running in the background */
+static VM *current_idle(repl_state_t *s) {
+    VM *v = vm_current(&s->vmman);
+    if (!v) { fprintf(stderr, "no current vm\n"); return NULL; }
+    return vm_busy(s, v->id) ? NULL : v;
+}
+
+/* A VM named on the command line by id or by name; reports a miss */
+static VM *vm_arg(repl_state_t *s, const char *arg) {
+    char *end;
+    long id = strtol(arg, &end, 10);
+    VM *v = (*arg && !*end) ? vm_get(&s->vmman, (int)id) : vm_find(&s->vmman, arg);
+    if (!v) fprintf(stderr, "no such vm: %s\n", arg);
+    return v;
+}
+
 /* Compatibility mode: auto-create default vm on first CPU/mem command */
 static VM *ensure_vm(repl_state_t *s) {
     VM *v = vm_current(&s->vmman);
-    if (v) return v;
+    if (v) return vm_busy(s, v->id) ? NULL : v;
 
     int id = vm_create_default(&s->vmman, 128u*1024u*1024u, "default");
     if (id < 0) {
         fprintf(stderr, "error: failed to create default VM\n");
         return NULL;
     }
-    return vm_current(&s->vmman);
-}
-
-/* -----------------------------------------------------------------------------
-   load helpers
------------------------------------------------------------------------------ */
-
-static int load_file_to_mem(uint8_t *mem, size_t mem_size, const char *path, uint32_t load_addr) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return 0;
-
-    if (fseek(f, 0, SEEK_END) != 0) { fclose(f); return 0; }
-    long len = ftell(f);
-    if (len < 0) { fclose(f); return 0; }
-    if (fseek(f, 0, SEEK_SET) != 0) { fclose(f); return 0; }
-
-    if ((uint64_t)load_addr + (uint64_t)len > (uint64_t)mem_size) {
-        fclose(f);
-        return 0;
-    }
-
-    size_t n = fread(mem + load_addr, 1, (size_t)len, f);
-    fclose(f);
-    return n == (size_t)len;
+    v = vm_current(&s->vmman);
+    setup_vm(s, v);
+    return v;
 }
 
 /* -----------------------------------------------------------------------------
@@ -196,44 +210,78 @@ static void print_regs_vm(repl_state_t *s, const VM *vm) {
     printf("AX=%04X BX=%04X CX=%04X DX=%04X  SI=%04X DI=%04X BP=%04X SP=%04X\n",
            c->ax, c->bx, c->cx, c->dx, c->si, c->di, c->bp, c->sp);
     printf("CS=%04X IP=%04X DS=%04X ES=%04X SS=%04X  FLAGS=%04X\n",
-           c->cs, c->ip, c->ds, c->es, c->ss, c->flags);
+           c->cs, c->ip, c->ds, c->es, c->ss, x86_flags(c));
 		   
     // logfile (if open)
     if (s && s->log) {
         log_printf(s, "AX=%04X BX=%04X CX=%04X DX=%04X  SI=%04X DI=%04X BP=%04X SP=%04X",
                    c->ax, c->bx, c->cx, c->dx, c->si, c->di, c->bp, c->sp);
         log_printf(s, "CS=%04X IP=%04X DS=%04X ES=%04X SS=%04X  FLAGS=%04X",
-                   c->cs, c->ip, c->ds, c->es, c->ss, c->flags);
+                   c->cs, c->ip, c->ds, c->es, c->ss, x86_flags(c));
+    }
+}
+
+/* Service an I/O exit. Only COM1 transmit is modeled: bytes written to
+   0x3F8 go to stdout. Everything else reads as floating bus / is dropped. */
+static void service_io(repl_state_t *s, const vm_exit_t *x) {
+    if (!x->io_in && x->port == 0x3F8) {
+        fputc((int)(x->io_value & 0xFFu), stdout);
+        fflush(stdout);
+        log_printf(s, "COM1: %02X", (unsigned)(x->io_value & 0xFFu));
     }
 }
 
-static x86_status_t step_one_vm(repl_state_t *s, VM *vm) {
-    if (s->trace && s->log) {
-        uint32_t lin = x86_linear_addr(vm->cpu.cs, vm->cpu.ip);
-        uint8_t op = 0;
-        if (lin < vm->mem_size) op = vm->mem[lin];
-        fprintf(s->log, "%04X:%04X  %02X\n", vm->cpu.cs, vm->cpu.ip, op);
-        fflush(s->log);
-    }
-	exec_ctx_t e = {0};
-	e.cpu = &vm->cpu;
-	e.vm  = vm;          // gives fetch/memops access to VM-backed memory
-	return x86_step(&e);
+/* I/O exits of background VMs (worker threads, one at a time) */
+static void sched_io(void *opaque, int id, const vm_exit_t *x) {
+    (void)opaque;
+    (void)id;
+    if (!x->io_in && x->port == 0x3F8) {
+        fputc((int)(x->io_value & 0xFFu), stdout);
+        fflush(stdout);
+    }
+}
+
+static void print_sched(repl_state_t *s, int id) {
+    sched_info_t in;
+    sched_info(s->sched, id, &in);
+
+    const VM *vm = vm_get(&s->vmman, id);
+    const char *what = "idle";
+    switch (in.state) {
+        case VM_SCHED_PAUSED:  what = (in.last.reason == VM_EXIT_BREAKPOINT) ? "breakpoint" : "paused"; break;
+        case VM_SCHED_STOPPED: what = (in.last.reason == VM_EXIT_FAULT) ? "fault" : "halted"; break;
+        default: return;    // never started
+    }
+    // parked, so the CPU state is ours to read
+    printf("vm %d: %s at %04X:%04X, %llu instructions in %llu slices\n", id, what,
+           vm->cpu.cs, vm->cpu.ip, (unsigned long long)in.retired, (unsigned long long)in.slices);
 }
 
 static int run_steps_vm(repl_state_t *s, VM *vm, uint32_t max_steps) {
-    x86_status_t st = X86_OK;
-    for (uint32_t i = 0; i < max_steps; i++) {
-        st = step_one_vm(s, vm);
-        if (st == X86_HALT || st == X86_ERR) break;
+    vm_exit_t x = {0};
+    uint64_t done = 0;
+
+    // trace goes to the logfile if one is open (stderr otherwise)
+    vm->trace.flags = s->trace;
+    vm->trace.fp    = s->log;
+
+    while (done < max_steps) {
+        vm_run(vm, (uint64_t)(max_steps - done), &x);
+        done += x.retired;
+
+        if (x.reason == VM_EXIT_IO) { service_io(s, &x); continue; }
+        if (x.reason != VM_EXIT_BUDGET) break;
     }
 
+    if (x.reason == VM_EXIT_BREAKPOINT)
+        printf("breakpoint at %04X:%04X\n", x.cs, x.ip);
+
     printf("HALT=%d ERR=%d CS:IP=%04X:%04X\n",
            vm->cpu.halted ? 1 : 0,
-           (st == X86_ERR) ? 1 : 0,
+           (x.reason == VM_EXIT_FAULT) ? 1 : 0,
            vm->cpu.cs, vm->cpu.ip);
 
-    return (st == X86_ERR) ? 1 : 0;
+    return (x.reason == VM_EXIT_FAULT) ? 1 : 0;
 }
 
 /* -----------------------------------------------------------------------------
@@ -320,7 +368,10 @@ static int cmd_examine(VM *vm, uint16_t seg, uint16_t off, size_t count) {
 
         printf("%04X:%04X  ", seg, (uint16_t)(off + (uint16_t)i));
         for (size_t j = 0; j < n; j++) {
-            printf("%02X ", vm->mem[base + (uint32_t)i + (uint32_t)j]);
+            // through the memory map (clones share pages); no MMIO side effects
+            const uint8_t *h = mm_rd_ptr(&vm->mm, base + (uint32_t)(i + j));
+            if (h) printf("%02X ", *h);
+            else   printf("-- ");
         }
         printf("\n");
 
@@ -367,16 +418,31 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
     if (!strcmp(cmd, "help") || !strcmp(cmd, "?")) {
         printf("Commands:\n");
         printf("  logfile <path>\n");
-        printf("  set cpu debug=all|on|off\n");
+        printf("  set cpu debug=off|branch|insn|state|on|all\n");
         printf("  version\n");
         printf("  vm create [name] [ram]\n");
-        printf("  vm use <id>\n");
+        printf("  vm clone <vm> [name]  (copy-on-write RAM, same CPU state)\n");
+        printf("  vm use <vm>           (<vm>: id or name, newest of that name)\n");
         printf("  vm list\n");
-        printf("  vm destroy <id>\n");
-        printf("  load <bin> <seg:off>\n");
+        printf("  vm destroy <vm>\n");
+        printf("  vm reset [clear]      (clear: release all RAM, reads as zero)\n");
+        printf("  vm trim               (release resident all-zero RAM pages)\n");
+        printf("  vm save <file> [delta]  (delta: only pages written since the last save/load)\n");
+        printf("  vm load <file> [name] (new vm from a save-state, RAM mapped lazily)\n");
+        printf("  vm diff <snapA> <snapB>  (guest pages that differ)\n");
+        printf("  vm start <vm> [vm...] (run in the background on worker threads)\n");
+        printf("  vm pause <vm>\n");
+        printf("  vm wait               (until no vm is running)\n");
+        printf("  load <bin> <seg:off>  (page-aligned: shared copy-on-write with other vms)\n");
+        printf("  rom <bin> [seg:off]   (read-only, shared by all vms; default F000:0000)\n");
+        printf("  memmap\n");
+        printf("  vga [on]              (on: B800:0000 text window as MMIO; else print the screen)\n");
+        printf("  stats [on|off|reset|json]\n");
+        printf("  profile start [period] | stop | report [n] | map <file> [seg:off]\n");
         printf("  set <cs|ip|ds|es|ss|sp> <value>\n");
         printf("  regs\n");
         printf("  run [steps]\n");
+        printf("  break <seg:off> | break clear | break list\n");
         printf("  step [n]\n");
         printf("  quit\n");
         return 0;
@@ -392,6 +458,9 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
             fprintf(stderr, "usage: logfile <path>\n");
             return 1;
         }
+        // background VMs may be tracing into the current one
+        for (VM *v = vm_next(&s->vmman, NULL); v; v = vm_next(&s->vmman, v))
+            if (vm_busy(s, v->id)) return 1;
         if (s->log) { fclose(s->log); s->log = NULL; }
         s->log = fopen(argv[1], "w");
         if (!s->log) {
@@ -409,9 +478,18 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
 	}
 
     if (!strcmp(cmd, "set") && argc >= 3 && !strcmp(argv[1], "cpu")) {
-        if (!strcmp(argv[2], "debug=all") || !strcmp(argv[2], "debug=on")) { s->trace = true; return 0; }
-        if (!strcmp(argv[2], "debug=off")) { s->trace = false; return 0; }
-        fprintf(stderr, "usage: set cpu debug=all|on|off\n");
+        static const struct { const char *name; unsigned tier; } tiers[] = {
+            { "debug=off",    TRACE_OFF    },
+            { "debug=branch", TRACE_BRANCH },
+            { "debug=insn",   TRACE_INSN   },
+            { "debug=on",     TRACE_INSN   },
+            { "debug=state",  TRACE_STATE  },
+            { "debug=all",    TRACE_STATE  },
+        };
+        for (size_t i = 0; i < sizeof(tiers) / sizeof(tiers[0]); i++) {
+            if (!strcmp(argv[2], tiers[i].name)) { s->trace = tiers[i].tier; return 0; }
+        }
+        fprintf(stderr, "usage: set cpu debug=off|branch|insn|state (on=insn, all=state)\n");
         return 1;
     }
 
@@ -422,7 +500,7 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
     }
 
     if (!strcmp(cmd, "vm")) {
-        if (argc < 2) { fprintf(stderr, "usage: vm <create|use|list|destroy> ...\n"); return 1; }
+        if (argc < 2) { fprintf(stderr, "usage: vm <create|clone|use|list|destroy|reset|trim|save|load|diff|start|pause|wait> ...\n"); return 1; }
 
         if (!strcmp(argv[1], "list")) {
             vm_list(&s->vmman);
@@ -439,19 +517,121 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
             }
             int id = vm_create_default(&s->vmman, ram, name);
             if (id < 0) { fprintf(stderr, "vm create failed\n"); return 1; }
+            setup_vm(s, vm_get(&s->vmman, id));
             printf("created vm id=%d (current)\n", id);
             return 0;
         }
-        if (!strcmp(argv[1], "use")) {
-            if (argc < 3) { fprintf(stderr, "usage: vm use <id>\n"); return 1; }
-            int id = atoi(argv[2]);
-            if (!vm_use(&s->vmman, id)) { fprintf(stderr, "no such vm id=%d\n", id); return 1; }
+        if (!strcmp(argv[1], "clone")) {
+            if (argc < 3) { fprintf(stderr, "usage: vm clone <id|name> [name]\n"); return 1; }
+            VM *from = vm_arg(s, argv[2]);
+            if (!from) return 1;
+            const int src = from->id;
+            if (vm_busy(s, src)) return 1;
+            int id = vm_clone(&s->vmman, src, (argc >= 4) ? argv[3] : NULL);
+            if (id < 0) { fprintf(stderr, "vm clone failed\n"); return 1; }
+            printf("cloned vm id=%d from id=%d (current)\n", id, src);
             return 0;
         }
+        if (!strcmp(argv[1], "use")) {
+            if (argc < 3) { fprintf(stderr, "usage: vm use <id|name>\n"); return 1; }
+            VM *vm = vm_arg(s, argv[2]);
+            return (vm && vm_use(&s->vmman, vm->id)) ? 0 : 1;
+        }
         if (!strcmp(argv[1], "destroy")) {
-            if (argc < 3) { fprintf(stderr, "usage: vm destroy <id>\n"); return 1; }
-            int id = atoi(argv[2]);
-            if (!vm_destroy(&s->vmman, id)) { fprintf(stderr, "no such vm id=%d\n", id); return 1; }
+            if (argc < 3) { fprintf(stderr, "usage: vm destroy <id|name>\n"); return 1; }
+            VM *vm = vm_arg(s, argv[2]);
+            if (!vm || vm_busy(s, vm->id)) return 1;
+            vm_destroy(&s->vmman, vm->id);
+            return 0;
+        }
+
+        if (!strcmp(argv[1], "reset")) {
+            VM *vm = current_idle(s);
+            if (!vm) return 1;
+            const bool clear = (argc >= 3 && !strcmp(argv[2], "clear"));
+            if (argc >= 3 && !clear) { fprintf(stderr, "usage: vm reset [clear]\n"); return 1; }
+            vm_reset(vm, clear);
+            return 0;
+        }
+        if (!strcmp(argv[1], "trim")) {
+            VM *vm = current_idle(s);
+            if (!vm) return 1;
+            size_t freed = vm_ram_trim(vm);
+            printf("released %zu KiB, resident %zu KiB\n", freed / 1024u, vm_ram_resident(vm) / 1024u);
+            return 0;
+        }
+
+        if (!strcmp(argv[1], "save")) {
+            const bool delta = (argc >= 4 && !strcmp(argv[3], "delta"));
+            if (argc < 3 || (argc >= 4 && !delta)) { fprintf(stderr, "usage: vm save <file> [delta]\n"); return 1; }
+            VM *vm = current_idle(s);
+            if (!vm) return 1;
+            if (!delta) {
+                if (!vm_save(vm, argv[2])) { fprintf(stderr, "vm save failed: %s\n", argv[2]); return 1; }
+                return 0;
+            }
+            if (!vm->snap_id) { fprintf(stderr, "no parent snapshot: save or load a full one first\n"); return 1; }
+            const size_t dirty = vm_dirty_count(vm);
+            if (!vm_save_delta(vm, argv[2])) { fprintf(stderr, "vm save failed: %s\n", argv[2]); return 1; }
+            printf("saved %zu dirty pages\n", dirty);
+            return 0;
+        }
+        if (!strcmp(argv[1], "load")) {
+            if (argc < 3) { fprintf(stderr, "usage: vm load <file> [name]\n"); return 1; }
+            int id = vm_restore(&s->vmman, argv[2], (argc >= 4) ? argv[3] : NULL);
+            if (id < 0) { fprintf(stderr, "vm load failed: %s\n", argv[2]); return 1; }
+            setup_vm(s, vm_get(&s->vmman, id));
+            printf("loaded vm id=%d (current)\n", id);
+            return 0;
+        }
+
+        if (!strcmp(argv[1], "start")) {
+            if (argc < 3) { fprintf(stderr, "usage: vm start <id|name> [...]\n"); return 1; }
+            if (!s->sched) {
+                s->sched = sched_create(&s->vmman, 0);
+                if (!s->sched) { fprintf(stderr, "cannot start worker threads\n"); return 1; }
+                sched_set_io(s->sched, sched_io, s);
+            }
+            int rc = 0;
+            for (int i = 2; i < argc; i++) {
+                VM *vm = vm_arg(s, argv[i]);
+                if (!vm) { rc = 1; continue; }
+                const int id = vm->id;
+                if (!sched_running(s->sched, id)) {
+                    vm->trace.flags = s->trace;
+                    vm->trace.fp    = s->log;
+                }
+                sched_start(s->sched, id);
+            }
+            return rc;
+        }
+        if (!strcmp(argv[1], "pause")) {
+            if (argc < 3) { fprintf(stderr, "usage: vm pause <id|name>\n"); return 1; }
+            VM *vm = vm_arg(s, argv[2]);
+            if (!vm) return 1;
+            const int id = vm->id;
+            if (!s->sched || !sched_pause(s->sched, id)) { fprintf(stderr, "vm %d is not running\n", id); return 1; }
+            print_sched(s, id);
+            return 0;
+        }
+        if (!strcmp(argv[1], "wait")) {
+            if (!s->sched) return 0;
+            sched_wait(s->sched);
+            for (VM *vm = vm_next(&s->vmman, NULL); vm; vm = vm_next(&s->vmman, vm))
+                print_sched(s, vm->id);
+
+            sched_stats_t st;
+            sched_get_stats(s->sched, &st);
+            printf("%u workers, %llu slices, %llu stolen\n", st.workers,
+                   (unsigned long long)st.slices, (unsigned long long)st.steals);
+            return 0;
+        }
+
+        if (!strcmp(argv[1], "diff")) {
+            if (argc < 4) { fprintf(stderr, "usage: vm diff <snapA> <snapB>\n"); return 1; }
+            long n = vm_snap_diff(argv[2], argv[3], stdout);
+            if (n < 0) { fprintf(stderr, "vm diff failed (unreadable or different RAM sizes)\n"); return 1; }
+            printf("%ld pages differ\n", n);
             return 0;
         }
 
@@ -469,14 +649,99 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
             fprintf(stderr, "load: bad address (use ssss:oooo)\n");
             return 1;
         }
-        uint32_t addr = x86_linear_addr(seg, off);
-        if (!load_file_to_mem(vm->mem, vm->mem_size, argv[1], addr)) {
+        // through the shared image store: other VMs loading the same
+        // file at a page-aligned address share its pages copy-on-write
+        img_t *img = img_open(argv[1]);
+        bool ok = img && vm_load_image(vm, x86_linear_addr(seg, off), img);
+        img_release(img);
+        if (!ok) {
             fprintf(stderr, "load failed\n");
             return 1;
         }
         return 0;
     }
 
+    if (!strcmp(cmd, "rom")) {
+        if (argc < 2) { fprintf(stderr, "usage: rom <bin> [seg:off]\n"); return 1; }
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+
+        uint16_t seg = 0xF000, off = 0;
+        if (argc >= 3 && !parse_seg_off(argv[2], &seg, &off)) {
+            fprintf(stderr, "rom: bad address (use ssss:oooo)\n");
+            return 1;
+        }
+        img_t *img = img_open(argv[1]);
+        if (!img) { fprintf(stderr, "rom: cannot read %s\n", argv[1]); return 1; }
+
+        bool ok = vm_map_image(vm, x86_linear_addr(seg, off), img);
+        img_release(img);
+        if (!ok) { fprintf(stderr, "rom: map failed (page-aligned address inside RAM?)\n"); return 1; }
+        return 0;
+    }
+
+    if (!strcmp(cmd, "memmap")) {
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+        mm_dump(&vm->mm, stdout);
+        return 0;
+    }
+
+    if (!strcmp(cmd, "vga")) {
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+        if (argc >= 2) {
+            if (strcmp(argv[1], "on")) { fprintf(stderr, "usage: vga [on]\n"); return 1; }
+            if (!vga_attach(vm)) { fprintf(stderr, "vga: cannot map the text window\n"); return 1; }
+            return 0;
+        }
+        if (!vm->vga) { fprintf(stderr, "vga: not attached (vga on)\n"); return 1; }
+        vga_dump(vm->vga, stdout);
+        printf("(%llu writes)\n", (unsigned long long)vm->vga->writes);
+        return 0;
+    }
+
+    if (!strcmp(cmd, "stats")) {
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+        if (argc < 2)                       stats_print(&vm->stats, stdout);
+        else if (!strcmp(argv[1], "on"))    vm->stats.on = true;
+        else if (!strcmp(argv[1], "off"))   vm->stats.on = false;
+        else if (!strcmp(argv[1], "reset")) stats_reset(&vm->stats);
+        else if (!strcmp(argv[1], "json"))  stats_json(&vm->stats, stdout);
+        else { fprintf(stderr, "usage: stats [on|off|reset|json]\n"); return 1; }
+        return 0;
+    }
+
+    if (!strcmp(cmd, "profile")) {
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+        const char *sub = argc >= 2 ? argv[1] : "report";
+
+        if (!strcmp(sub, "start")) {
+            prof_start(&vm->prof, argc >= 3 ? strtoull(argv[2], NULL, 0) : 0);
+            return 0;
+        }
+        if (!strcmp(sub, "stop")) { prof_stop(&vm->prof); return 0; }
+        if (!strcmp(sub, "report")) {
+            prof_report(&vm->prof, stdout, argc >= 3 ? (unsigned)strtoul(argv[2], NULL, 0) : 20u);
+            return 0;
+        }
+        if (!strcmp(sub, "map") && argc >= 3) {
+            uint16_t seg = 0, off = 0;
+            if (argc >= 4 && !parse_seg_off(argv[3], &seg, &off)) {
+                fprintf(stderr, "profile: bad address (use ssss:oooo)\n");
+                return 1;
+            }
+            long n = prof_load_map(&vm->prof, argv[2], x86_linear_addr(seg, off));
+            if (n < 0) { fprintf(stderr, "profile: cannot read %s\n", argv[2]); return 1; }
+            printf("profile: %ld symbols\n", n);
+            return 0;
+        }
+        fprintf(stderr, "usage: profile start [period] | stop | report [n] | map <file> [seg:off]\n");
+        return 1;
+    }
+
     if (!strcmp(cmd, "set")) {
         if (argc < 3) {
             fprintf(stderr, "usage: set <cs|ip|ds|es|ss|sp> <value>\n");
@@ -513,6 +778,23 @@ int exec_line(repl_state_t *s, const char *line_in, int depth) {
         return run_steps_vm(s, vm, n);
     }
 
+    if (!strcmp(cmd, "break") || !strcmp(cmd, "bp")) {
+        if (argc < 2) { fprintf(stderr, "usage: break <seg:off> | break clear | break list\n"); return 1; }
+        VM *vm = ensure_vm(s);
+        if (!vm) return 1;
+
+        if (!strcmp(argv[1], "clear")) { vm_break_clear(vm); return 0; }
+        if (!strcmp(argv[1], "list")) {
+            for (unsigned i = 0; i < vm->nbp; i++) printf("  %u: lin=%05X\n", i, (unsigned)vm->bp[i]);
+            return 0;
+        }
+
+        uint16_t seg = 0, off = 0;
+        if (!parse_seg_off(argv[1], &seg, &off)) { fprintf(stderr, "break: bad address (use ssss:oooo)\n"); return 1; }
+        if (!vm_break_add(vm, x86_linear_addr(seg, off))) { fprintf(stderr, "break: table full\n"); return 1; }
+        return 0;
+    }
+
     if (!strcmp(cmd, "run")) {
         VM *vm = ensure_vm(s);
         if (!vm) return 1;
@@ -536,11 +818,11 @@ int repl(Session *sess) {
     repl_state_t s;
     memset(&s, 0, sizeof(s));
 	
-	(void)sess;   // suppress unused-parameter warning for now
-
     vmman_init(&s.vmman);
+    s.jit = sess ? sess->jit : false;
 
-    s.trace = false; // script can enable via: set cpu debug=all
+    s.trace = TRACE_OFF; // script can enable via: set cpu debug=all
+    s.default_max_steps = 1000000u;   // 'run' with no count
     s.log = NULL;
 
     char line[1024];
@@ -558,11 +840,11 @@ int repl(Session *sess) {
         if (rc == 99) break;
     }
 
+    // workers first: they may still be running VMs
+    sched_destroy(s.sched);
+
     if (s.log) fclose(s.log);
 
-    // destroy all vms
-    for (int i = 0; i < VM_MAX; i++) {
-        if (s.vmman.vms[i].in_use) vm_destroy(&s.vmman, i);
-    }
+    vmman_free(&s.vmman);
     return 0;
 }
\ No newline at end of file
@@ -82,6 +82,7 @@ void session_init(Session *s) {
     s->vm  = NULL;
 
     s->debug_flags = 0;
+    s->jit         = false;
     s->last_status = 0;
 }
 
@@ -70,6 +70,7 @@ typedef struct Session {
 
     /* Misc user-context knobs */
     unsigned debug_flags;     /* CLI-level debug flags (not CPU flags) */
+    bool     jit;             /* --jit: new VMs get the translator tier */
     int      last_status;     /* last command status code */
 } Session;
 
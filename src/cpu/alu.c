@@ -0,0 +1,362 @@
+// src/cpu/alu.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cpu/alu.h"
+#include "cpu/x86_cpu.h"
+#include "cpu/decode.h"
+#include "cpu/memops.h"
+
+/* ============================================================
+ * Register file access
+ *
+ * ModRM register numbers map to struct offsets through a table, so
+ * operand fetch and writeback are loads and stores with no switch.
+ * 8-bit registers 4-7 are the high halves of 0-3.
+ * ============================================================ */
+
+static const uint8_t reg16_off[8] = {
+    offsetof(x86_cpu_t, ax), offsetof(x86_cpu_t, cx),
+    offsetof(x86_cpu_t, dx), offsetof(x86_cpu_t, bx),
+    offsetof(x86_cpu_t, sp), offsetof(x86_cpu_t, bp),
+    offsetof(x86_cpu_t, si), offsetof(x86_cpu_t, di)
+};
+
+static inline uint16_t *r16(x86_cpu_t *c, unsigned reg)
+{
+    return (uint16_t*)((uint8_t*)c + reg16_off[reg & 7u]);
+}
+
+static inline uint8_t get_r8(x86_cpu_t *c, unsigned reg)
+{
+    return (uint8_t)(*r16(c, reg & 3u) >> ((reg & 4u) << 1));
+}
+
+static inline void set_r8(x86_cpu_t *c, unsigned reg, uint8_t v)
+{
+    uint16_t *r = r16(c, reg & 3u);
+    const unsigned sh = (reg & 4u) << 1;
+    *r = (uint16_t)((*r & ~(0xFFu << sh)) | ((unsigned)v << sh));
+}
+
+/* ============================================================
+ * Kernels: compute the result and record the lazy flags.
+ * ADC/SBB fold the carry in; the ADD/SUB carry vectors in flags.c
+ * come out right with it included.
+ * ============================================================ */
+
+typedef uint16_t (*alu_kernel_t)(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s);
+
+static inline uint16_t alu_add(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d + s);
+    x86_lazy_flags(c, X86_LF_ADD, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_or(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d | s);
+    x86_lazy_flags(c, X86_LF_LOGIC, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_adc(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d + s + (uint16_t)x86_flag(c, X86_FL_CF));
+    x86_lazy_flags(c, X86_LF_ADD, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_sbb(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d - s - (uint16_t)x86_flag(c, X86_FL_CF));
+    x86_lazy_flags(c, X86_LF_SUB, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_and(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d & s);
+    x86_lazy_flags(c, X86_LF_LOGIC, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_sub(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d - s);
+    x86_lazy_flags(c, X86_LF_SUB, w, d, s, r);
+    return r;
+}
+
+static inline uint16_t alu_xor(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    const uint16_t r = (uint16_t)(d ^ s);
+    x86_lazy_flags(c, X86_LF_LOGIC, w, d, s, r);
+    return r;
+}
+
+// CMP is SUB without writeback (the form drops the result)
+static inline uint16_t alu_cmp(x86_cpu_t *c, uint8_t w, uint16_t d, uint16_t s)
+{
+    return alu_sub(c, w, d, s);
+}
+
+/* ============================================================
+ * Operand forms
+ *
+ * One inline body per form; each generated handler passes a constant
+ * kernel and writeback flag, so the compiler folds both away.
+ *   E = ModRM r/m, G = ModRM reg, A = AL/AX, I = immediate
+ *   _r = r/m is a register (mod 3), _m = r/m is memory
+ * ============================================================ */
+
+static inline x86_status_t EbGb_r(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const unsigned rm = x86_modrm_rm(e->d), rg = x86_modrm_reg(e->d);
+    const uint8_t r = (uint8_t)k(c, 8, get_r8(c, rm), get_r8(c, rg));
+    if (wb) set_r8(c, rm, r);
+    return X86_OK;
+}
+
+static inline x86_status_t EbGb_m(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint8_t v;
+    if (!x86_read8(e, seg, off, &v)) return X86_FAULT;
+    const uint8_t r = (uint8_t)k(c, 8, v, get_r8(c, x86_modrm_reg(e->d)));
+    return (!wb || x86_write8(e, seg, off, r)) ? X86_OK : X86_FAULT;
+}
+
+static inline x86_status_t EwGw_r(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t *d = r16(c, x86_modrm_rm(e->d));
+    const uint16_t r = k(c, 16, *d, *r16(c, x86_modrm_reg(e->d)));
+    if (wb) *d = r;
+    return X86_OK;
+}
+
+static inline x86_status_t EwGw_m(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint16_t v;
+    if (!x86_read16(e, seg, off, &v)) return X86_FAULT;
+    const uint16_t r = k(c, 16, v, *r16(c, x86_modrm_reg(e->d)));
+    return (!wb || x86_write16(e, seg, off, r)) ? X86_OK : X86_FAULT;
+}
+
+static inline x86_status_t GbEb_r(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const unsigned rm = x86_modrm_rm(e->d), rg = x86_modrm_reg(e->d);
+    const uint8_t r = (uint8_t)k(c, 8, get_r8(c, rg), get_r8(c, rm));
+    if (wb) set_r8(c, rg, r);
+    return X86_OK;
+}
+
+static inline x86_status_t GbEb_m(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const unsigned rg = x86_modrm_reg(e->d);
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint8_t v;
+    if (!x86_read8(e, seg, off, &v)) return X86_FAULT;
+    const uint8_t r = (uint8_t)k(c, 8, get_r8(c, rg), v);
+    if (wb) set_r8(c, rg, r);
+    return X86_OK;
+}
+
+static inline x86_status_t GwEw_r(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t *d = r16(c, x86_modrm_reg(e->d));
+    const uint16_t r = k(c, 16, *d, *r16(c, x86_modrm_rm(e->d)));
+    if (wb) *d = r;
+    return X86_OK;
+}
+
+static inline x86_status_t GwEw_m(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t *d = r16(c, x86_modrm_reg(e->d));
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint16_t v;
+    if (!x86_read16(e, seg, off, &v)) return X86_FAULT;
+    const uint16_t r = k(c, 16, *d, v);
+    if (wb) *d = r;
+    return X86_OK;
+}
+
+static inline x86_status_t ALIb(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const uint8_t r = (uint8_t)k(c, 8, (uint8_t)c->ax, (uint8_t)e->d->imm);
+    if (wb) c->ax = (uint16_t)((c->ax & 0xFF00u) | r);
+    return X86_OK;
+}
+
+static inline x86_status_t AXIw(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const uint16_t r = k(c, 16, c->ax, (uint16_t)e->d->imm);
+    if (wb) c->ax = r;
+    return X86_OK;
+}
+
+static inline x86_status_t EbIb_r(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    const unsigned rm = x86_modrm_rm(e->d);
+    const uint8_t r = (uint8_t)k(c, 8, get_r8(c, rm), (uint8_t)e->d->imm);
+    if (wb) set_r8(c, rm, r);
+    return X86_OK;
+}
+
+static inline x86_status_t EbIb_m(exec_ctx_t *e, alu_kernel_t k, bool wb)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint8_t v;
+    if (!x86_read8(e, seg, off, &v)) return X86_FAULT;
+    const uint8_t r = (uint8_t)k(c, 8, v, (uint8_t)e->d->imm);
+    return (!wb || x86_write8(e, seg, off, r)) ? X86_OK : X86_FAULT;
+}
+
+static inline x86_status_t Ew_imm_r(exec_ctx_t *e, alu_kernel_t k, bool wb, uint16_t imm)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t *d = r16(c, x86_modrm_rm(e->d));
+    const uint16_t r = k(c, 16, *d, imm);
+    if (wb) *d = r;
+    return X86_OK;
+}
+
+static inline x86_status_t Ew_imm_m(exec_ctx_t *e, alu_kernel_t k, bool wb, uint16_t imm)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t seg;
+    const uint16_t off = x86_modrm_ea(c, e->d, &seg);
+    uint16_t v;
+    if (!x86_read16(e, seg, off, &v)) return X86_FAULT;
+    const uint16_t r = k(c, 16, v, imm);
+    return (!wb || x86_write16(e, seg, off, r)) ? X86_OK : X86_FAULT;
+}
+
+// 81 /r: imm16; 83 /r: imm8 sign-extended to 16 bits
+#define IMM16(e)  ((uint16_t)(e)->d->imm)
+#define SIMM8(e)  ((uint16_t)(int16_t)(int8_t)(e)->d->imm)
+
+static inline x86_status_t EwIw_r(exec_ctx_t *e, alu_kernel_t k, bool wb) { return Ew_imm_r(e, k, wb, IMM16(e)); }
+static inline x86_status_t EwIw_m(exec_ctx_t *e, alu_kernel_t k, bool wb) { return Ew_imm_m(e, k, wb, IMM16(e)); }
+static inline x86_status_t EwIb_r(exec_ctx_t *e, alu_kernel_t k, bool wb) { return Ew_imm_r(e, k, wb, SIMM8(e)); }
+static inline x86_status_t EwIb_m(exec_ctx_t *e, alu_kernel_t k, bool wb) { return Ew_imm_m(e, k, wb, SIMM8(e)); }
+
+/* ============================================================
+ * Generated handlers: ALU_OPS x ALU_FORMS
+ * ============================================================ */
+
+/* op (in /digit and opcode bits 3-5 order), result written back */
+#define ALU_OPS(X)      \
+    X(add, true)        \
+    X(or,  true)        \
+    X(adc, true)        \
+    X(sbb, true)        \
+    X(and, true)        \
+    X(sub, true)        \
+    X(xor, true)        \
+    X(cmp, false)
+
+/* form, in alu_form_t order */
+#define ALU_FORMS(X, op, wb) \
+    X(op, wb, EbGb_r) X(op, wb, EbGb_m) \
+    X(op, wb, EwGw_r) X(op, wb, EwGw_m) \
+    X(op, wb, GbEb_r) X(op, wb, GbEb_m) \
+    X(op, wb, GwEw_r) X(op, wb, GwEw_m) \
+    X(op, wb, ALIb)   X(op, wb, AXIw)   \
+    X(op, wb, EbIb_r) X(op, wb, EbIb_m) \
+    X(op, wb, EwIw_r) X(op, wb, EwIw_m) \
+    X(op, wb, EwIb_r) X(op, wb, EwIb_m)
+
+typedef enum alu_form {
+    ALU_EbGb = 0,   // 00: r/m8, r8     (+1 for memory)
+    ALU_EwGw = 2,   // 01: r/m16, r16
+    ALU_GbEb = 4,   // 02: r8, r/m8
+    ALU_GwEw = 6,   // 03: r16, r/m16
+    ALU_ALIb = 8,   // 04: AL, imm8
+    ALU_AXIw = 9,   // 05: AX, imm16
+    ALU_EbIb = 10,  // 80/82 /r
+    ALU_EwIw = 12,  // 81 /r
+    ALU_EwIb = 14,  // 83 /r (imm8 sign-extended)
+    ALU_NFORMS = 16
+} alu_form_t;
+
+#define ALU_DEFINE(op, wb, form) \
+    static x86_status_t alu_##op##_##form(exec_ctx_t *e) { return form(e, alu_##op, wb); }
+#define ALU_DEFINE_OP(op, wb) ALU_FORMS(ALU_DEFINE, op, wb)
+ALU_OPS(ALU_DEFINE_OP)
+
+#define ALU_ENTRY(op, wb, form) alu_##op##_##form,
+#define ALU_ROW(op, wb) { ALU_FORMS(ALU_ENTRY, op, wb) },
+static const x86_fn_t alu_fn[8][ALU_NFORMS] = {
+    ALU_OPS(ALU_ROW)
+};
+
+#undef ALU_DEFINE
+#undef ALU_DEFINE_OP
+#undef ALU_ENTRY
+#undef ALU_ROW
+
+/* ============================================================
+ * Selection
+ * ============================================================ */
+
+x86_fn_t x86_alu_select(const x86_decoded_t *d)
+{
+    const unsigned mem = x86_modrm_mod(d) != 3u;
+
+    switch (d->op) {
+        case 0x80:
+        case 0x82: return alu_fn[x86_modrm_reg(d)][ALU_EbIb + mem];
+        case 0x81: return alu_fn[x86_modrm_reg(d)][ALU_EwIw + mem];
+        case 0x83: return alu_fn[x86_modrm_reg(d)][ALU_EwIb + mem];
+        default:   break;
+    }
+
+    const unsigned op = (d->op >> 3) & 7u;
+    const unsigned lo = d->op & 7u;
+
+    // 04/05 carry no ModRM; the rest are r/m forms 0-3
+    return alu_fn[op][lo >= 4u ? ALU_ALIb + (lo - 4u) : lo * 2u + mem];
+}
+
+x86_status_t op_alu(exec_ctx_t *e)
+{
+    return x86_alu_select(e->d)(e);
+}
@@ -0,0 +1,41 @@
+// src/cpu/alu.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+#include "cpu/decode.h"
+
+/*
+ * Two-operand ALU family: ADD OR ADC SBB AND SUB XOR CMP.
+ *
+ * Covers opcodes 00-3D (the op is bits 3-5 of the opcode, the form its
+ * low three bits) and group 1 at 80-83 (op in ModRM.reg). Every
+ * op x width x operand form has its own handler, generated in alu.c;
+ * x86_decode() calls x86_alu_select() for rows flagged X86_OPF_ALU, so
+ * the width/register-or-memory choice is made once per decode instead
+ * of on every execution.
+ */
+
+// Specialized handler for a decoded ALU instruction (never NULL)
+x86_fn_t x86_alu_select(const x86_decoded_t *d);
+
+// Table placeholder for ALU rows: selects and runs (only reached if a
+// caller dispatches through x86_optab without decoding)
+x86_status_t op_alu(exec_ctx_t *e);
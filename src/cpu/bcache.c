@@ -0,0 +1,215 @@
+// src/cpu/bcache.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu/bcache.h"
+#include "cpu/table.h"
+#include "cpu/x86_cpu.h"
+#include "cpu/execute.h"
+#include "cpu/decode.h"
+#include "cpu/fuse.h"
+#include "vm/vm.h"      // vm_note_code(), vm->stats
+
+/* ============================================================
+ * lifecycle
+ * ============================================================ */
+
+bool bcache_init(bcache_t *bc)
+{
+    memset(bc, 0, sizeof(*bc));
+
+    bc->blocks = (bc_block_t*)calloc(BC_SLOTS, sizeof(bc_block_t));
+    return bc->blocks != NULL;
+}
+
+void bcache_free(bcache_t *bc)
+{
+    if (!bc) return;
+    free(bc->blocks);
+    memset(bc, 0, sizeof(*bc));
+}
+
+void bcache_flush(bcache_t *bc)
+{
+    if (!bc || !bc->blocks) return;
+    for (size_t i = 0; i < BC_SLOTS; i++) bc->blocks[i].valid = false;
+    bc->gen++;
+}
+
+void bcache_invalidate_page(bcache_t *bc, uint32_t page)
+{
+    const uint32_t lo = page << BC_PAGE_SHIFT;
+    const uint32_t hi = lo + (1u << BC_PAGE_SHIFT);
+
+    for (size_t i = 0; i < BC_SLOTS; i++) {
+        bc_block_t *b = &bc->blocks[i];
+        if (!b->valid) continue;
+        if (b->lin < hi && b->lin_end > lo) {
+            b->valid = false;
+            bc->invalidations++;
+            bc->gen++;
+        }
+    }
+}
+
+/* ============================================================
+ * block builder
+ * ============================================================ */
+
+static inline size_t bc_slot(uint32_t lin)
+{
+    return (size_t)((lin ^ (lin >> 9)) & (BC_SLOTS - 1u));
+}
+
+static bc_block_t *bc_build(bcache_t *bc, exec_ctx_t *e, uint16_t cs, uint16_t ip, uint32_t lin)
+{
+    bc_block_t *b = &bc->blocks[bc_slot(lin)];
+
+    // live translated code may link straight into the block being
+    // evicted, and no later page write could reach it: drop it all now
+    if (b->jit && b->jit_epoch == bc->jit_epoch) bc->gen++;
+
+    b->valid = false;
+    b->cs = cs;
+    b->ip = ip;
+    b->lin = lin;
+    b->ninsns = 0;
+    b->execs = 0;
+    b->jit = NULL;
+    b->jit_fail = false;
+
+    uint16_t cur = ip;
+    while (b->ninsns < BC_MAX_INSNS) {
+        x86_decoded_t *in = &b->insn[b->ninsns];
+        if (!x86_decode(e, cs, cur, in)) break;
+
+        b->ninsns++;
+        uint16_t next = in->next_ip;
+        if (in->opflags & X86_OPF_BRANCH) { cur = next; break; }
+        if ((in->opflags & X86_OPF_STRING) && (in->pfx & (X86_PFX_REP | X86_PFX_REPNE))) {
+            cur = next;     // may yield with IP back on itself
+            break;
+        }
+        if (next < cur) { cur = next; break; }   // IP wraps: not linear any more
+        cur = next;
+    }
+
+    if (b->ninsns == 0) return NULL;
+
+    // every slot gets a match of its own: a group cut short by the budget
+    // falls back to single steps that may start a later group
+    for (unsigned i = 0; i < b->ninsns; i++) {
+        unsigned extra = 0;
+        b->fuse[i].fn = x86_fuse_match(&b->insn[i], b->ninsns - i, &extra);
+        b->fuse[i].extra = (uint8_t)extra;
+    }
+
+    b->lin_end = lin + (uint16_t)(cur - ip);
+    vm_note_code(e->vm, b->lin, b->lin_end);   // trap writes to these pages
+    b->valid = true;
+    return b;
+}
+
+/* ============================================================
+ * block executor
+ * ============================================================ */
+
+bc_block_t *bcache_lookup(exec_ctx_t *e, bcache_t *bc)
+{
+    const x86_cpu_t *c = e->cpu;
+    const uint32_t lin = x86_linear_addr(c->cs, c->ip);
+    bc_block_t *b = &bc->blocks[bc_slot(lin)];
+
+    if (b->valid && b->lin == lin && b->cs == c->cs && b->ip == c->ip) {
+        bc->hits++;
+        return b;
+    }
+    bc->misses++;
+    return bc_build(bc, e, c->cs, c->ip, lin);
+}
+
+bc_block_t *bcache_find(bcache_t *bc, uint16_t cs, uint16_t ip)
+{
+    const uint32_t lin = x86_linear_addr(cs, ip);
+    bc_block_t *b = &bc->blocks[bc_slot(lin)];
+    return (b->valid && b->lin == lin && b->cs == cs && b->ip == ip) ? b : NULL;
+}
+
+// in[0..extra] retired; a failure is booked on in[extra], which raised it
+static void bc_count(exec_ctx_t *e, const x86_decoded_t *in, unsigned extra, x86_status_t st)
+{
+    for (unsigned j = 0; j <= extra; j++)
+        stats_retire(&e->vm->stats, &in[j], j == extra ? st : X86_OK);
+}
+
+x86_status_t bcache_exec_block(exec_ctx_t *e, const bc_block_t *b, uint32_t budget, uint32_t *retired)
+{
+    x86_cpu_t *c = e->cpu;
+
+    uint32_t n = b->ninsns;
+    if (n > budget) n = budget;
+
+    for (uint32_t i = 0; i < n; ) {
+        const x86_decoded_t *in = &b->insn[i];
+        const bc_fuse_t *f = &b->fuse[i];
+        x86_status_t st;
+
+        e->d = in;
+        if (f->fn && i + f->extra < n) {
+            c->ip = in[f->extra].next_ip;
+            e->fused_done = f->extra;
+            st = f->fn(e);
+
+            // a faulting member ends the group (fn left IP past it)
+            const unsigned ran = e->fused_done;
+            if (e->vm->stats.on) bc_count(e, in, ran, st);
+            *retired += 1u + ran;
+            i += 1u + ran;
+        } else {
+            c->ip = in->next_ip;
+            st = in->fn(e);
+            if (e->vm->stats.on) bc_count(e, in, 0, st);
+            (*retired)++;
+            i++;
+        }
+
+        if (st != X86_OK) return st;
+        if (!b->valid) break;   // instruction rewrote its own block
+    }
+    return X86_OK;
+}
+
+x86_status_t bcache_run_block(exec_ctx_t *e, bcache_t *bc, uint32_t budget, uint32_t *retired)
+{
+    *retired = 0;
+
+    if (e->cpu->halted) return X86_HALT;
+    if (budget == 0) return X86_OK;
+
+    bc_block_t *b = bcache_lookup(e, bc);
+    if (!b) {
+        // Nothing decodable here: let the per-instruction path report it.
+        *retired = 1;
+        return cpu_execute(e);
+    }
+    return bcache_exec_block(e, b, budget, retired);
+}
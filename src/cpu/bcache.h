@@ -0,0 +1,103 @@
+// src/cpu/bcache.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+#include "cpu/decode.h"     // x86_decoded_t
+
+/*
+ * Decoded basic-block cache.
+ *
+ * A block is a straight run of pre-decoded instructions starting at a
+ * linear address and ending at the first X86_OPF_BRANCH instruction or
+ * REP string instruction (or BC_MAX_INSNS, or an undecodable byte). Blocks are looked up by linear
+ * CS:IP in a direct-mapped table. Every 4 KiB guest page that holds
+ * cached code is marked MM_PF_CODE in the VM's memory map, which moves
+ * writes to that page onto the slow path; the first such write drops
+ * the blocks overlapping it (see vm_write8_slow).
+ */
+
+#define BC_PAGE_SHIFT 12
+#define BC_MAX_INSNS  32
+
+#ifndef BC_SLOTS
+#define BC_SLOTS      512     // power of two
+#endif
+
+/* Superinstruction for the group starting at an insn[] slot (cpu/fuse.h) */
+typedef struct bc_fuse {
+    x86_fn_t fn;          // NULL: run insn[i] on its own
+    uint8_t  extra;       // following instructions covered by fn
+} bc_fuse_t;
+
+typedef struct bc_block {
+    bool      valid;
+    uint16_t  cs;
+    uint16_t  ip;
+    uint32_t  lin;        // linear address of the first byte
+    uint32_t  lin_end;    // one past the last byte
+    uint16_t  ninsns;
+
+    /* execution tier bookkeeping (src/jit); reset on every rebuild */
+    uint32_t  execs;      // times run by the interpreter
+    void     *jit;        // translated entry, valid while jit_epoch matches
+    uint32_t  jit_epoch;
+    bool      jit_fail;   // holds something the translator cannot do
+
+    x86_decoded_t insn[BC_MAX_INSNS];
+    bc_fuse_t     fuse[BC_MAX_INSNS];
+} bc_block_t;
+
+typedef struct bcache {
+    bc_block_t *blocks;      // BC_SLOTS entries
+    uint64_t    gen;         // bumped whenever blocks are dropped
+    uint32_t    jit_epoch;   // epoch of the live translations (set by src/jit)
+
+    uint64_t    hits, misses, invalidations;
+} bcache_t;
+
+bool bcache_init(bcache_t *bc);
+void bcache_free(bcache_t *bc);
+
+/* Drop everything (e.g. after a bulk load into guest RAM) */
+void bcache_flush(bcache_t *bc);
+
+/* Drop every block overlapping guest page 'page' */
+void bcache_invalidate_page(bcache_t *bc, uint32_t page);
+
+/* Block at the current CS:IP, decoding it on a miss (NULL: undecodable) */
+bc_block_t *bcache_lookup(exec_ctx_t *e, bcache_t *bc);
+
+/* Cached block at cs:ip, or NULL; never decodes */
+bc_block_t *bcache_find(bcache_t *bc, uint16_t cs, uint16_t ip);
+
+/* Interpret up to 'budget' instructions of b (adds to *retired) */
+x86_status_t bcache_exec_block(exec_ctx_t *e, const bc_block_t *b, uint32_t budget, uint32_t *retired);
+
+/*
+ * Execute cached blocks starting at CS:IP until a non-OK status, a
+ * branch ends the block, or 'budget' instructions have retired.
+ * *retired receives the number of instructions executed.
+ */
+x86_status_t bcache_run_block(exec_ctx_t *e, bcache_t *bc, uint32_t budget, uint32_t *retired);
@@ -0,0 +1,81 @@
+// src/cpu/branch.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/branch.h"
+#include "cpu/x86_cpu.h"
+#include "cpu/decode.h"
+#include "cpu/memops.h"
+
+/* 0x70..0x7F : Jcc rel8 (condition = low nibble of the opcode) */
+x86_status_t op_jcc_rel8(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+
+    const x86_decoded_t *d = e->d;
+
+    if (x86_cond(c, (unsigned)(d->op & 0x0Fu)))
+        c->ip = (uint16_t)(c->ip + (uint16_t)(int16_t)(int8_t)d->imm);
+    return X86_OK;
+}
+
+/* 0xEB : JMP rel8 */
+x86_status_t op_jmp_rel8(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    c->ip = (uint16_t)(c->ip + (uint16_t)(int16_t)(int8_t)e->d->imm);
+    return X86_OK;
+}
+
+/* 0xE9 : JMP rel16 */
+x86_status_t op_jmp_rel16(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    c->ip = (uint16_t)(c->ip + (uint16_t)e->d->imm);
+    return X86_OK;
+}
+
+/* 0xE8 : CALL rel16 (pushes the return IP) */
+x86_status_t op_call_rel16(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    if (!x86_push16(e, c->ip)) return X86_FAULT;
+    c->ip = (uint16_t)(c->ip + (uint16_t)e->d->imm);
+    return X86_OK;
+}
+
+/* 0xC3 : RET, 0xC2 : RET imm16 (then SP += imm16) */
+x86_status_t op_ret_near(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t ip;
+    if (!x86_pop16(e, &ip)) return X86_FAULT;
+    c->ip = ip;
+    if (e->d->op == 0xC2) c->sp = (uint16_t)(c->sp + (uint16_t)e->d->imm);
+    return X86_OK;
+}
+
+/* 0xE2 : LOOP rel8 (CX--, jump while CX != 0; flags untouched) */
+x86_status_t op_loop(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    if (--c->cx != 0) c->ip = (uint16_t)(c->ip + (uint16_t)(int16_t)(int8_t)e->d->imm);
+    return X86_OK;
+}
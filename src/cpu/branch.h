@@ -0,0 +1,30 @@
+// src/cpu/branch.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+
+// Control transfer handlers
+x86_status_t op_jcc_rel8(exec_ctx_t *e);   // 70..7F
+x86_status_t op_jmp_rel8(exec_ctx_t *e);   // EB
+x86_status_t op_jmp_rel16(exec_ctx_t *e);  // E9
+x86_status_t op_call_rel16(exec_ctx_t *e); // E8
+x86_status_t op_ret_near(exec_ctx_t *e);   // C3, C2 imm16
+x86_status_t op_loop(exec_ctx_t *e);       // E2
@@ -21,6 +21,7 @@
 typedef enum {
     X86_OK = 0,
     X86_HALT = 1,
+    X86_IO   = 2,       // port access latched in exec_ctx_t.io for the VM
    
      // Negative = error/fault class
     X86_ERR     = -1,
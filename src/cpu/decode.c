@@ -17,76 +17,202 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 #include "x86_cpu.h"
+#include "cpu/decode.h"
+#include "cpu/table.h"
+#include "cpu/alu.h"
+#include "vm/vm.h"      // vm_fetch(), vm_code_ptr()
+
+/* Segment registers by X86_SEG_* number, as struct offsets */
+const uint8_t x86_sreg_off[4] = {
+    offsetof(x86_cpu_t, es), offsetof(x86_cpu_t, cs),
+    offsetof(x86_cpu_t, ss), offsetof(x86_cpu_t, ds)
+};
 
 uint16_t get_sreg(x86_cpu_t *c, unsigned s) {
-    switch (s & 3u) {
-        case 0: return c->es;
-        case 1: return c->cs;
-        case 2: return c->ss;
-        case 3: return c->ds;
-    }
-    return c->ds;
+    return x86_sreg(c, s);
 }
 
 void set_sreg(x86_cpu_t *c, unsigned s, uint16_t v) {
-    switch (s & 3u) {
-        case 0: c->es = v; break;
-        case 1: c->cs = v; break;
-        case 2: c->ss = v; break;
-        case 3: c->ds = v; break;
+    *(uint16_t*)((uint8_t*)c + x86_sreg_off[s & 3u]) = v;
+}
+
+/* ============================================================
+ * ModRM effective addresses
+ *
+ * One entry per ModRM byte: the EA function for its rm/mod pair, how
+ * many displacement bytes follow, and the default segment. The decoder
+ * takes the displacement size from here and handlers call the function
+ * through x86_modrm_ea(), so neither looks at mod/rm again. disp is 0
+ * for mod 0 (other than [disp16]), so one function serves all three
+ * memory mods of an rm.
+ * ============================================================ */
+
+static uint16_t ea_bx_si(const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bx + c->si + disp); }
+static uint16_t ea_bx_di(const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bx + c->di + disp); }
+static uint16_t ea_bp_si(const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bp + c->si + disp); }
+static uint16_t ea_bp_di(const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bp + c->di + disp); }
+static uint16_t ea_si   (const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->si + disp); }
+static uint16_t ea_di   (const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->di + disp); }
+static uint16_t ea_bp   (const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bp + disp); }
+static uint16_t ea_bx   (const x86_cpu_t *c, uint16_t disp) { return (uint16_t)(c->bx + disp); }
+static uint16_t ea_abs  (const x86_cpu_t *c, uint16_t disp) { (void)c; return disp; }
+
+#define EA_FN_0 ea_bx_si
+#define EA_FN_1 ea_bx_di
+#define EA_FN_2 ea_bp_si
+#define EA_FN_3 ea_bp_di
+#define EA_FN_4 ea_si
+#define EA_FN_5 ea_di
+#define EA_FN_6 ea_bp
+#define EA_FN_7 ea_bx
+
+#define EA_ABS(mod, rm)  ((mod) == 0 && (rm) == 6)
+#define EA_ENT(mod, rm) {                                                       \
+    (mod) == 3 ? NULL : EA_ABS(mod, rm) ? ea_abs : EA_FN_##rm,                  \
+    (mod) == 1 ? 1 : ((mod) == 2 || EA_ABS(mod, rm)) ? 2 : 0,                   \
+    ((mod) != 3 && !EA_ABS(mod, rm) && ((rm) == 2 || (rm) == 3 || (rm) == 6))   \
+        ? X86_SEG_SS : X86_SEG_DS }
+#define EA_RM(mod)  EA_ENT(mod, 0), EA_ENT(mod, 1), EA_ENT(mod, 2), EA_ENT(mod, 3), \
+                    EA_ENT(mod, 4), EA_ENT(mod, 5), EA_ENT(mod, 6), EA_ENT(mod, 7)
+#define EA_MOD(mod) EA_RM(mod), EA_RM(mod), EA_RM(mod), EA_RM(mod), \
+                    EA_RM(mod), EA_RM(mod), EA_RM(mod), EA_RM(mod)
+
+const x86_modrm_ent_t x86_modrm_tab[256] = {
+    EA_MOD(0), EA_MOD(1), EA_MOD(2), EA_MOD(3)
+};
+
+#undef EA_MOD
+#undef EA_RM
+#undef EA_ENT
+#undef EA_ABS
+
+/* ============================================================
+ * Instruction decoder
+ * ============================================================ */
+
+static x86_status_t op_fault(exec_ctx_t *e) {
+    (void)e;                    // code bytes were not readable
+    return X86_FAULT;
+}
+
+// One contiguous fetch of up to X86_MAX_INSN_LEN bytes at cs:ip; split in
+// two only when IP wraps inside the window.
+bool x86_fetch_refresh(exec_ctx_t *e, uint32_t lin)
+{
+    uint32_t left = 0;
+    const uint32_t base = lin & ~(uint32_t)(VM_PAGE_SIZE - 1u);
+    const uint8_t *p = e->vm ? vm_code_ptr(e->vm, base, &left) : NULL;
+
+    if (!p) {
+        x86_fetch_reset(e);
+        return false;
     }
+    e->fw.host = p;
+    e->fw.lin  = base;
+    e->fw.left = left;
+    return true;
+}
+
+static size_t fetch_slow(exec_ctx_t *e, uint16_t cs, uint16_t ip, uint8_t *buf)
+{
+    size_t first = 0x10000u - ip;
+    if (first > X86_MAX_INSN_LEN) first = X86_MAX_INSN_LEN;
+
+    size_t n = vm_fetch(e->vm, x86_linear_addr(cs, ip), buf, first);
+    if (n == first && first < X86_MAX_INSN_LEN)
+        n += vm_fetch(e->vm, x86_linear_addr(cs, 0), buf + n, X86_MAX_INSN_LEN - first);
+    return n;
 }
 
-bool ea16_compute(x86_cpu_t *c, uint8_t modrm, uint16_t *out_ea) {
-    // Use the CPU-based fetch helpers (implemented elsewhere, e.g. cpu_system.c).
-    // Declared here to avoid needing header churn.
-    extern bool x86_fetch8 (x86_cpu_t *c, uint8_t  *out);
-    extern bool x86_fetch16(x86_cpu_t *c, uint16_t *out);
+/*
+ * Single-pass decode:
+ *  - prefixes into pfx/seg
+ *  - opcode through x86_optab (x86_optab_0f after 0x0F)
+ *  - ModRM + displacement when the entry says so
+ *  - immediate bytes per the entry (F6/F7 only carry one for TEST)
+ */
+bool x86_decode(exec_ctx_t *e, uint16_t cs, uint16_t ip, x86_decoded_t *d)
+{
+    uint8_t tmp[X86_MAX_INSN_LEN];
+    const uint8_t *buf = x86_fetch_ptr(e, cs, ip, X86_MAX_INSN_LEN);
+    size_t avail = X86_MAX_INSN_LEN;
+
+    if (!buf) {
+        // near a page or segment edge: gather the bytes the slow way
+        avail = fetch_slow(e, cs, ip, tmp);
+        buf = tmp;
+    }
+    const x86_opent_t *ent;
+    size_t p = 0;
+    uint8_t b;
 
-    const uint8_t mod = (modrm >> 6) & 3u;
-    const uint8_t rm  = (modrm >> 0) & 7u;
+    d->fn = op_fault;
+    d->imm = 0;
+    d->disp = 0;
+    d->start_ip = ip;
+    d->next_ip = ip;
+    d->modrm = 0;
+    d->pfx = 0;
+    d->seg = X86_SEG_NONE;
+    d->len = 0;
 
-    // mod==3 is register-direct, not a memory EA
-    if (mod == 3u) return false;
+    for (;;) {
+        if (p >= avail) return false;
+        b = buf[p++];
+        ent = &x86_optab[b];
+        if (!(ent->flags & X86_OPF_PREFIX)) break;
 
-    // Special case: mod==00 rm==110 => [disp16] (no base regs)
-    if (mod == 0u && rm == 6u) {
-        uint16_t disp16 = 0;
-        if (!x86_fetch16(c, &disp16)) return false;
-        *out_ea = disp16;
-        return true;
+        switch (b) {
+            case 0x26: d->seg = X86_SEG_ES; break;
+            case 0x2E: d->seg = X86_SEG_CS; break;
+            case 0x36: d->seg = X86_SEG_SS; break;
+            case 0x3E: d->seg = X86_SEG_DS; break;
+            case 0x66: d->pfx |= X86_PFX_OPSIZE; break;
+            case 0x67: d->pfx |= X86_PFX_ADSIZE; break;
+            case 0xF0: d->pfx |= X86_PFX_LOCK; break;
+            case 0xF2: d->pfx = (uint8_t)((d->pfx & ~X86_PFX_REP) | X86_PFX_REPNE); break;
+            case 0xF3: d->pfx = (uint8_t)((d->pfx & ~X86_PFX_REPNE) | X86_PFX_REP); break;
+            default: break;   // FS/GS: no such registers in real-mode 8086
+        }
     }
+    d->op = b;
 
-    // Displacement (disp8 sign-extended; disp16 treated as signed here like your original)
-    int32_t disp = 0;
-    if (mod == 1u) {
-        uint8_t d8 = 0;
-        if (!x86_fetch8(c, &d8)) return false;
-        disp = (int8_t)d8;
-    } else if (mod == 2u) {
-        uint16_t d16 = 0;
-        if (!x86_fetch16(c, &d16)) return false;
-        disp = (int16_t)d16;
+    if (ent->flags & X86_OPF_ESC) {
+        if (p >= avail) return false;
+        b = buf[p++];
+        d->op = (uint16_t)(0x0F00u | b);
+        ent = &x86_optab_0f[b];
     }
+    d->opflags = ent->flags;
+
+    unsigned imm = ent->imm_bytes;
+
+    if (ent->flags & X86_OPF_MODRM) {
+        if (p >= avail) return false;
+        d->modrm = buf[p++];
+
+        const unsigned dbytes = x86_modrm_tab[d->modrm].disp_bytes;
+        if (p + dbytes > avail) return false;
 
-    uint16_t base = 0;
-    switch (rm) {
-        case 0: base = (uint16_t)(c->bx + c->si); break; // [BX+SI]
-        case 1: base = (uint16_t)(c->bx + c->di); break; // [BX+DI]
-        case 2: base = (uint16_t)(c->bp + c->si); break; // [BP+SI]
-        case 3: base = (uint16_t)(c->bp + c->di); break; // [BP+DI]
-        case 4: base = c->si; break;                     // [SI]
-        case 5: base = c->di; break;                     // [DI]
-        case 6: base = c->bp; break;                     // [BP] (mod!=0 here)
-        case 7: base = c->bx; break;                     // [BX]
+        if (dbytes == 2) d->disp = (uint16_t)(buf[p] | (buf[p + 1] << 8));
+        else if (dbytes == 1) d->disp = (uint16_t)(int16_t)(int8_t)buf[p];
+        p += dbytes;
+
+        if ((ent->flags & X86_OPF_GRP3IMM) && x86_modrm_reg(d) > 1) imm = 0;
     }
 
-    *out_ea = (uint16_t)(base + (uint16_t)disp);
+    if (p + imm > avail) return false;
+    for (unsigned i = 0; i < imm; i++)
+        d->imm |= (uint32_t)buf[p++] << (8 * i);
+
+    d->len = (uint8_t)p;
+    d->next_ip = (uint16_t)(ip + p);
+    // ALU rows resolve to a handler specialized for width/operand form
+    d->fn = (ent->flags & X86_OPF_ALU) ? x86_alu_select(d) : ent->fn;
     return true;
 }
 
-typedef x86_status_t (*x86_exec_fn_t)(exec_ctx_t *e);
-
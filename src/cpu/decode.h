@@ -21,5 +21,111 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-bool fetch8 (x86_cpu_t *c, uint8_t  *out);
-bool fetch16(x86_cpu_t *c, uint16_t *out);
\ No newline at end of file
+#include "cpu/exec_ctx.h"
+#include "cpu/table.h"      // x86_fn_t, X86_OPF_*
+
+#define X86_MAX_INSN_LEN 15
+
+/* Prefix bits (x86_decoded_t.pfx) */
+enum {
+    X86_PFX_REP    = 1u << 0,   // F3 REP/REPZ
+    X86_PFX_REPNE  = 1u << 1,   // F2 REPNZ
+    X86_PFX_LOCK   = 1u << 2,   // F0
+    X86_PFX_OPSIZE = 1u << 3,   // 66 (accepted, not honored yet)
+    X86_PFX_ADSIZE = 1u << 4    // 67 (accepted, not honored yet)
+};
+
+/* Segment override (x86_decoded_t.seg); same numbering as get_sreg() */
+enum { X86_SEG_ES = 0, X86_SEG_CS = 1, X86_SEG_SS = 2, X86_SEG_DS = 3, X86_SEG_NONE = -1 };
+
+extern const uint8_t x86_sreg_off[4];
+
+static inline uint16_t x86_sreg(const x86_cpu_t *c, unsigned s)
+{
+    return *(const uint16_t*)((const uint8_t*)c + x86_sreg_off[s & 3u]);
+}
+
+uint16_t get_sreg(x86_cpu_t *c, unsigned s);
+void     set_sreg(x86_cpu_t *c, unsigned s, uint16_t v);
+
+/* Effective-address form of one ModRM byte (see decode.c) */
+typedef struct x86_modrm_ent {
+    uint16_t (*ea)(const x86_cpu_t *c, uint16_t disp);   // NULL for mod 3
+    uint8_t  disp_bytes;                                 // 0, 1 (sign-extended) or 2
+    int8_t   seg;                                        // default: X86_SEG_SS or X86_SEG_DS
+} x86_modrm_ent_t;
+
+extern const x86_modrm_ent_t x86_modrm_tab[256];
+
+/*
+ * The decode product: one instruction, read once from one contiguous
+ * fetch. Handlers (through e->d), the block cache and the trace hooks
+ * all work from this and never go back to guest memory for code bytes.
+ */
+typedef struct x86_decoded {
+    x86_fn_t fn;
+
+    uint32_t imm;       // imm8/imm16 zero-extended; ptr16:16 = off | seg << 16;
+                        // ENTER = imm16 | imm8 << 16
+    uint16_t disp;      // ModRM displacement (disp8 sign-extended)
+
+    uint16_t start_ip;  // first byte (prefixes included)
+    uint16_t next_ip;   // IP of the following instruction
+
+    uint16_t op;        // opcode; 0x0Fxx for two-byte opcodes
+    uint8_t  opflags;   // X86_OPF_* from the table entry
+    uint8_t  modrm;     // valid when opflags & X86_OPF_MODRM
+
+    uint8_t  pfx;       // X86_PFX_*
+    int8_t   seg;       // X86_SEG_* override or X86_SEG_NONE
+    uint8_t  len;       // total length in bytes
+} x86_decoded_t;
+
+static inline unsigned x86_modrm_mod(const x86_decoded_t *d) { return (unsigned)(d->modrm >> 6); }
+static inline unsigned x86_modrm_reg(const x86_decoded_t *d) { return (unsigned)((d->modrm >> 3) & 7u); }
+static inline unsigned x86_modrm_rm (const x86_decoded_t *d) { return (unsigned)(d->modrm & 7u); }
+
+/* Data segment for a DS-relative access: the override if any, else DS */
+static inline uint16_t x86_data_seg(x86_cpu_t *c, const x86_decoded_t *d)
+{
+    return x86_sreg(c, d->seg == X86_SEG_NONE ? X86_SEG_DS : (unsigned)d->seg);
+}
+
+/*
+ * Offset of a ModRM memory operand (mod != 3) and, through *seg, the
+ * segment it is relative to: the override if any, else SS for the
+ * BP-based forms and DS for the rest. One table load and one call.
+ */
+static inline uint16_t x86_modrm_ea(x86_cpu_t *c, const x86_decoded_t *d, uint16_t *seg)
+{
+    const x86_modrm_ent_t *m = &x86_modrm_tab[d->modrm];
+    *seg = x86_sreg(c, (unsigned)(d->seg == X86_SEG_NONE ? m->seg : d->seg));
+    return m->ea(c, d->disp);
+}
+
+// Reload the fetch window for the page holding `lin`
+bool x86_fetch_refresh(exec_ctx_t *e, uint32_t lin);
+
+/*
+ * Host pointer to `need` contiguous code bytes at cs:ip, or NULL when the
+ * bytes cross a page or the 64 KiB segment edge, or are not plain RAM.
+ * Inside the current page this is a subtract and a compare.
+ */
+static inline const uint8_t *x86_fetch_ptr(exec_ctx_t *e, uint16_t cs, uint16_t ip, uint32_t need)
+{
+    if ((uint32_t)ip + need > 0x10000u) return 0;
+
+    const uint32_t lin = ((uint32_t)cs << 4) + ip;
+    uint32_t off = lin - e->fw.lin;
+
+    if (off >= e->fw.left) {
+        if (!x86_fetch_refresh(e, lin)) return 0;
+        off = lin - e->fw.lin;
+    }
+    if (e->fw.left - off < need) return 0;
+    return e->fw.host + off;
+}
+
+/* Decode the instruction at cs:ip into *d. On a fetch fault d->fn is a
+   handler that returns X86_FAULT, so the result is always executable. */
+bool x86_decode(exec_ctx_t *e, uint16_t cs, uint16_t ip, x86_decoded_t *d);
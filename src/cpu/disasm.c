@@ -57,4 +57,43 @@ x86_disasm_t x86_disasm_one_16(const uint8_t *mem, size_t memsz, uint32_t lin) {
     snprintf(d.text, sizeof(d.text), "db 0x%02X", op);
     d.len = 1;
     return d;
-}
\ No newline at end of file
+}
+
+x86_disasm_t x86_disasm_decoded(const x86_decoded_t *d) {
+    static const char *cc[16] = {
+        "jo","jno","jc","jnc","jz","jnz","jbe","ja",
+        "js","jns","jp","jnp","jl","jge","jle","jg"
+    };
+    static const char *grp1[8] = {"add","or","adc","sbb","and","sub","xor","cmp"};
+
+    x86_disasm_t r;
+    memset(&r, 0, sizeof(r));
+    r.len = d->len;
+    r.ok = true;
+
+    const unsigned op = d->op;
+
+    if (op == 0x90) {
+        snprintf(r.text, sizeof(r.text), "nop");
+    } else if (op == 0xF4) {
+        snprintf(r.text, sizeof(r.text), "hlt");
+    } else if (op >= 0xB8 && op <= 0xBF) {
+        snprintf(r.text, sizeof(r.text), "mov %s, 0x%04X", reg16_name(op & 7u), (unsigned)(d->imm & 0xFFFFu));
+    } else if (op >= 0x70 && op <= 0x7F) {
+        snprintf(r.text, sizeof(r.text), "%s 0x%04X", cc[op & 0xFu],
+                 (unsigned)(uint16_t)(d->next_ip + (uint16_t)(int16_t)(int8_t)d->imm));
+    } else if (op == 0x83 && x86_modrm_mod(d) == 3) {
+        snprintf(r.text, sizeof(r.text), "%s %s, %d", grp1[x86_modrm_reg(d)],
+                 reg16_name(x86_modrm_rm(d)), (int)(int8_t)d->imm);
+    } else if (op == 0xCD) {
+        snprintf(r.text, sizeof(r.text), "int 0x%02X", (unsigned)(d->imm & 0xFFu));
+    } else if (op == 0xEE || op == 0xEF) {
+        snprintf(r.text, sizeof(r.text), "out dx, %s", (op & 1u) ? "ax" : "al");
+    } else if (op == 0xEC || op == 0xED) {
+        snprintf(r.text, sizeof(r.text), "in %s, dx", (op & 1u) ? "ax" : "al");
+    } else {
+        r.ok = false;
+        snprintf(r.text, sizeof(r.text), "op=0x%02X", op);
+    }
+    return r;
+}
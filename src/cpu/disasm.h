@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "cpu/decode.h"
+
 typedef struct {
     size_t len;        // bytes consumed
     char   text[64];   // disassembly
@@ -12,3 +14,6 @@ typedef struct {
 } x86_disasm_t;
 
 x86_disasm_t x86_disasm_one_16(const uint8_t *mem, size_t memsz, uint32_t lin);
+
+// Disassemble an already-decoded instruction (trace path; no memory reads)
+x86_disasm_t x86_disasm_decoded(const x86_decoded_t *d);
@@ -18,15 +18,48 @@
 
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct VM VM;      // forward declare the real VM type
 typedef struct x86_cpu x86_cpu_t;  // forward declare CPU
+typedef struct x86_decoded x86_decoded_t;  // decode product (decode.h)
 
 typedef struct exec_ctx {
     x86_cpu_t *cpu;     // always present
     VM        *vm;      // VM owns memory/devices; may be NULL during transition
 
+    const x86_decoded_t *d;   // instruction being executed (set by the dispatcher)
+
+    // Fused group (cpu/fuse.h): members after d[0] that completed. The
+    // executor presets it to the whole group; a handler that stops
+    // early lowers it so IP, retired counts and stats end where the
+    // unfused sequence would have stopped.
+    unsigned fused_done;
+
+    // Instruction fetch window: host view of the current code page.
+    // Refreshed on a page miss; x86_fetch_reset() drops it.
+    struct {
+        const uint8_t *host;   // host byte for linear address `lin`
+        uint32_t lin;          // page-aligned linear base
+        uint32_t left;         // readable bytes from host (0 = empty)
+    } fw;
+
+    // Port access latched by IN/OUT (valid when a handler returns X86_IO)
+    struct {
+        uint16_t port;
+        uint8_t  size;  // 1 or 2 bytes
+        bool     in;    // IN: value already holds the floating-bus default
+        uint16_t value;
+    } io;
+
     // Optional trace/flags hooks (future)
     uint32_t   dbg;
     uint32_t   last_phys; // last physical addr touched (handy for debug)
-} exec_ctx_t;
\ No newline at end of file
+} exec_ctx_t;
+
+// Forget the fetch window (guest memory remapped or replaced)
+static inline void x86_fetch_reset(exec_ctx_t *e) {
+    e->fw.host = 0;
+    e->fw.lin = 0;
+    e->fw.left = 0;
+}
@@ -0,0 +1,204 @@
+// src/cpu/flags.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/flags.h"
+#include "cpu/x86_cpu.h"
+#include "cpu/memops.h"
+#include "cpu/decode.h"
+
+/* ============================================================
+ * Lazy flag evaluation
+ *
+ * ALU handlers only call x86_lazy_flags(). Each reader below derives
+ * just the bit it needs from (op, width, dst, src, res):
+ *   carry/borrow vectors give CF for ADD/ADC and SUB/SBB alike,
+ *   AF is bit 4 of dst^src^res, PF is even parity of the low byte.
+ * ============================================================ */
+
+static inline uint16_t lf_msb(const x86_cpu_t *c)
+{
+    return (c->lf.width == 8) ? 0x80u : 0x8000u;
+}
+
+static bool lf_cf(const x86_cpu_t *c)
+{
+    const uint16_t d = c->lf.dst, s = c->lf.src, r = c->lf.res;
+
+    switch (c->lf.op) {
+        case X86_LF_ADD: return (((d & s) | ((d | s) & (uint16_t)~r)) & lf_msb(c)) != 0;
+        case X86_LF_SUB: return ((((uint16_t)~d & s) | (((uint16_t)~d | s) & r)) & lf_msb(c)) != 0;
+        case X86_LF_LOGIC: return false;
+        default: return (c->flags & X86_FL_CF) != 0;   // NONE, INC, DEC
+    }
+}
+
+static bool lf_of(const x86_cpu_t *c)
+{
+    const uint16_t d = c->lf.dst, s = c->lf.src, r = c->lf.res;
+
+    switch (c->lf.op) {
+        case X86_LF_ADD:
+        case X86_LF_INC: return (((uint16_t)~(d ^ s) & (d ^ r)) & lf_msb(c)) != 0;
+        case X86_LF_SUB:
+        case X86_LF_DEC: return (((d ^ s) & (d ^ r)) & lf_msb(c)) != 0;
+        case X86_LF_LOGIC: return false;
+        default: return (c->flags & X86_FL_OF) != 0;
+    }
+}
+
+static bool lf_af(const x86_cpu_t *c)
+{
+    if (c->lf.op == X86_LF_NONE)  return (c->flags & X86_FL_AF) != 0;
+    if (c->lf.op == X86_LF_LOGIC) return false;
+    return ((c->lf.dst ^ c->lf.src ^ c->lf.res) & 0x10u) != 0;
+}
+
+static bool lf_zf(const x86_cpu_t *c)
+{
+    if (c->lf.op == X86_LF_NONE) return (c->flags & X86_FL_ZF) != 0;
+    return (c->lf.width == 8) ? (c->lf.res & 0xFFu) == 0 : c->lf.res == 0;
+}
+
+static bool lf_sf(const x86_cpu_t *c)
+{
+    if (c->lf.op == X86_LF_NONE) return (c->flags & X86_FL_SF) != 0;
+    return (c->lf.res & lf_msb(c)) != 0;
+}
+
+static bool lf_pf(const x86_cpu_t *c)
+{
+    if (c->lf.op == X86_LF_NONE) return (c->flags & X86_FL_PF) != 0;
+    unsigned v = c->lf.res & 0xFFu;
+    v ^= v >> 4;
+    return ((0x6996u >> (v & 0xFu)) & 1u) == 0;   // even parity => PF=1
+}
+
+bool x86_flag(const x86_cpu_t *c, uint16_t mask)
+{
+    switch (mask) {
+        case X86_FL_CF: return lf_cf(c);
+        case X86_FL_PF: return lf_pf(c);
+        case X86_FL_AF: return lf_af(c);
+        case X86_FL_ZF: return lf_zf(c);
+        case X86_FL_SF: return lf_sf(c);
+        case X86_FL_OF: return lf_of(c);
+        default:        return (c->flags & mask) != 0;
+    }
+}
+
+uint16_t x86_flags(const x86_cpu_t *c)
+{
+    if (c->lf.op == X86_LF_NONE) return c->flags;
+
+    uint16_t f = (uint16_t)(c->flags & (uint16_t)~X86_FL_ARITH);
+    if (lf_cf(c)) f |= X86_FL_CF;
+    if (lf_pf(c)) f |= X86_FL_PF;
+    if (lf_af(c)) f |= X86_FL_AF;
+    if (lf_zf(c)) f |= X86_FL_ZF;
+    if (lf_sf(c)) f |= X86_FL_SF;
+    if (lf_of(c)) f |= X86_FL_OF;
+    return f;
+}
+
+void x86_flags_sync(x86_cpu_t *c)
+{
+    c->flags = x86_flags(c);
+    c->lf.op = X86_LF_NONE;
+}
+
+void x86_flags_store(x86_cpu_t *c, uint16_t v)
+{
+    c->flags = (uint16_t)(v | 0x0002u);   // bit 1 reads as 1
+    c->lf.op = X86_LF_NONE;
+}
+
+/* cc = low nibble of Jcc/SETcc/CMOVcc; odd cc negates the even one */
+bool x86_cond(const x86_cpu_t *c, unsigned cc)
+{
+    bool t;
+    switch ((cc >> 1) & 7u) {
+        case 0: t = lf_of(c); break;                          // O
+        case 1: t = lf_cf(c); break;                          // C / B
+        case 2: t = lf_zf(c); break;                          // Z / E
+        case 3: t = lf_cf(c) || lf_zf(c); break;              // BE
+        case 4: t = lf_sf(c); break;                          // S
+        case 5: t = lf_pf(c); break;                          // P
+        case 6: t = lf_sf(c) != lf_of(c); break;              // L
+        default: t = lf_zf(c) || (lf_sf(c) != lf_of(c)); break; // LE
+    }
+    return (cc & 1u) ? !t : t;
+}
+
+/* ============================================================
+ * FLAGS instructions
+ * ============================================================ */
+
+x86_status_t op_pushf(exec_ctx_t *e)
+{
+    return x86_push16(e, x86_flags(e->cpu)) ? X86_OK : X86_FAULT;
+}
+
+x86_status_t op_popf(exec_ctx_t *e)
+{
+    uint16_t v = 0;
+    if (!x86_pop16(e, &v)) return X86_FAULT;
+    x86_flags_store(e->cpu, v);
+    return X86_OK;
+}
+
+x86_status_t op_sahf(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    const uint16_t mask = X86_FL_CF | X86_FL_PF | X86_FL_AF | X86_FL_ZF | X86_FL_SF;
+
+    x86_flags_sync(c);
+    c->flags = (uint16_t)((c->flags & (uint16_t)~mask) | ((c->ax >> 8) & mask));
+    return X86_OK;
+}
+
+x86_status_t op_lahf(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    c->ax = (uint16_t)((c->ax & 0x00FFu) | ((x86_flags(c) & 0x00FFu) << 8));
+    return X86_OK;
+}
+
+x86_status_t op_cmc(exec_ctx_t *e)
+{
+    x86_set_cf(e, !x86_flag(e->cpu, X86_FL_CF));
+    return X86_OK;
+}
+
+x86_status_t op_flag_bit(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+
+    switch (e->d->op) {
+        case 0xF8: x86_set_cf(e, false); break;            // CLC
+        case 0xF9: x86_set_cf(e, true);  break;            // STC
+        case 0xFA: c->flags &= (uint16_t)~X86_FL_IF; break; // CLI
+        case 0xFB: c->flags |= X86_FL_IF; break;           // STI
+        case 0xFC: c->flags &= (uint16_t)~X86_FL_DF; break; // CLD
+        case 0xFD: c->flags |= X86_FL_DF; break;           // STD
+        default: return X86_ILLEGAL;
+    }
+    return X86_OK;
+}
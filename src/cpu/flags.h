@@ -0,0 +1,30 @@
+// src/cpu/flags.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+
+// FLAGS instructions (lazy-flag aware)
+x86_status_t op_pushf(exec_ctx_t *e);      // 9C
+x86_status_t op_popf(exec_ctx_t *e);       // 9D
+x86_status_t op_sahf(exec_ctx_t *e);       // 9E
+x86_status_t op_lahf(exec_ctx_t *e);       // 9F
+x86_status_t op_cmc(exec_ctx_t *e);        // F5
+x86_status_t op_flag_bit(exec_ctx_t *e);   // F8..FD: CLC/STC/CLI/STI/CLD/STD
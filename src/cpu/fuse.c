@@ -0,0 +1,187 @@
+// src/cpu/fuse.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/fuse.h"
+#include "cpu/logic.h"
+#include "cpu/memops.h"
+#include "cpu/x86_cpu.h"
+#include "vm/vm.h"
+
+/* ============================================================
+ * helpers
+ * ============================================================ */
+
+static inline void take_jcc(x86_cpu_t *c, const x86_decoded_t *j)
+{
+    c->ip = (uint16_t)(c->ip + (uint16_t)(int16_t)(int8_t)j->imm);
+}
+
+// Jcc condition after res = dst - src, straight from the operands.
+// Parity is the one bit that is cheaper to leave to the lazy reader.
+static bool sub16_cond(const x86_cpu_t *c, unsigned cc, uint16_t dst, uint16_t src, uint16_t res)
+{
+    bool t;
+
+    switch (cc >> 1) {
+        case 0: t = (((dst ^ src) & (dst ^ res)) & 0x8000u) != 0; break;   // O
+        case 1: t = dst < src; break;                                       // B
+        case 2: t = res == 0; break;                                        // Z
+        case 3: t = dst <= src; break;                                      // BE
+        case 4: t = (res & 0x8000u) != 0; break;                            // S
+        case 5: return x86_cond(c, cc);                                     // P
+        case 6: t = (int16_t)dst < (int16_t)src; break;                     // L
+        default: t = (int16_t)dst <= (int16_t)src; break;                   // LE
+    }
+    return (cc & 1u) ? !t : t;
+}
+
+// Member k of the group (0 = d[0]) faulted: stop there, as unfused would
+static x86_status_t fused_fault(exec_ctx_t *e, unsigned k)
+{
+    e->cpu->ip = e->d[k].next_ip;
+    e->fused_done = k;
+    return X86_FAULT;
+}
+
+/* ============================================================
+ * fused handlers
+ * ============================================================ */
+
+/* 83 /5|/7 ; Jcc */
+static x86_status_t fx_sub_jcc(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    const x86_decoded_t *d = e->d;
+
+    uint16_t *r = x86_reg16(e, x86_modrm_rm(d));
+    const uint16_t dst = *r;
+    const uint16_t src = (uint16_t)(int16_t)(int8_t)d->imm;
+    const uint16_t res = (uint16_t)(dst - src);
+
+    if (x86_modrm_reg(d) == 5u) *r = res;
+    x86_lazy_flags(c, X86_LF_SUB, 16, dst, src, res);
+
+    if (sub16_cond(c, (unsigned)(d[1].op & 0xFu), dst, src, res)) take_jcc(c, &d[1]);
+    return X86_OK;
+}
+
+/* DEC r16 ; JNZ */
+static x86_status_t fx_dec_jnz(exec_ctx_t *e)
+{
+    op_dec_r16(e);
+    if (*x86_reg16(e, (unsigned)(e->d->op & 7u)) != 0) take_jcc(e->cpu, &e->d[1]);
+    return X86_OK;
+}
+
+/* LODSB ; TEST AL,AL ; JZ|JNZ */
+static x86_status_t fx_lodsb_test_jz(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    const x86_decoded_t *d = e->d;
+
+    uint8_t al = 0;
+    if (!vm_read8(e->vm, x86_linear_addr(x86_data_seg(c, d), c->si), &al))
+        return fused_fault(e, 0);
+    c->ax = (uint16_t)((c->ax & 0xFF00u) | al);
+    c->si = (uint16_t)(c->si + ((c->flags & X86_FL_DF) ? 0xFFFFu : 1u));
+
+    x86_lazy_flags(c, X86_LF_LOGIC, 8, al, al, al);
+
+    if ((al == 0) == (d[2].op == 0x74)) take_jcc(c, &d[2]);
+    return X86_OK;
+}
+
+/* PUSH r16 / POP r16 runs */
+static x86_status_t push_run(exec_ctx_t *e, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        if (!x86_push16(e, *x86_reg16(e, (unsigned)(e->d[i].op & 7u)))) return fused_fault(e, i);
+    }
+    return X86_OK;
+}
+
+static x86_status_t pop_run(exec_ctx_t *e, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        uint16_t v = 0;
+        if (!x86_pop16(e, &v)) return fused_fault(e, i);
+        *x86_reg16(e, (unsigned)(e->d[i].op & 7u)) = v;
+    }
+    return X86_OK;
+}
+
+static x86_status_t fx_push2(exec_ctx_t *e) { return push_run(e, 2); }
+static x86_status_t fx_push3(exec_ctx_t *e) { return push_run(e, 3); }
+static x86_status_t fx_push4(exec_ctx_t *e) { return push_run(e, 4); }
+static x86_status_t fx_pop2 (exec_ctx_t *e) { return pop_run(e, 2); }
+static x86_status_t fx_pop3 (exec_ctx_t *e) { return pop_run(e, 3); }
+static x86_status_t fx_pop4 (exec_ctx_t *e) { return pop_run(e, 4); }
+
+/* ============================================================
+ * matcher
+ * ============================================================ */
+
+static inline bool is_jcc(const x86_decoded_t *d) { return d->op >= 0x70 && d->op <= 0x7F; }
+
+// Count consecutive opcodes in [lo, lo+7], capped at X86_FUSE_MAX.
+static unsigned run_len(const x86_decoded_t *d, unsigned avail, uint16_t lo)
+{
+    unsigned n = 0;
+    while (n < avail && n < X86_FUSE_MAX && !d[n].pfx && d[n].op >= lo && d[n].op <= lo + 7u) n++;
+    return n;
+}
+
+x86_fn_t x86_fuse_match(const x86_decoded_t *d, unsigned avail, unsigned *extra)
+{
+    static const x86_fn_t push_fn[X86_FUSE_MAX + 1] = { 0, 0, fx_push2, fx_push3, fx_push4 };
+    static const x86_fn_t pop_fn [X86_FUSE_MAX + 1] = { 0, 0, fx_pop2,  fx_pop3,  fx_pop4  };
+
+    *extra = 0;
+    if (avail < 2 || d[0].pfx || d[1].pfx) return NULL;
+
+    const uint16_t op = d[0].op;
+
+    if (op == 0x83 && x86_modrm_mod(&d[0]) == 3u && is_jcc(&d[1])) {
+        const unsigned sub = x86_modrm_reg(&d[0]);
+        if (sub == 5u || sub == 7u) { *extra = 1; return fx_sub_jcc; }
+    }
+
+    if (op >= 0x48 && op <= 0x4F && d[1].op == 0x75) {
+        *extra = 1;
+        return fx_dec_jnz;
+    }
+
+    if (op == 0xAC && avail >= 3 && !d[2].pfx &&
+        d[1].op == 0x84 && d[1].modrm == 0xC0 && (d[2].op == 0x74 || d[2].op == 0x75)) {
+        *extra = 2;
+        return fx_lodsb_test_jz;
+    }
+
+    if (op >= 0x50 && op <= 0x5F) {
+        const uint16_t lo = (uint16_t)(op & 0xF8u);
+        const unsigned n = run_len(d, avail, lo);
+        if (n >= 2) {
+            *extra = n - 1u;
+            return lo == 0x50 ? push_fn[n] : pop_fn[n];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,51 @@
+// src/cpu/fuse.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+#include "cpu/decode.h"
+
+/*
+ * Superinstructions.
+ *
+ * The block builder asks, for each position in a block, whether the
+ * instructions starting there form a known idiom. A fused handler runs
+ * the whole idiom in one dispatch; it is entered with e->d pointing at
+ * the first instruction (the rest follow in the same array) and CS:IP
+ * already past the last one.
+ *
+ *   SUB/CMP r16, imm8 ; Jcc          condition from dst/src directly
+ *   DEC r16 ; JNZ                    loop counter
+ *   LODSB ; TEST AL,AL ; JZ/JNZ      string scan
+ *   PUSH r16 x2..4 / POP r16 x2..4   register save/restore runs
+ *
+ * FLAGS still end up exactly as the unfused sequence leaves them (one
+ * lazy record, written once). A member that faults stops the group
+ * there: the handler leaves IP just past it and sets e->fused_done to
+ * the members before it, so the state and the counts match stepping
+ * one instruction at a time.
+ */
+
+#define X86_FUSE_MAX 4      // instructions per fused group
+
+/* Fused handler for the idiom at d[0] (avail instructions left in the
+   block), or NULL. *extra receives how many instructions after d[0] it
+   also executes. */
+x86_fn_t x86_fuse_match(const x86_decoded_t *d, unsigned avail, unsigned *extra);
@@ -23,6 +23,7 @@
 
 #include "cpu/interrupt.h"
 #include "cpu/memops.h"
+#include "cpu/decode.h"
 #include "vm/vm.h"
 #include "cpu/x86_cpu.h"
 
@@ -47,11 +48,10 @@ x86_status_t handle_int_cd(exec_ctx_t *e)
     x86_cpu_t *c = e->cpu;
     if (!e || !c || !e->vm) return X86_ERR;
 
-    uint8_t n = 0;
-    if (!x86_fetch8(e, &n)) return X86_ERR;
+    uint8_t n = (uint8_t)e->d->imm;
 
     // Push FLAGS, CS, IP (IP already points to next instruction after imm8)
-    if (!x86_push16(e, c->flags)) return X86_ERR;
+    if (!x86_push16(e, x86_flags(c))) return X86_ERR;
     if (!x86_push16(e, c->cs))    return X86_ERR;
     if (!x86_push16(e, c->ip))    return X86_ERR;
 
@@ -64,4 +64,16 @@ x86_status_t handle_int_cd(exec_ctx_t *e)
     c->cs = new_cs;
     c->ip = new_ip;
     return X86_OK;
-}
\ No newline at end of file
+}
+/* 0xCF : IRET (pop IP, CS, FLAGS) */
+x86_status_t op_iret(exec_ctx_t *e)
+{
+    x86_cpu_t *c = e->cpu;
+    uint16_t ip, cs, fl;
+
+    if (!x86_pop16(e, &ip) || !x86_pop16(e, &cs) || !x86_pop16(e, &fl)) return X86_FAULT;
+    c->ip = ip;
+    c->cs = cs;
+    x86_flags_store(c, fl);
+    return X86_OK;
+}
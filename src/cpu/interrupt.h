@@ -24,4 +24,5 @@
 #include "cpu/cpu_types.h"   // x86_status_t (or wherever it actually lives)
 
 bool ivt_get_vector(exec_ctx_t *e, uint8_t n, uint16_t *out_ip, uint16_t *out_cs);
-x86_status_t handle_int_cd(exec_ctx_t *e);
\ No newline at end of file
+x86_status_t handle_int_cd(exec_ctx_t *e);
+x86_status_t op_iret(exec_ctx_t *e);      // CF
\ No newline at end of file
@@ -21,191 +21,86 @@
 
 #include "cpu/logic.h"
 #include "cpu/x86_cpu.h"
-#include "cpu/memops.h"
+#include "cpu/decode.h"
 #include "vm/vm.h"
 
 /* ============================================================
  * Local flag helpers
  * ============================================================ */
 
-static inline void set_flag_u16(x86_cpu_t *c, uint16_t mask, bool v)
-{
-    if (v) c->flags |= mask;
-    else   c->flags &= (uint16_t)~mask;
-}
-
 static inline bool get_cf(const x86_cpu_t *c)
 {
-    return (c->flags & (uint16_t)X86_FL_CF) != 0;
-}
-
-static void update_flags_add16(exec_ctx_t *e, uint16_t dst, uint16_t src, uint16_t res)
-{
-    x86_cpu_t *c = e->cpu;
-
-    /* CF: unsigned carry out */
-    set_flag_u16(c, (uint16_t)X86_FL_CF, res < dst);
-
-    /* OF: signed overflow */
-    set_flag_u16(c, (uint16_t)X86_FL_OF,
-                 (((uint16_t)~(dst ^ src) & (dst ^ res) & 0x8000u) != 0));
-
-    /* ZF/SF */
-    x86_set_zf_sf16(e, res);
-}
-
-static void update_flags_sub16(exec_ctx_t *e, uint16_t dst, uint16_t src, uint16_t res)
-{
-    x86_cpu_t *c = e->cpu;
-
-    /* CF: borrow -> dst < src */
-    set_flag_u16(c, (uint16_t)X86_FL_CF, dst < src);
-
-    /* OF: signed overflow for subtraction */
-    set_flag_u16(c, (uint16_t)X86_FL_OF,
-                 (((dst ^ src) & (dst ^ res) & 0x8000u) != 0));
-
-    /* ZF/SF */
-    x86_set_zf_sf16(e, res);
+    return x86_flag(c, (uint16_t)X86_FL_CF);
 }
 
 /* ============================================================
- * Group 1 (0x80/0x81/0x83) handlers – we start with 0x83
- * For now we only support modrm.mod == 3 (register-direct).
+ * INC/DEC r16 (0x40..0x4F) and TEST (0x84/0x85)
  * ============================================================ */
 
-static x86_status_t handle_add_83_0(exec_ctx_t *e, uint8_t modrm);
-static x86_status_t handle_adc_83_2(exec_ctx_t *e, uint8_t modrm);
-static x86_status_t handle_sub_83_5(exec_ctx_t *e, uint8_t modrm);
-static x86_status_t handle_cmp_83_7(exec_ctx_t *e, uint8_t modrm);
-
-/*
- * Dispatch for opcode 0x83 /r
- * reg field selects operation:
- *   /0 ADD r/m16, imm8
- *   /2 ADC r/m16, imm8
- *   /5 SUB r/m16, imm8
- *   /7 CMP r/m16, imm8
- */
-x86_status_t handle_grp1_83(exec_ctx_t *e)
+/* INC/DEC leave CF alone: a carry still pending in the lazy record
+   has to be parked in FLAGS before the record is replaced. */
+static inline void keep_cf(x86_cpu_t *c)
 {
-    uint8_t modrm = 0;
-    if (!x86_fetch8(e, &modrm)) return X86_ERR;
-
-    uint8_t op = (uint8_t)((modrm >> 3) & 7u);
+    if (c->lf.op == X86_LF_NONE || c->lf.op == X86_LF_INC || c->lf.op == X86_LF_DEC) return;
 
-    switch (op) {
-        case 0u: return handle_add_83_0(e, modrm);
-        case 2u: return handle_adc_83_2(e, modrm);
-        case 5u: return handle_sub_83_5(e, modrm);
-        case 7u: return handle_cmp_83_7(e, modrm);
-        default:
-            return X86_ERR; /* unimplemented /1 OR /3 OR /4 OR /6 */
-    }
+    if (get_cf(c)) c->flags |= X86_FL_CF;
+    else           c->flags &= (uint16_t)~X86_FL_CF;
 }
 
-static bool modrm_is_reg(uint8_t modrm)
+/* 0x40+r : INC r16 */
+x86_status_t op_inc_r16(exec_ctx_t *e)
 {
-    return ((modrm >> 6) & 3u) == 3u;
-}
+    uint16_t *r = x86_reg16(e, (unsigned)(e->d->op & 7u));
+    const uint16_t dst = *r;
 
-static uint16_t signext_imm8_to_u16(uint8_t imm8)
-{
-    return (uint16_t)(int16_t)(int8_t)imm8;
+    keep_cf(e->cpu);
+    *r = (uint16_t)(dst + 1u);
+    x86_lazy_flags(e->cpu, X86_LF_INC, 16, dst, 1, *r);
+    return X86_OK;
 }
 
-/* 0x83 /0 : ADD r/m16, imm8 */
-static x86_status_t handle_add_83_0(exec_ctx_t *e, uint8_t modrm)
+/* 0x48+r : DEC r16 */
+x86_status_t op_dec_r16(exec_ctx_t *e)
 {
-    if (!modrm_is_reg(modrm)) return X86_ERR; /* EA path not wired yet */
-
-    uint8_t imm8 = 0;
-    if (!x86_fetch8(e, &imm8)) return X86_ERR;
-
-    uint16_t src = signext_imm8_to_u16(imm8);
-    unsigned rm = (unsigned)(modrm & 7u);
-
-    uint16_t *dstp = x86_reg16(e, rm);
-    uint16_t dst = *dstp;
-    uint16_t res = (uint16_t)(dst + src);
+    uint16_t *r = x86_reg16(e, (unsigned)(e->d->op & 7u));
+    const uint16_t dst = *r;
 
-    update_flags_add16(e, dst, src, res);
-
-    *dstp = res;
+    keep_cf(e->cpu);
+    *r = (uint16_t)(dst - 1u);
+    x86_lazy_flags(e->cpu, X86_LF_DEC, 16, dst, 1, *r);
     return X86_OK;
 }
 
-/* 0x83 /2 : ADC r/m16, imm8 */
-static x86_status_t handle_adc_83_2(exec_ctx_t *e, uint8_t modrm)
+/* 8-bit register by ModRM index: AL,CL,DL,BL,AH,CH,DH,BH */
+static uint8_t get_r8(exec_ctx_t *e, unsigned reg)
 {
-    if (!modrm_is_reg(modrm)) return X86_ERR; /* EA path not wired yet */
-
-    uint8_t imm8 = 0;
-    if (!x86_fetch8(e, &imm8)) return X86_ERR;
-
-    uint16_t src = signext_imm8_to_u16(imm8);
-    unsigned rm = (unsigned)(modrm & 7u);
-
-    uint16_t *dstp = x86_reg16(e, rm);
-    uint16_t dst = *dstp;
-
-    uint16_t carry = get_cf(e->cpu) ? 1u : 0u;
-    uint16_t res = (uint16_t)(dst + src + carry);
-
-    /* CF for adc is more subtle; easiest is 32-bit sum */
-    uint32_t sum32 = (uint32_t)dst + (uint32_t)src + (uint32_t)carry;
-    set_flag_u16(e->cpu, (uint16_t)X86_FL_CF, (sum32 & 0x10000u) != 0);
-
-    /* OF for adc uses src+carry as effective src for signed overflow test */
-    {
-        uint16_t eff_src = (uint16_t)(src + carry);
-        set_flag_u16(e->cpu, (uint16_t)X86_FL_OF,
-                     (((uint16_t)~(dst ^ eff_src) & (dst ^ res) & 0x8000u) != 0));
-    }
-
-    x86_set_zf_sf16(e, res);
-
-    *dstp = res;
-    return X86_OK;
+    const uint16_t v = *x86_reg16(e, reg & 3u);
+    return (uint8_t)((reg & 4u) ? (v >> 8) : v);
 }
 
-/* 0x83 /5 : SUB r/m16, imm8 */
-static x86_status_t handle_sub_83_5(exec_ctx_t *e, uint8_t modrm)
+/* 0x84 : TEST r/m8, r8 (register form) */
+x86_status_t op_test_rm8_r8(exec_ctx_t *e)
 {
-    if (!modrm_is_reg(modrm)) return X86_ERR; /* EA path not wired yet */
-
-    uint8_t imm8 = 0;
-    if (!x86_fetch8(e, &imm8)) return X86_ERR;
-
-    uint16_t src = signext_imm8_to_u16(imm8);
-    unsigned rm = (unsigned)(modrm & 7u);
+    const x86_decoded_t *d = e->d;
+    if (x86_modrm_mod(d) != 3u) return X86_ERR; /* EA path not wired yet */
 
-    uint16_t *dstp = x86_reg16(e, rm);
-    uint16_t dst = *dstp;
-    uint16_t res = (uint16_t)(dst - src);
+    const uint8_t a = get_r8(e, x86_modrm_rm(d));
+    const uint8_t b = get_r8(e, x86_modrm_reg(d));
 
-    update_flags_sub16(e, dst, src, res);
-
-    *dstp = res;
+    x86_lazy_flags(e->cpu, X86_LF_LOGIC, 8, a, b, (uint16_t)(a & b));
     return X86_OK;
 }
 
-/* 0x83 /7 : CMP r/m16, imm8 (like SUB, but no writeback) */
-static x86_status_t handle_cmp_83_7(exec_ctx_t *e, uint8_t modrm)
+/* 0x85 : TEST r/m16, r16 (register form) */
+x86_status_t op_test_rm16_r16(exec_ctx_t *e)
 {
-    if (!modrm_is_reg(modrm)) return X86_ERR; /* EA path not wired yet */
-
-    uint8_t imm8 = 0;
-    if (!x86_fetch8(e, &imm8)) return X86_ERR;
-
-    uint16_t src = signext_imm8_to_u16(imm8);
-    unsigned rm = (unsigned)(modrm & 7u);
-
-    uint16_t dst = *x86_reg16(e, rm);
-    uint16_t res = (uint16_t)(dst - src);
+    const x86_decoded_t *d = e->d;
+    if (x86_modrm_mod(d) != 3u) return X86_ERR; /* EA path not wired yet */
 
-    update_flags_sub16(e, dst, src, res);
+    const uint16_t a = *x86_reg16(e, x86_modrm_rm(d));
+    const uint16_t b = *x86_reg16(e, x86_modrm_reg(d));
 
+    x86_lazy_flags(e->cpu, X86_LF_LOGIC, 16, a, b, (uint16_t)(a & b));
     return X86_OK;
 }
 
@@ -232,28 +127,6 @@ x86_status_t op_mov_r16_imm16(exec_ctx_t *e)
 {
     if (!e || !e->cpu || !e->vm) return X86_ERR;
 
-    x86_cpu_t *c = e->cpu;
-
-    /* We assume cpu_execute already fetched op, but we can re-read it safely.
-       If you have e->op/e->instr byte cached, use that instead. */
-    uint32_t lin = x86_linear_addr(c->cs, c->ip);
-
-    uint8_t op = 0;
-    if (!vm_read8(e->vm, lin + 0, &op)) return X86_FAULT;
-
-    if (op < 0xB8 || op > 0xBF) return X86_ERR; /* sanity */
-
-    uint8_t lo = 0, hi = 0;
-    if (!vm_read8(e->vm, lin + 1, &lo)) return X86_FAULT;
-    if (!vm_read8(e->vm, lin + 2, &hi)) return X86_FAULT;
-
-    uint16_t imm = (uint16_t)(lo | ((uint16_t)hi << 8));
-    unsigned reg = (unsigned)(op & 7u);
-
-    set_r16_by_index(c, reg, imm);
-
-    /* Advance IP by opcode + imm16 */
-    c->ip = (uint16_t)(c->ip + 3);
-
+    set_r16_by_index(e->cpu, (unsigned)(e->d->op & 7u), (uint16_t)e->d->imm);
     return X86_OK;
-}
\ No newline at end of file
+}
@@ -21,5 +21,8 @@
 #include "cpu/exec_ctx.h"
 #include "cpu/cpu_types.h"
 
-x86_status_t handle_grp1_83(exec_ctx_t *e);
-x86_status_t op_mov_r16_imm16(exec_ctx_t *e);
\ No newline at end of file
+x86_status_t op_mov_r16_imm16(exec_ctx_t *e);
+x86_status_t op_inc_r16(exec_ctx_t *e);          // 40+r
+x86_status_t op_dec_r16(exec_ctx_t *e);          // 48+r
+x86_status_t op_test_rm8_r8(exec_ctx_t *e);      // 84
+x86_status_t op_test_rm16_r16(exec_ctx_t *e);    // 85
@@ -18,21 +18,23 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include <stdio.h>
 
 #include "cpu/memops.h"
+#include "cpu/decode.h"   // x86_fetch_ptr()
 #include "vm/vm.h"
 #include "cpu/x86_cpu.h"
 
 bool x86_fetch8(exec_ctx_t *e, uint8_t *out)
 {
     x86_cpu_t *c = e->cpu;
-    uint32_t a = x86_linear_addr(c->cs, c->ip);
+    const uint8_t *p = x86_fetch_ptr(e, c->cs, c->ip, 1);
 
-	fprintf(stderr, "FETCH8 %04X:%04X -> %02X\n", e->cpu->cs, e->cpu->ip, *out);
-
-    if (!e->vm) return false;
-    if (!vm_read8(e->vm, a, out)) return false;
+    if (p) {
+        *out = *p;
+    } else {
+        if (!e->vm) return false;
+        if (!vm_read8(e->vm, x86_linear_addr(c->cs, c->ip), out)) return false;
+    }
 
     c->ip++;
     return true;
@@ -41,15 +43,51 @@ bool x86_fetch8(exec_ctx_t *e, uint8_t *out)
 bool x86_fetch16(exec_ctx_t *e, uint16_t *out)
 {
     x86_cpu_t *c = e->cpu;
-    uint32_t a = x86_linear_addr(c->cs, c->ip);
+    const uint8_t *p = x86_fetch_ptr(e, c->cs, c->ip, 2);
 
-    if (!e->vm) return false;
-    if (!vm_read16(e->vm, a, out)) return false;
+    if (p) {
+        *out = (uint16_t)(p[0] | (p[1] << 8));
+    } else {
+        // page/segment straddle: two byte fetches keep the IP wrap right
+        uint8_t lo, hi;
+        if (!x86_fetch8(e, &lo) || !x86_fetch8(e, &hi)) return false;
+        *out = (uint16_t)(lo | (hi << 8));
+        return true;
+    }
 
     c->ip = (uint16_t)(c->ip + 2);
     return true;
 }
 
+bool x86_read8(exec_ctx_t *e, uint16_t seg, uint16_t off, uint8_t *out)
+{
+    return vm_read8(e->vm, x86_linear_addr(seg, off), out);
+}
+
+bool x86_read16(exec_ctx_t *e, uint16_t seg, uint16_t off, uint16_t *out)
+{
+    if (off != 0xFFFFu) return vm_read16(e->vm, x86_linear_addr(seg, off), out);
+
+    uint8_t lo, hi;
+    if (!vm_read8(e->vm, x86_linear_addr(seg, 0xFFFFu), &lo) ||
+        !vm_read8(e->vm, x86_linear_addr(seg, 0), &hi)) return false;
+    *out = (uint16_t)(lo | (hi << 8));
+    return true;
+}
+
+bool x86_write8(exec_ctx_t *e, uint16_t seg, uint16_t off, uint8_t val)
+{
+    return vm_write8(e->vm, x86_linear_addr(seg, off), val);
+}
+
+bool x86_write16(exec_ctx_t *e, uint16_t seg, uint16_t off, uint16_t val)
+{
+    if (off != 0xFFFFu) return vm_write16(e->vm, x86_linear_addr(seg, off), val);
+
+    return vm_write8(e->vm, x86_linear_addr(seg, 0xFFFFu), (uint8_t)val) &&
+           vm_write8(e->vm, x86_linear_addr(seg, 0), (uint8_t)(val >> 8));
+}
+
 // 8086-style push: SP -= 2; [SS:SP] = val
 bool x86_push16(exec_ctx_t *e, uint16_t val)
 {
@@ -63,3 +101,16 @@ bool x86_push16(exec_ctx_t *e, uint16_t val)
     return vm_write16(e->vm, a, val);
 }
 
+// 8086-style pop: val = [SS:SP]; SP += 2
+bool x86_pop16(exec_ctx_t *e, uint16_t *out)
+{
+    x86_cpu_t *c = e->cpu;
+
+    if (!e->vm) return false;
+
+    uint32_t a = x86_linear_addr(c->ss, c->sp);
+    if (!vm_read16(e->vm, a, out)) return false;
+
+    c->sp = (uint16_t)(c->sp + 2);
+    return true;
+}
@@ -27,4 +27,11 @@
 bool x86_fetch8 (exec_ctx_t *e, uint8_t  *out);
 bool x86_fetch16(exec_ctx_t *e, uint16_t *out);
 
-bool x86_push16(exec_ctx_t *e, uint16_t val);
\ No newline at end of file
+// Data access at seg:off; a word at offset FFFF wraps inside the segment
+bool x86_read8  (exec_ctx_t *e, uint16_t seg, uint16_t off, uint8_t  *out);
+bool x86_read16 (exec_ctx_t *e, uint16_t seg, uint16_t off, uint16_t *out);
+bool x86_write8 (exec_ctx_t *e, uint16_t seg, uint16_t off, uint8_t  val);
+bool x86_write16(exec_ctx_t *e, uint16_t seg, uint16_t off, uint16_t val);
+
+bool x86_push16(exec_ctx_t *e, uint16_t val);
+bool x86_pop16 (exec_ctx_t *e, uint16_t *out);
\ No newline at end of file
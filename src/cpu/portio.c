@@ -0,0 +1,71 @@
+// src/cpu/portio.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/portio.h"
+#include "cpu/decode.h"
+#include "cpu/x86_cpu.h"
+
+static x86_status_t do_in(exec_ctx_t *e, uint16_t port)
+{
+    x86_cpu_t *c = e->cpu;
+    const bool word = (e->d->op & 1u) != 0;
+
+    e->io.port  = port;
+    e->io.size  = word ? 2 : 1;
+    e->io.in    = true;
+    e->io.value = word ? 0xFFFFu : 0x00FFu;
+
+    if (word) c->ax = 0xFFFFu;
+    else      c->ax = (uint16_t)(c->ax | 0x00FFu);
+    return X86_IO;
+}
+
+static x86_status_t do_out(exec_ctx_t *e, uint16_t port)
+{
+    const x86_cpu_t *c = e->cpu;
+    const bool word = (e->d->op & 1u) != 0;
+
+    e->io.port  = port;
+    e->io.size  = word ? 2 : 1;
+    e->io.in    = false;
+    e->io.value = word ? c->ax : (uint16_t)(c->ax & 0xFFu);
+    return X86_IO;
+}
+
+x86_status_t op_in_imm(exec_ctx_t *e)
+{
+    return do_in(e, (uint8_t)e->d->imm);
+}
+
+x86_status_t op_out_imm(exec_ctx_t *e)
+{
+    return do_out(e, (uint8_t)e->d->imm);
+}
+
+x86_status_t op_in_dx(exec_ctx_t *e)
+{
+    return do_in(e, e->cpu->dx);
+}
+
+x86_status_t op_out_dx(exec_ctx_t *e)
+{
+    return do_out(e, e->cpu->dx);
+}
@@ -0,0 +1,30 @@
+// src/cpu/portio.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+
+// IN/OUT: latch the access in e->io and return X86_IO so the VM run loop
+// can exit to whoever services the port. IN pre-loads AL/AX with the
+// floating-bus value (all ones) in case nobody does.
+x86_status_t op_in_imm(exec_ctx_t *e);    // E4/E5
+x86_status_t op_out_imm(exec_ctx_t *e);   // E6/E7
+x86_status_t op_in_dx(exec_ctx_t *e);     // EC/ED
+x86_status_t op_out_dx(exec_ctx_t *e);    // EE/EF
@@ -0,0 +1,42 @@
+// src/cpu/stack.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/stack.h"
+#include "cpu/memops.h"
+#include "cpu/decode.h"
+#include "cpu/x86_cpu.h"
+
+/* 0x50+r : PUSH r16 (PUSH SP stores the value before the decrement, as on 286+) */
+x86_status_t op_push_r16(exec_ctx_t *e)
+{
+    const uint16_t v = *x86_reg16(e, (unsigned)(e->d->op & 7u));
+    return x86_push16(e, v) ? X86_OK : X86_FAULT;
+}
+
+/* 0x58+r : POP r16 */
+x86_status_t op_pop_r16(exec_ctx_t *e)
+{
+    uint16_t v = 0;
+    if (!x86_pop16(e, &v)) return X86_FAULT;
+
+    *x86_reg16(e, (unsigned)(e->d->op & 7u)) = v;
+    return X86_OK;
+}
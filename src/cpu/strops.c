@@ -0,0 +1,419 @@
+// src/cpu/strops.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cpu/strops.h"
+#include "cpu/decode.h"
+#include "cpu/x86_cpu.h"
+#include "vm/vm.h"
+
+/*
+ * String instructions and the REP engine.
+ *
+ * A REP'd instruction is cut into chunks that stay inside one 4 KiB
+ * page and one 64 KiB segment for every operand. A chunk whose pages
+ * are plain memory (memmap host pointers present) runs as one host
+ * kernel: memmove/memset/memchr/memcmp or a tight loop. Anything else
+ * (MMIO, ROM writes, code pages, unmapped, an element straddling an
+ * edge) is done one element at a time through vm_read/vm_write, which
+ * also restores the fast path for code pages on the first write.
+ *
+ * CX/SI/DI are updated after every chunk, so a fault leaves them at the
+ * first unfinished element with IP back on the instruction. After
+ * X86_REP_SLICE elements the instruction also yields the same way so the
+ * run loop can service budget, breakpoints and I/O; REP string ops end
+ * their cache block (X86_OPF_STRING) so the restart is picked up.
+ */
+
+#ifndef X86_REP_SLICE
+#define X86_REP_SLICE 16384u    // elements per dispatch before yielding
+#endif
+
+/* ============================================================
+ * element helpers
+ * ============================================================ */
+
+/* SI/DI step for one element: DF=0 counts up, DF=1 down */
+static inline uint16_t str_step(const x86_cpu_t *c, unsigned size)
+{
+    return (c->flags & X86_FL_DF) ? (uint16_t)-(int)size : (uint16_t)size;
+}
+
+/* Elements from seg:off, moving down or up, that stay inside both the
+   segment and the current page; 0 if the first one straddles an edge. */
+static uint32_t str_span(uint16_t seg, uint16_t off, unsigned size, bool down)
+{
+    const uint32_t in_pg = x86_linear_addr(seg, off) & MM_PAGE_MASK;
+    uint32_t seg_n, pg_n;
+
+    if ((uint32_t)off + size > 0x10000u || in_pg + size > MM_PAGE_SIZE) return 0;
+
+    if (down) {
+        seg_n = off / size + 1u;
+        pg_n  = in_pg / size + 1u;
+    } else {
+        seg_n = (0x10000u - off) / size;
+        pg_n  = (MM_PAGE_SIZE - in_pg) / size;
+    }
+    return seg_n < pg_n ? seg_n : pg_n;
+}
+
+/* Lowest host byte of a k-element chunk whose first element is at p */
+static inline uint8_t *chunk_lo(uint8_t *p, uint32_t k, unsigned size, bool down)
+{
+    return down ? p - (size_t)(k - 1u) * size : p;
+}
+
+static bool rd_elem(exec_ctx_t *e, uint16_t seg, uint16_t off, unsigned size, uint16_t *v)
+{
+    uint8_t lo = 0, hi = 0;
+
+    if (!vm_read8(e->vm, x86_linear_addr(seg, off), &lo)) return false;
+    if (size == 2 && !vm_read8(e->vm, x86_linear_addr(seg, (uint16_t)(off + 1u)), &hi)) return false;
+    *v = (uint16_t)(lo | (hi << 8));
+    return true;
+}
+
+static bool wr_elem(exec_ctx_t *e, uint16_t seg, uint16_t off, unsigned size, uint16_t v)
+{
+    if (!vm_write8(e->vm, x86_linear_addr(seg, off), (uint8_t)v)) return false;
+    if (size == 2 && !vm_write8(e->vm, x86_linear_addr(seg, (uint16_t)(off + 1u)), (uint8_t)(v >> 8))) return false;
+    return true;
+}
+
+static inline uint16_t host_elem(const uint8_t *p, unsigned size)
+{
+    return size == 1 ? p[0] : (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* ============================================================
+ * REP bookkeeping
+ * ============================================================ */
+
+typedef struct str_run {
+    exec_ctx_t *e;
+    x86_cpu_t  *c;
+    unsigned    size;       // 1 or 2
+    bool        rep;        // F2/F3 present
+    bool        down;       // DF
+    uint16_t    step;       // +size / -size
+    uint32_t    left;       // elements still to do in this dispatch
+} str_run_t;
+
+static bool run_begin(str_run_t *r, exec_ctx_t *e, unsigned size)
+{
+    vm_stats_t *st = &e->vm->stats;
+    r->e    = e;
+    r->c    = e->cpu;
+    r->size = size;
+    r->rep  = (e->d->pfx & (X86_PFX_REP | X86_PFX_REPNE)) != 0;
+    r->down = (r->c->flags & X86_FL_DF) != 0;
+    r->step = str_step(r->c, size);
+
+    if (!r->rep) r->left = 1;
+    else r->left = r->c->cx < X86_REP_SLICE ? r->c->cx : X86_REP_SLICE;
+
+    if (st->on && r->rep) st->rep_insns++;
+    return r->left != 0;
+}
+
+/* k elements done: CX follows under REP */
+static inline void run_done(str_run_t *r, uint32_t k)
+{
+    r->left -= k;
+    if (!r->rep) return;
+    r->c->cx = (uint16_t)(r->c->cx - k);
+    if (r->e->vm->stats.on) r->e->vm->stats.rep_iters += k;
+}
+
+/* Leaving with REP work outstanding (slice used up, or a fault part way
+   through): IP goes back on the instruction so the next dispatch resumes
+   from the CX/SI/DI already stored. */
+static x86_status_t run_end(str_run_t *r, x86_status_t st)
+{
+    if (r->rep && r->c->cx != 0) r->c->ip = r->e->d->start_ip;
+    return st;
+}
+
+static inline uint32_t min3(uint32_t a, uint32_t b, uint32_t c)
+{
+    uint32_t m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+/* ============================================================
+ * MOVS / STOS / LODS
+ * ============================================================ */
+
+static x86_status_t do_movs(exec_ctx_t *e, unsigned size)
+{
+    str_run_t r;
+    if (!run_begin(&r, e, size)) return X86_OK;
+
+    x86_cpu_t *c = r.c;
+    const uint16_t sseg = x86_data_seg(c, e->d);
+
+    while (r.left) {
+        uint32_t k = min3(r.left, str_span(sseg, c->si, size, r.down), str_span(c->es, c->di, size, r.down));
+        uint8_t *s = k ? mm_rd_ptr(&e->vm->mm, x86_linear_addr(sseg, c->si)) : NULL;
+        uint8_t *d = k ? mm_wr_ptr(&e->vm->mm, x86_linear_addr(c->es, c->di)) : NULL;
+
+        if (!s || !d) {
+            uint16_t v;
+            if (!rd_elem(e, sseg, c->si, size, &v) || !wr_elem(e, c->es, c->di, size, v))
+                return run_end(&r, X86_FAULT);
+            k = 1;
+        } else {
+            const size_t bytes = (size_t)k * size;
+            uint8_t *slo = chunk_lo(s, k, size, r.down);
+            uint8_t *dlo = chunk_lo(d, k, size, r.down);
+            const uintptr_t su = (uintptr_t)slo, du = (uintptr_t)dlo;
+            const bool overlap = du < su + bytes && su < du + bytes;
+
+            // Element order only shows when the writes run ahead into
+            // source bytes not read yet (e.g. MOVSB with DI = SI + 1).
+            // Each element is read whole before it is written, as on
+            // hardware: MOVSW with DI = SI + 1 overlaps inside a word.
+            if (overlap && (r.down ? du < su : du > su)) {
+                for (uint32_t i = 0; i < k; i++) {
+                    const size_t o = r.down ? (size_t)(k - 1u - i) * size : (size_t)i * size;
+                    const uint8_t lo = slo[o], hi = size == 2 ? slo[o + 1] : 0;
+                    dlo[o] = lo;
+                    if (size == 2) dlo[o + 1] = hi;
+                }
+            } else {
+                memmove(dlo, slo, bytes);
+            }
+        }
+        c->si = (uint16_t)(c->si + r.step * k);
+        c->di = (uint16_t)(c->di + r.step * k);
+        run_done(&r, k);
+    }
+    return run_end(&r, X86_OK);
+}
+
+static x86_status_t do_stos(exec_ctx_t *e, unsigned size)
+{
+    str_run_t r;
+    if (!run_begin(&r, e, size)) return X86_OK;
+
+    x86_cpu_t *c = r.c;
+    const uint16_t v = size == 1 ? (uint16_t)(c->ax & 0xFFu) : c->ax;
+
+    while (r.left) {
+        uint32_t k = r.left;
+        const uint32_t span = str_span(c->es, c->di, size, r.down);
+        if (span < k) k = span;
+        uint8_t *d = k ? mm_wr_ptr(&e->vm->mm, x86_linear_addr(c->es, c->di)) : NULL;
+
+        if (!d) {
+            if (!wr_elem(e, c->es, c->di, size, v)) return run_end(&r, X86_FAULT);
+            k = 1;
+        } else {
+            uint8_t *lo = chunk_lo(d, k, size, r.down);
+            if (size == 1 || (v & 0xFFu) == (v >> 8)) {
+                memset(lo, (int)(v & 0xFFu), (size_t)k * size);
+            } else {
+                for (uint32_t i = 0; i < k; i++) {
+                    lo[2 * i]     = (uint8_t)v;
+                    lo[2 * i + 1] = (uint8_t)(v >> 8);
+                }
+            }
+        }
+        c->di = (uint16_t)(c->di + r.step * k);
+        run_done(&r, k);
+    }
+    return run_end(&r, X86_OK);
+}
+
+/* LODS: only the last element of a chunk reaches the accumulator, so a
+   plain-memory chunk is one read (MMIO still goes element by element). */
+static x86_status_t do_lods(exec_ctx_t *e, unsigned size)
+{
+    str_run_t r;
+    if (!run_begin(&r, e, size)) return X86_OK;
+
+    x86_cpu_t *c = r.c;
+    const uint16_t sseg = x86_data_seg(c, e->d);
+
+    while (r.left) {
+        uint32_t k = r.left;
+        const uint32_t span = str_span(sseg, c->si, size, r.down);
+        if (span < k) k = span;
+        const uint8_t *s = k ? mm_rd_ptr(&e->vm->mm, x86_linear_addr(sseg, c->si)) : NULL;
+        uint16_t v = 0;
+
+        if (!s) {
+            if (!rd_elem(e, sseg, c->si, size, &v)) return run_end(&r, X86_FAULT);
+            k = 1;
+        } else {
+            const ptrdiff_t last = (ptrdiff_t)(k - 1u) * (r.down ? -(ptrdiff_t)size : (ptrdiff_t)size);
+            v = host_elem(s + last, size);
+        }
+        c->ax = size == 1 ? (uint16_t)((c->ax & 0xFF00u) | v) : v;
+        c->si = (uint16_t)(c->si + r.step * k);
+        run_done(&r, k);
+    }
+    return run_end(&r, X86_OK);
+}
+
+/* ============================================================
+ * SCAS / CMPS
+ *
+ * REPE (F3) continues while equal, REPNE (F2) while different. Flags
+ * come from the last comparison only: one lazy SUB record at the end.
+ * ============================================================ */
+
+/* First index in [0,k) where (elements equal) == stop_when_equal */
+static uint32_t scan_host(const uint8_t *p, uint32_t k, unsigned size, bool down,
+                          uint16_t v, bool stop_when_equal)
+{
+    if (size == 1 && !down && stop_when_equal) {
+        const uint8_t *hit = (const uint8_t*)memchr(p, (int)v, k);
+        return hit ? (uint32_t)(hit - p) : k;
+    }
+    for (uint32_t i = 0; i < k; i++) {
+        const ptrdiff_t o = (ptrdiff_t)i * (down ? -(ptrdiff_t)size : (ptrdiff_t)size);
+        if ((host_elem(p + o, size) == v) == stop_when_equal) return i;
+    }
+    return k;
+}
+
+static x86_status_t do_scas(exec_ctx_t *e, unsigned size)
+{
+    str_run_t r;
+    if (!run_begin(&r, e, size)) return X86_OK;
+
+    x86_cpu_t *c = r.c;
+    const uint16_t acc = size == 1 ? (uint16_t)(c->ax & 0xFFu) : c->ax;
+    const bool repne = (e->d->pfx & X86_PFX_REPNE) != 0;
+    uint16_t last = 0;
+    bool stop = false;
+
+    while (r.left && !stop) {
+        uint32_t k = r.left;
+        const uint32_t span = str_span(c->es, c->di, size, r.down);
+        if (span < k) k = span;
+        const uint8_t *p = k ? mm_rd_ptr(&e->vm->mm, x86_linear_addr(c->es, c->di)) : NULL;
+
+        if (!p) {
+            if (!rd_elem(e, c->es, c->di, size, &last)) return run_end(&r, X86_FAULT);
+            k = 1;
+            stop = r.rep && ((last == acc) == repne);
+        } else if (!r.rep) {
+            last = host_elem(p, size);
+            k = 1;
+        } else {
+            const uint32_t i = scan_host(p, k, size, r.down, acc, repne);
+            stop = i < k;
+            k = stop ? i + 1u : k;
+            last = host_elem(p + (ptrdiff_t)(k - 1u) * (r.down ? -(ptrdiff_t)size : (ptrdiff_t)size), size);
+        }
+        c->di = (uint16_t)(c->di + r.step * k);
+        run_done(&r, k);
+    }
+
+    x86_lazy_flags(c, X86_LF_SUB, (uint8_t)(size * 8u), acc, last, (uint16_t)(acc - last));
+    if (stop) return X86_OK;    // ended by the REPE/REPNE condition
+    return run_end(&r, X86_OK);
+}
+
+static x86_status_t do_cmps(exec_ctx_t *e, unsigned size)
+{
+    str_run_t r;
+    if (!run_begin(&r, e, size)) return X86_OK;
+
+    x86_cpu_t *c = r.c;
+    const uint16_t sseg = x86_data_seg(c, e->d);
+    const bool repne = (e->d->pfx & X86_PFX_REPNE) != 0;
+    uint16_t a = 0, b = 0;
+    bool stop = false;
+
+    while (r.left && !stop) {
+        uint32_t k = min3(r.left, str_span(sseg, c->si, size, r.down), str_span(c->es, c->di, size, r.down));
+        const uint8_t *s = k ? mm_rd_ptr(&e->vm->mm, x86_linear_addr(sseg, c->si)) : NULL;
+        const uint8_t *d = k ? mm_rd_ptr(&e->vm->mm, x86_linear_addr(c->es, c->di)) : NULL;
+
+        if (!s || !d || !r.rep) {
+            if (!rd_elem(e, sseg, c->si, size, &a) || !rd_elem(e, c->es, c->di, size, &b))
+                return run_end(&r, X86_FAULT);
+            k = 1;
+            stop = r.rep && ((a == b) == repne);
+        } else {
+            const ptrdiff_t dir = r.down ? -(ptrdiff_t)size : (ptrdiff_t)size;
+            uint32_t i = 0;
+
+            // REPE forward: skip equal chunks wholesale
+            if (!repne && !r.down && memcmp(s, d, (size_t)k * size) == 0) {
+                i = k;
+            } else {
+                while (i < k && ((host_elem(s + (ptrdiff_t)i * dir, size) ==
+                                  host_elem(d + (ptrdiff_t)i * dir, size)) != repne)) i++;
+            }
+            stop = i < k;
+            k = stop ? i + 1u : k;
+            a = host_elem(s + (ptrdiff_t)(k - 1u) * dir, size);
+            b = host_elem(d + (ptrdiff_t)(k - 1u) * dir, size);
+        }
+        c->si = (uint16_t)(c->si + r.step * k);
+        c->di = (uint16_t)(c->di + r.step * k);
+        run_done(&r, k);
+    }
+
+    x86_lazy_flags(c, X86_LF_SUB, (uint8_t)(size * 8u), a, b, (uint16_t)(a - b));
+    if (stop) return X86_OK;
+    return run_end(&r, X86_OK);
+}
+
+/* ============================================================
+ * handlers
+ * ============================================================ */
+
+/* 0xA4 : MOVSB */
+x86_status_t op_movsb(exec_ctx_t *e) { return do_movs(e, 1); }
+
+/* 0xA5 : MOVSW */
+x86_status_t op_movsw(exec_ctx_t *e) { return do_movs(e, 2); }
+
+/* 0xA6 : CMPSB */
+x86_status_t op_cmpsb(exec_ctx_t *e) { return do_cmps(e, 1); }
+
+/* 0xA7 : CMPSW */
+x86_status_t op_cmpsw(exec_ctx_t *e) { return do_cmps(e, 2); }
+
+/* 0xAA : STOSB */
+x86_status_t op_stosb(exec_ctx_t *e) { return do_stos(e, 1); }
+
+/* 0xAB : STOSW */
+x86_status_t op_stosw(exec_ctx_t *e) { return do_stos(e, 2); }
+
+/* 0xAC : LODSB */
+x86_status_t op_lodsb(exec_ctx_t *e) { return do_lods(e, 1); }
+
+/* 0xAD : LODSW */
+x86_status_t op_lodsw(exec_ctx_t *e) { return do_lods(e, 2); }
+
+/* 0xAE : SCASB */
+x86_status_t op_scasb(exec_ctx_t *e) { return do_scas(e, 1); }
+
+/* 0xAF : SCASW */
+x86_status_t op_scasw(exec_ctx_t *e) { return do_scas(e, 2); }
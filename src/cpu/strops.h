@@ -0,0 +1,34 @@
+// src/cpu/strops.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "cpu/exec_ctx.h"
+#include "cpu/cpu_types.h"
+
+// String instruction handlers (REP/REPE/REPNE aware)
+x86_status_t op_movsb(exec_ctx_t *e);      // A4
+x86_status_t op_movsw(exec_ctx_t *e);      // A5
+x86_status_t op_cmpsb(exec_ctx_t *e);      // A6
+x86_status_t op_cmpsw(exec_ctx_t *e);      // A7
+x86_status_t op_stosb(exec_ctx_t *e);      // AA
+x86_status_t op_stosw(exec_ctx_t *e);      // AB
+x86_status_t op_lodsb(exec_ctx_t *e);      // AC
+x86_status_t op_lodsw(exec_ctx_t *e);      // AD
+x86_status_t op_scasb(exec_ctx_t *e);      // AE
+x86_status_t op_scasw(exec_ctx_t *e);      // AF
@@ -25,72 +25,555 @@
 #include "cpu/memops.h"
 #include "cpu/x86_cpu.h"
 #include "cpu/logic.h"
+#include "cpu/alu.h"
+#include "cpu/stack.h"
+#include "cpu/strops.h"
+#include "cpu/interrupt.h"
+#include "cpu/portio.h"
+#include "cpu/flags.h"
+#include "cpu/branch.h"
 #include "cpu/cpu_types.h"
 #include "cpu/exec_ctx.h"
 
-#include "vm/vm.h"   // vm_read8()
-
-// PEEK a byte at seg:off without advancing IP.
-static bool peek8(exec_ctx_t *e, uint16_t seg, uint16_t off, uint8_t *out)
-{
-    if (!e || !e->cpu || !out) return false;
-
-    const uint32_t lin = x86_linear_addr(seg, off);
-
-    // Preferred path: VM owns memory.
-    if (e->vm) {
-        return vm_read8(e->vm, lin, out);
-    }
-
-    // Fallback: transitional CPU-backed memory.
-    x86_cpu_t *c = e->cpu;
-    if (!c->mem) return false;
-    if (lin >= (uint32_t)c->mem_size) return false;
-
-    *out = c->mem[lin];
-    return true;
-}
-
 // --- tiny handlers (keep local) ---
 
 static x86_status_t op_unknown(exec_ctx_t *e) {
-    uint8_t op = 0;
-    (void)x86_fetch8(e, &op);   // consume 1 byte so we don't spin forever
+    (void)e;
     return X86_ILLEGAL;
 }
 
 static x86_status_t op_nop(exec_ctx_t *e) {
-    uint8_t op = 0;
-    if (!x86_fetch8(e, &op)) return X86_FAULT;  // consume 0x90
+    (void)e;
     return X86_OK;
 }
 
 static x86_status_t op_hlt(exec_ctx_t *e) {
-    uint8_t op = 0;
-    if (!x86_fetch8(e, &op)) return X86_FAULT;  // consume 0xF4
+    e->cpu->halted = true;
     return X86_HALT;
 }
 
-/*
- * Minimal decoder:
- *  - peek opcode (do not advance IP)
- *  - return handler
- */
-x86_fn_t x86_decode_ctx(exec_ctx_t *e)
-{
-    uint8_t op = 0;
-
-    // PEEK opcode at CS:IP (do NOT advance IP here)
-    if (!peek8(e, e->cpu->cs, e->cpu->ip, &op)) return op_unknown;
-
-    // Minimal “switch decoder” (good enough until the table is populated)
-    if (op == 0x83) return handle_grp1_83;
+/* ============================================================
+ * Opcode tables
+ *  { handler, immediate bytes, X86_OPF_* }
+ * Immediate bytes include moffs/far-pointer operands; any ModRM
+ * displacement is implied by the ModRM byte itself. Prefix rows are
+ * consumed by x86_decode() and never dispatched.
+ * ============================================================ */
 
-    if (op >= 0xB8 && op <= 0xBF) return op_mov_r16_imm16;
+const x86_opent_t x86_optab[256] = {
+    /* 00 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // add r/m8, r8
+    /* 01 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // add r/m16, r16
+    /* 02 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // add r8, r/m8
+    /* 03 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // add r16, r/m16
+    /* 04 */ { op_alu, 1, X86_OPF_ALU },                          // add al, imm8
+    /* 05 */ { op_alu, 2, X86_OPF_ALU },                          // add ax, imm16
+    /* 06 */ { op_unknown, 0, 0 },                                // push es
+    /* 07 */ { op_unknown, 0, 0 },                                // pop es
+    /* 08 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // or r/m8, r8
+    /* 09 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // or r/m16, r16
+    /* 0A */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // or r8, r/m8
+    /* 0B */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // or r16, r/m16
+    /* 0C */ { op_alu, 1, X86_OPF_ALU },                          // or al, imm8
+    /* 0D */ { op_alu, 2, X86_OPF_ALU },                          // or ax, imm16
+    /* 0E */ { op_unknown, 0, 0 },                                // push cs
+    /* 0F */ { op_unknown, 0, X86_OPF_ESC },                      // two-byte escape
+    /* 10 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // adc r/m8, r8
+    /* 11 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // adc r/m16, r16
+    /* 12 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // adc r8, r/m8
+    /* 13 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // adc r16, r/m16
+    /* 14 */ { op_alu, 1, X86_OPF_ALU },                          // adc al, imm8
+    /* 15 */ { op_alu, 2, X86_OPF_ALU },                          // adc ax, imm16
+    /* 16 */ { op_unknown, 0, 0 },                                // push ss
+    /* 17 */ { op_unknown, 0, 0 },                                // pop ss
+    /* 18 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sbb r/m8, r8
+    /* 19 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sbb r/m16, r16
+    /* 1A */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sbb r8, r/m8
+    /* 1B */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sbb r16, r/m16
+    /* 1C */ { op_alu, 1, X86_OPF_ALU },                          // sbb al, imm8
+    /* 1D */ { op_alu, 2, X86_OPF_ALU },                          // sbb ax, imm16
+    /* 1E */ { op_unknown, 0, 0 },                                // push ds
+    /* 1F */ { op_unknown, 0, 0 },                                // pop ds
+    /* 20 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // and r/m8, r8
+    /* 21 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // and r/m16, r16
+    /* 22 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // and r8, r/m8
+    /* 23 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // and r16, r/m16
+    /* 24 */ { op_alu, 1, X86_OPF_ALU },                          // and al, imm8
+    /* 25 */ { op_alu, 2, X86_OPF_ALU },                          // and ax, imm16
+    /* 26 */ { op_unknown, 0, X86_OPF_PREFIX },                    // es: override
+    /* 27 */ { op_unknown, 0, 0 },                                // daa
+    /* 28 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sub r/m8, r8
+    /* 29 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sub r/m16, r16
+    /* 2A */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sub r8, r/m8
+    /* 2B */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // sub r16, r/m16
+    /* 2C */ { op_alu, 1, X86_OPF_ALU },                          // sub al, imm8
+    /* 2D */ { op_alu, 2, X86_OPF_ALU },                          // sub ax, imm16
+    /* 2E */ { op_unknown, 0, X86_OPF_PREFIX },                    // cs: override
+    /* 2F */ { op_unknown, 0, 0 },                                // das
+    /* 30 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // xor r/m8, r8
+    /* 31 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // xor r/m16, r16
+    /* 32 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // xor r8, r/m8
+    /* 33 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // xor r16, r/m16
+    /* 34 */ { op_alu, 1, X86_OPF_ALU },                          // xor al, imm8
+    /* 35 */ { op_alu, 2, X86_OPF_ALU },                          // xor ax, imm16
+    /* 36 */ { op_unknown, 0, X86_OPF_PREFIX },                    // ss: override
+    /* 37 */ { op_unknown, 0, 0 },                                // aaa
+    /* 38 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // cmp r/m8, r8
+    /* 39 */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // cmp r/m16, r16
+    /* 3A */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // cmp r8, r/m8
+    /* 3B */ { op_alu, 0, X86_OPF_MODRM | X86_OPF_ALU },          // cmp r16, r/m16
+    /* 3C */ { op_alu, 1, X86_OPF_ALU },                          // cmp al, imm8
+    /* 3D */ { op_alu, 2, X86_OPF_ALU },                          // cmp ax, imm16
+    /* 3E */ { op_unknown, 0, X86_OPF_PREFIX },                    // ds: override
+    /* 3F */ { op_unknown, 0, 0 },                                // aas
+    /* 40 */ { op_inc_r16, 0, 0 },                                // inc ax
+    /* 41 */ { op_inc_r16, 0, 0 },                                // inc cx
+    /* 42 */ { op_inc_r16, 0, 0 },                                // inc dx
+    /* 43 */ { op_inc_r16, 0, 0 },                                // inc bx
+    /* 44 */ { op_inc_r16, 0, 0 },                                // inc sp
+    /* 45 */ { op_inc_r16, 0, 0 },                                // inc bp
+    /* 46 */ { op_inc_r16, 0, 0 },                                // inc si
+    /* 47 */ { op_inc_r16, 0, 0 },                                // inc di
+    /* 48 */ { op_dec_r16, 0, 0 },                                // dec ax
+    /* 49 */ { op_dec_r16, 0, 0 },                                // dec cx
+    /* 4A */ { op_dec_r16, 0, 0 },                                // dec dx
+    /* 4B */ { op_dec_r16, 0, 0 },                                // dec bx
+    /* 4C */ { op_dec_r16, 0, 0 },                                // dec sp
+    /* 4D */ { op_dec_r16, 0, 0 },                                // dec bp
+    /* 4E */ { op_dec_r16, 0, 0 },                                // dec si
+    /* 4F */ { op_dec_r16, 0, 0 },                                // dec di
+    /* 50 */ { op_push_r16, 0, 0 },                               // push ax
+    /* 51 */ { op_push_r16, 0, 0 },                               // push cx
+    /* 52 */ { op_push_r16, 0, 0 },                               // push dx
+    /* 53 */ { op_push_r16, 0, 0 },                               // push bx
+    /* 54 */ { op_push_r16, 0, 0 },                               // push sp
+    /* 55 */ { op_push_r16, 0, 0 },                               // push bp
+    /* 56 */ { op_push_r16, 0, 0 },                               // push si
+    /* 57 */ { op_push_r16, 0, 0 },                               // push di
+    /* 58 */ { op_pop_r16, 0, 0 },                                // pop ax
+    /* 59 */ { op_pop_r16, 0, 0 },                                // pop cx
+    /* 5A */ { op_pop_r16, 0, 0 },                                // pop dx
+    /* 5B */ { op_pop_r16, 0, 0 },                                // pop bx
+    /* 5C */ { op_pop_r16, 0, 0 },                                // pop sp
+    /* 5D */ { op_pop_r16, 0, 0 },                                // pop bp
+    /* 5E */ { op_pop_r16, 0, 0 },                                // pop si
+    /* 5F */ { op_pop_r16, 0, 0 },                                // pop di
+    /* 60 */ { op_unknown, 0, 0 },                                // pusha
+    /* 61 */ { op_unknown, 0, 0 },                                // popa
+    /* 62 */ { op_unknown, 0, X86_OPF_MODRM },                    // bound
+    /* 63 */ { op_unknown, 0, X86_OPF_MODRM },                    // arpl
+    /* 64 */ { op_unknown, 0, X86_OPF_PREFIX },                    // fs: override
+    /* 65 */ { op_unknown, 0, X86_OPF_PREFIX },                    // gs: override
+    /* 66 */ { op_unknown, 0, X86_OPF_PREFIX },                    // operand-size
+    /* 67 */ { op_unknown, 0, X86_OPF_PREFIX },                    // address-size
+    /* 68 */ { op_unknown, 2, 0 },                                // push imm16
+    /* 69 */ { op_unknown, 2, X86_OPF_MODRM },                    // imul r16, r/m16, imm16
+    /* 6A */ { op_unknown, 1, 0 },                                // push imm8
+    /* 6B */ { op_unknown, 1, X86_OPF_MODRM },                    // imul r16, r/m16, imm8
+    /* 6C */ { op_unknown, 0, 0 },                                // insb
+    /* 6D */ { op_unknown, 0, 0 },                                // insw
+    /* 6E */ { op_unknown, 0, 0 },                                // outsb
+    /* 6F */ { op_unknown, 0, 0 },                                // outsw
+    /* 70 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jo rel8
+    /* 71 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jno rel8
+    /* 72 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jc rel8
+    /* 73 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jnc rel8
+    /* 74 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jz rel8
+    /* 75 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jnz rel8
+    /* 76 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jbe rel8
+    /* 77 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // ja rel8
+    /* 78 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // js rel8
+    /* 79 */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jns rel8
+    /* 7A */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jp rel8
+    /* 7B */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jnp rel8
+    /* 7C */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jl rel8
+    /* 7D */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jge rel8
+    /* 7E */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jle rel8
+    /* 7F */ { op_jcc_rel8, 1, X86_OPF_BRANCH },                  // jg rel8
+    /* 80 */ { op_alu, 1, X86_OPF_MODRM | X86_OPF_ALU },          // grp1 r/m8, imm8
+    /* 81 */ { op_alu, 2, X86_OPF_MODRM | X86_OPF_ALU },          // grp1 r/m16, imm16
+    /* 82 */ { op_alu, 1, X86_OPF_MODRM | X86_OPF_ALU },          // grp1 r/m8, imm8 (alias)
+    /* 83 */ { op_alu, 1, X86_OPF_MODRM | X86_OPF_ALU },          // grp1 r/m16, simm8
+    /* 84 */ { op_test_rm8_r8, 0, X86_OPF_MODRM },                // test r/m8, r8
+    /* 85 */ { op_test_rm16_r16, 0, X86_OPF_MODRM },              // test r/m16, r16
+    /* 86 */ { op_unknown, 0, X86_OPF_MODRM },                    // xchg r/m8, r8
+    /* 87 */ { op_unknown, 0, X86_OPF_MODRM },                    // xchg r/m16, r16
+    /* 88 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r/m8, r8
+    /* 89 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r/m16, r16
+    /* 8A */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r8, r/m8
+    /* 8B */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r16, r/m16
+    /* 8C */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r/m16, sreg
+    /* 8D */ { op_unknown, 0, X86_OPF_MODRM },                    // lea r16, m
+    /* 8E */ { op_unknown, 0, X86_OPF_MODRM },                    // mov sreg, r/m16
+    /* 8F */ { op_unknown, 0, X86_OPF_MODRM },                    // pop r/m16
+    /* 90 */ { op_nop, 0, 0 },                                    // nop
+    /* 91 */ { op_unknown, 0, 0 },                                // xchg ax, cx
+    /* 92 */ { op_unknown, 0, 0 },                                // xchg ax, dx
+    /* 93 */ { op_unknown, 0, 0 },                                // xchg ax, bx
+    /* 94 */ { op_unknown, 0, 0 },                                // xchg ax, sp
+    /* 95 */ { op_unknown, 0, 0 },                                // xchg ax, bp
+    /* 96 */ { op_unknown, 0, 0 },                                // xchg ax, si
+    /* 97 */ { op_unknown, 0, 0 },                                // xchg ax, di
+    /* 98 */ { op_unknown, 0, 0 },                                // cbw
+    /* 99 */ { op_unknown, 0, 0 },                                // cwd
+    /* 9A */ { op_unknown, 4, X86_OPF_BRANCH },                   // call far ptr16:16
+    /* 9B */ { op_unknown, 0, 0 },                                // wait
+    /* 9C */ { op_pushf, 0, 0 },                                  // pushf
+    /* 9D */ { op_popf, 0, 0 },                                   // popf
+    /* 9E */ { op_sahf, 0, 0 },                                   // sahf
+    /* 9F */ { op_lahf, 0, 0 },                                   // lahf
+    /* A0 */ { op_unknown, 2, 0 },                                // mov al, moffs
+    /* A1 */ { op_unknown, 2, 0 },                                // mov ax, moffs
+    /* A2 */ { op_unknown, 2, 0 },                                // mov moffs, al
+    /* A3 */ { op_unknown, 2, 0 },                                // mov moffs, ax
+    /* A4 */ { op_movsb, 0, X86_OPF_STRING },                     // movsb
+    /* A5 */ { op_movsw, 0, X86_OPF_STRING },                     // movsw
+    /* A6 */ { op_cmpsb, 0, X86_OPF_STRING },                     // cmpsb
+    /* A7 */ { op_cmpsw, 0, X86_OPF_STRING },                     // cmpsw
+    /* A8 */ { op_unknown, 1, 0 },                                // test al, imm8
+    /* A9 */ { op_unknown, 2, 0 },                                // test ax, imm16
+    /* AA */ { op_stosb, 0, X86_OPF_STRING },                     // stosb
+    /* AB */ { op_stosw, 0, X86_OPF_STRING },                     // stosw
+    /* AC */ { op_lodsb, 0, X86_OPF_STRING },                     // lodsb
+    /* AD */ { op_lodsw, 0, X86_OPF_STRING },                     // lodsw
+    /* AE */ { op_scasb, 0, X86_OPF_STRING },                     // scasb
+    /* AF */ { op_scasw, 0, X86_OPF_STRING },                     // scasw
+    /* B0 */ { op_unknown, 1, 0 },                                // mov al, imm8
+    /* B1 */ { op_unknown, 1, 0 },                                // mov cl, imm8
+    /* B2 */ { op_unknown, 1, 0 },                                // mov dl, imm8
+    /* B3 */ { op_unknown, 1, 0 },                                // mov bl, imm8
+    /* B4 */ { op_unknown, 1, 0 },                                // mov ah, imm8
+    /* B5 */ { op_unknown, 1, 0 },                                // mov ch, imm8
+    /* B6 */ { op_unknown, 1, 0 },                                // mov dh, imm8
+    /* B7 */ { op_unknown, 1, 0 },                                // mov bh, imm8
+    /* B8 */ { op_mov_r16_imm16, 2, 0 },                          // mov ax, imm16
+    /* B9 */ { op_mov_r16_imm16, 2, 0 },                          // mov cx, imm16
+    /* BA */ { op_mov_r16_imm16, 2, 0 },                          // mov dx, imm16
+    /* BB */ { op_mov_r16_imm16, 2, 0 },                          // mov bx, imm16
+    /* BC */ { op_mov_r16_imm16, 2, 0 },                          // mov sp, imm16
+    /* BD */ { op_mov_r16_imm16, 2, 0 },                          // mov bp, imm16
+    /* BE */ { op_mov_r16_imm16, 2, 0 },                          // mov si, imm16
+    /* BF */ { op_mov_r16_imm16, 2, 0 },                          // mov di, imm16
+    /* C0 */ { op_unknown, 1, X86_OPF_MODRM },                    // grp2 r/m8, imm8
+    /* C1 */ { op_unknown, 1, X86_OPF_MODRM },                    // grp2 r/m16, imm8
+    /* C2 */ { op_ret_near, 2, X86_OPF_BRANCH },                  // ret imm16
+    /* C3 */ { op_ret_near, 0, X86_OPF_BRANCH },                  // ret
+    /* C4 */ { op_unknown, 0, X86_OPF_MODRM },                    // les r16, m
+    /* C5 */ { op_unknown, 0, X86_OPF_MODRM },                    // lds r16, m
+    /* C6 */ { op_unknown, 1, X86_OPF_MODRM },                    // mov r/m8, imm8
+    /* C7 */ { op_unknown, 2, X86_OPF_MODRM },                    // mov r/m16, imm16
+    /* C8 */ { op_unknown, 3, 0 },                                // enter imm16, imm8
+    /* C9 */ { op_unknown, 0, 0 },                                // leave
+    /* CA */ { op_unknown, 2, X86_OPF_BRANCH },                   // retf imm16
+    /* CB */ { op_unknown, 0, X86_OPF_BRANCH },                   // retf
+    /* CC */ { op_unknown, 0, X86_OPF_BRANCH },                   // int3
+    /* CD */ { handle_int_cd, 1, X86_OPF_BRANCH },                // int imm8
+    /* CE */ { op_unknown, 0, X86_OPF_BRANCH },                   // into
+    /* CF */ { op_iret, 0, X86_OPF_BRANCH },                      // iret
+    /* D0 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp2 r/m8, 1
+    /* D1 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp2 r/m16, 1
+    /* D2 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp2 r/m8, cl
+    /* D3 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp2 r/m16, cl
+    /* D4 */ { op_unknown, 1, 0 },                                // aam imm8
+    /* D5 */ { op_unknown, 1, 0 },                                // aad imm8
+    /* D6 */ { op_unknown, 0, 0 },                                // salc
+    /* D7 */ { op_unknown, 0, 0 },                                // xlat
+    /* D8 */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 0 (fpu)
+    /* D9 */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 1 (fpu)
+    /* DA */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 2 (fpu)
+    /* DB */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 3 (fpu)
+    /* DC */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 4 (fpu)
+    /* DD */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 5 (fpu)
+    /* DE */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 6 (fpu)
+    /* DF */ { op_unknown, 0, X86_OPF_MODRM },                    // esc 7 (fpu)
+    /* E0 */ { op_unknown, 1, X86_OPF_BRANCH },                   // loopnz rel8
+    /* E1 */ { op_unknown, 1, X86_OPF_BRANCH },                   // loopz rel8
+    /* E2 */ { op_loop, 1, X86_OPF_BRANCH },                      // loop rel8
+    /* E3 */ { op_unknown, 1, X86_OPF_BRANCH },                   // jcxz rel8
+    /* E4 */ { op_in_imm, 1, 0 },                                 // in al, imm8
+    /* E5 */ { op_in_imm, 1, 0 },                                 // in ax, imm8
+    /* E6 */ { op_out_imm, 1, 0 },                                // out imm8, al
+    /* E7 */ { op_out_imm, 1, 0 },                                // out imm8, ax
+    /* E8 */ { op_call_rel16, 2, X86_OPF_BRANCH },                // call rel16
+    /* E9 */ { op_jmp_rel16, 2, X86_OPF_BRANCH },                 // jmp rel16
+    /* EA */ { op_unknown, 4, X86_OPF_BRANCH },                   // jmp far ptr16:16
+    /* EB */ { op_jmp_rel8, 1, X86_OPF_BRANCH },                  // jmp rel8
+    /* EC */ { op_in_dx, 0, 0 },                                  // in al, dx
+    /* ED */ { op_in_dx, 0, 0 },                                  // in ax, dx
+    /* EE */ { op_out_dx, 0, 0 },                                 // out dx, al
+    /* EF */ { op_out_dx, 0, 0 },                                 // out dx, ax
+    /* F0 */ { op_unknown, 0, X86_OPF_PREFIX },                    // lock
+    /* F1 */ { op_unknown, 0, X86_OPF_BRANCH },                   // int1 (undocumented)
+    /* F2 */ { op_unknown, 0, X86_OPF_PREFIX },                    // repnz
+    /* F3 */ { op_unknown, 0, X86_OPF_PREFIX },                    // rep/repz
+    /* F4 */ { op_hlt, 0, X86_OPF_BRANCH },                       // hlt
+    /* F5 */ { op_cmc, 0, 0 },                                    // cmc
+    /* F6 */ { op_unknown, 1, X86_OPF_MODRM | X86_OPF_GRP3IMM },  // grp3 r/m8
+    /* F7 */ { op_unknown, 2, X86_OPF_MODRM | X86_OPF_GRP3IMM },  // grp3 r/m16
+    /* F8 */ { op_flag_bit, 0, 0 },                               // clc
+    /* F9 */ { op_flag_bit, 0, 0 },                               // stc
+    /* FA */ { op_flag_bit, 0, 0 },                               // cli
+    /* FB */ { op_flag_bit, 0, 0 },                               // sti
+    /* FC */ { op_flag_bit, 0, 0 },                               // cld
+    /* FD */ { op_flag_bit, 0, 0 },                               // std
+    /* FE */ { op_unknown, 0, X86_OPF_MODRM },                    // grp4 r/m8
+    /* FF */ { op_unknown, 0, X86_OPF_MODRM | X86_OPF_BRANCH },   // grp5 r/m16
+};
 
-    switch (op) {
-        case 0x90: return op_nop;
-        case 0xF4: return op_hlt;
-        default:   return op_unknown;
-    }
-}
\ No newline at end of file
+const x86_opent_t x86_optab_0f[256] = {
+    /* 00 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp6 (sldt/str/lldt/ltr/verr/verw)
+    /* 01 */ { op_unknown, 0, X86_OPF_MODRM },                    // grp7 (sgdt/sidt/lgdt/lidt/smsw/lmsw)
+    /* 02 */ { op_unknown, 0, X86_OPF_MODRM },                    // lar
+    /* 03 */ { op_unknown, 0, X86_OPF_MODRM },                    // lsl
+    /* 04 */ { op_unknown, 0, 0 },
+    /* 05 */ { op_unknown, 0, 0 },
+    /* 06 */ { op_unknown, 0, 0 },                                // clts
+    /* 07 */ { op_unknown, 0, 0 },
+    /* 08 */ { op_unknown, 0, 0 },
+    /* 09 */ { op_unknown, 0, 0 },
+    /* 0A */ { op_unknown, 0, 0 },
+    /* 0B */ { op_unknown, 0, 0 },
+    /* 0C */ { op_unknown, 0, 0 },
+    /* 0D */ { op_unknown, 0, 0 },
+    /* 0E */ { op_unknown, 0, 0 },
+    /* 0F */ { op_unknown, 0, 0 },
+    /* 10 */ { op_unknown, 0, 0 },
+    /* 11 */ { op_unknown, 0, 0 },
+    /* 12 */ { op_unknown, 0, 0 },
+    /* 13 */ { op_unknown, 0, 0 },
+    /* 14 */ { op_unknown, 0, 0 },
+    /* 15 */ { op_unknown, 0, 0 },
+    /* 16 */ { op_unknown, 0, 0 },
+    /* 17 */ { op_unknown, 0, 0 },
+    /* 18 */ { op_unknown, 0, 0 },
+    /* 19 */ { op_unknown, 0, 0 },
+    /* 1A */ { op_unknown, 0, 0 },
+    /* 1B */ { op_unknown, 0, 0 },
+    /* 1C */ { op_unknown, 0, 0 },
+    /* 1D */ { op_unknown, 0, 0 },
+    /* 1E */ { op_unknown, 0, 0 },
+    /* 1F */ { op_unknown, 0, 0 },
+    /* 20 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r32, cr
+    /* 21 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov r32, dr
+    /* 22 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov cr, r32
+    /* 23 */ { op_unknown, 0, X86_OPF_MODRM },                    // mov dr, r32
+    /* 24 */ { op_unknown, 0, 0 },
+    /* 25 */ { op_unknown, 0, 0 },
+    /* 26 */ { op_unknown, 0, 0 },
+    /* 27 */ { op_unknown, 0, 0 },
+    /* 28 */ { op_unknown, 0, 0 },
+    /* 29 */ { op_unknown, 0, 0 },
+    /* 2A */ { op_unknown, 0, 0 },
+    /* 2B */ { op_unknown, 0, 0 },
+    /* 2C */ { op_unknown, 0, 0 },
+    /* 2D */ { op_unknown, 0, 0 },
+    /* 2E */ { op_unknown, 0, 0 },
+    /* 2F */ { op_unknown, 0, 0 },
+    /* 30 */ { op_unknown, 0, 0 },
+    /* 31 */ { op_unknown, 0, 0 },                                // rdtsc
+    /* 32 */ { op_unknown, 0, 0 },
+    /* 33 */ { op_unknown, 0, 0 },
+    /* 34 */ { op_unknown, 0, 0 },
+    /* 35 */ { op_unknown, 0, 0 },
+    /* 36 */ { op_unknown, 0, 0 },
+    /* 37 */ { op_unknown, 0, 0 },
+    /* 38 */ { op_unknown, 0, 0 },
+    /* 39 */ { op_unknown, 0, 0 },
+    /* 3A */ { op_unknown, 0, 0 },
+    /* 3B */ { op_unknown, 0, 0 },
+    /* 3C */ { op_unknown, 0, 0 },
+    /* 3D */ { op_unknown, 0, 0 },
+    /* 3E */ { op_unknown, 0, 0 },
+    /* 3F */ { op_unknown, 0, 0 },
+    /* 40 */ { op_unknown, 0, 0 },
+    /* 41 */ { op_unknown, 0, 0 },
+    /* 42 */ { op_unknown, 0, 0 },
+    /* 43 */ { op_unknown, 0, 0 },
+    /* 44 */ { op_unknown, 0, 0 },
+    /* 45 */ { op_unknown, 0, 0 },
+    /* 46 */ { op_unknown, 0, 0 },
+    /* 47 */ { op_unknown, 0, 0 },
+    /* 48 */ { op_unknown, 0, 0 },
+    /* 49 */ { op_unknown, 0, 0 },
+    /* 4A */ { op_unknown, 0, 0 },
+    /* 4B */ { op_unknown, 0, 0 },
+    /* 4C */ { op_unknown, 0, 0 },
+    /* 4D */ { op_unknown, 0, 0 },
+    /* 4E */ { op_unknown, 0, 0 },
+    /* 4F */ { op_unknown, 0, 0 },
+    /* 50 */ { op_unknown, 0, 0 },
+    /* 51 */ { op_unknown, 0, 0 },
+    /* 52 */ { op_unknown, 0, 0 },
+    /* 53 */ { op_unknown, 0, 0 },
+    /* 54 */ { op_unknown, 0, 0 },
+    /* 55 */ { op_unknown, 0, 0 },
+    /* 56 */ { op_unknown, 0, 0 },
+    /* 57 */ { op_unknown, 0, 0 },
+    /* 58 */ { op_unknown, 0, 0 },
+    /* 59 */ { op_unknown, 0, 0 },
+    /* 5A */ { op_unknown, 0, 0 },
+    /* 5B */ { op_unknown, 0, 0 },
+    /* 5C */ { op_unknown, 0, 0 },
+    /* 5D */ { op_unknown, 0, 0 },
+    /* 5E */ { op_unknown, 0, 0 },
+    /* 5F */ { op_unknown, 0, 0 },
+    /* 60 */ { op_unknown, 0, 0 },
+    /* 61 */ { op_unknown, 0, 0 },
+    /* 62 */ { op_unknown, 0, 0 },
+    /* 63 */ { op_unknown, 0, 0 },
+    /* 64 */ { op_unknown, 0, 0 },
+    /* 65 */ { op_unknown, 0, 0 },
+    /* 66 */ { op_unknown, 0, 0 },
+    /* 67 */ { op_unknown, 0, 0 },
+    /* 68 */ { op_unknown, 0, 0 },
+    /* 69 */ { op_unknown, 0, 0 },
+    /* 6A */ { op_unknown, 0, 0 },
+    /* 6B */ { op_unknown, 0, 0 },
+    /* 6C */ { op_unknown, 0, 0 },
+    /* 6D */ { op_unknown, 0, 0 },
+    /* 6E */ { op_unknown, 0, 0 },
+    /* 6F */ { op_unknown, 0, 0 },
+    /* 70 */ { op_unknown, 0, 0 },
+    /* 71 */ { op_unknown, 0, 0 },
+    /* 72 */ { op_unknown, 0, 0 },
+    /* 73 */ { op_unknown, 0, 0 },
+    /* 74 */ { op_unknown, 0, 0 },
+    /* 75 */ { op_unknown, 0, 0 },
+    /* 76 */ { op_unknown, 0, 0 },
+    /* 77 */ { op_unknown, 0, 0 },
+    /* 78 */ { op_unknown, 0, 0 },
+    /* 79 */ { op_unknown, 0, 0 },
+    /* 7A */ { op_unknown, 0, 0 },
+    /* 7B */ { op_unknown, 0, 0 },
+    /* 7C */ { op_unknown, 0, 0 },
+    /* 7D */ { op_unknown, 0, 0 },
+    /* 7E */ { op_unknown, 0, 0 },
+    /* 7F */ { op_unknown, 0, 0 },
+    /* 80 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jo rel16
+    /* 81 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jno rel16
+    /* 82 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jc rel16
+    /* 83 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jnc rel16
+    /* 84 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jz rel16
+    /* 85 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jnz rel16
+    /* 86 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jbe rel16
+    /* 87 */ { op_unknown, 2, X86_OPF_BRANCH },                   // ja rel16
+    /* 88 */ { op_unknown, 2, X86_OPF_BRANCH },                   // js rel16
+    /* 89 */ { op_unknown, 2, X86_OPF_BRANCH },                   // jns rel16
+    /* 8A */ { op_unknown, 2, X86_OPF_BRANCH },                   // jp rel16
+    /* 8B */ { op_unknown, 2, X86_OPF_BRANCH },                   // jnp rel16
+    /* 8C */ { op_unknown, 2, X86_OPF_BRANCH },                   // jl rel16
+    /* 8D */ { op_unknown, 2, X86_OPF_BRANCH },                   // jge rel16
+    /* 8E */ { op_unknown, 2, X86_OPF_BRANCH },                   // jle rel16
+    /* 8F */ { op_unknown, 2, X86_OPF_BRANCH },                   // jg rel16
+    /* 90 */ { op_unknown, 0, X86_OPF_MODRM },                    // seto r/m8
+    /* 91 */ { op_unknown, 0, X86_OPF_MODRM },                    // setno r/m8
+    /* 92 */ { op_unknown, 0, X86_OPF_MODRM },                    // setc r/m8
+    /* 93 */ { op_unknown, 0, X86_OPF_MODRM },                    // setnc r/m8
+    /* 94 */ { op_unknown, 0, X86_OPF_MODRM },                    // setz r/m8
+    /* 95 */ { op_unknown, 0, X86_OPF_MODRM },                    // setnz r/m8
+    /* 96 */ { op_unknown, 0, X86_OPF_MODRM },                    // setbe r/m8
+    /* 97 */ { op_unknown, 0, X86_OPF_MODRM },                    // seta r/m8
+    /* 98 */ { op_unknown, 0, X86_OPF_MODRM },                    // sets r/m8
+    /* 99 */ { op_unknown, 0, X86_OPF_MODRM },                    // setns r/m8
+    /* 9A */ { op_unknown, 0, X86_OPF_MODRM },                    // setp r/m8
+    /* 9B */ { op_unknown, 0, X86_OPF_MODRM },                    // setnp r/m8
+    /* 9C */ { op_unknown, 0, X86_OPF_MODRM },                    // setl r/m8
+    /* 9D */ { op_unknown, 0, X86_OPF_MODRM },                    // setge r/m8
+    /* 9E */ { op_unknown, 0, X86_OPF_MODRM },                    // setle r/m8
+    /* 9F */ { op_unknown, 0, X86_OPF_MODRM },                    // setg r/m8
+    /* A0 */ { op_unknown, 0, 0 },                                // push fs
+    /* A1 */ { op_unknown, 0, 0 },                                // pop fs
+    /* A2 */ { op_unknown, 0, 0 },                                // cpuid
+    /* A3 */ { op_unknown, 0, X86_OPF_MODRM },                    // bt r/m16, r16
+    /* A4 */ { op_unknown, 1, X86_OPF_MODRM },                    // shld r/m16, r16, imm8
+    /* A5 */ { op_unknown, 0, X86_OPF_MODRM },                    // shld r/m16, r16, cl
+    /* A6 */ { op_unknown, 0, 0 },
+    /* A7 */ { op_unknown, 0, 0 },
+    /* A8 */ { op_unknown, 0, 0 },                                // push gs
+    /* A9 */ { op_unknown, 0, 0 },                                // pop gs
+    /* AA */ { op_unknown, 0, 0 },
+    /* AB */ { op_unknown, 0, X86_OPF_MODRM },                    // bts r/m16, r16
+    /* AC */ { op_unknown, 1, X86_OPF_MODRM },                    // shrd r/m16, r16, imm8
+    /* AD */ { op_unknown, 0, X86_OPF_MODRM },                    // shrd r/m16, r16, cl
+    /* AE */ { op_unknown, 0, 0 },
+    /* AF */ { op_unknown, 0, X86_OPF_MODRM },                    // imul r16, r/m16
+    /* B0 */ { op_unknown, 0, 0 },
+    /* B1 */ { op_unknown, 0, 0 },
+    /* B2 */ { op_unknown, 0, X86_OPF_MODRM },                    // lss r16, m
+    /* B3 */ { op_unknown, 0, X86_OPF_MODRM },                    // btr r/m16, r16
+    /* B4 */ { op_unknown, 0, X86_OPF_MODRM },                    // lfs r16, m
+    /* B5 */ { op_unknown, 0, X86_OPF_MODRM },                    // lgs r16, m
+    /* B6 */ { op_unknown, 0, X86_OPF_MODRM },                    // movzx r16, r/m8
+    /* B7 */ { op_unknown, 0, X86_OPF_MODRM },                    // movzx r32, r/m16
+    /* B8 */ { op_unknown, 0, 0 },
+    /* B9 */ { op_unknown, 0, 0 },
+    /* BA */ { op_unknown, 1, X86_OPF_MODRM },                    // grp8 bt* r/m16, imm8
+    /* BB */ { op_unknown, 0, X86_OPF_MODRM },                    // btc r/m16, r16
+    /* BC */ { op_unknown, 0, X86_OPF_MODRM },                    // bsf r16, r/m16
+    /* BD */ { op_unknown, 0, X86_OPF_MODRM },                    // bsr r16, r/m16
+    /* BE */ { op_unknown, 0, X86_OPF_MODRM },                    // movsx r16, r/m8
+    /* BF */ { op_unknown, 0, X86_OPF_MODRM },                    // movsx r32, r/m16
+    /* C0 */ { op_unknown, 0, 0 },
+    /* C1 */ { op_unknown, 0, 0 },
+    /* C2 */ { op_unknown, 0, 0 },
+    /* C3 */ { op_unknown, 0, 0 },
+    /* C4 */ { op_unknown, 0, 0 },
+    /* C5 */ { op_unknown, 0, 0 },
+    /* C6 */ { op_unknown, 0, 0 },
+    /* C7 */ { op_unknown, 0, 0 },
+    /* C8 */ { op_unknown, 0, 0 },
+    /* C9 */ { op_unknown, 0, 0 },
+    /* CA */ { op_unknown, 0, 0 },
+    /* CB */ { op_unknown, 0, 0 },
+    /* CC */ { op_unknown, 0, 0 },
+    /* CD */ { op_unknown, 0, 0 },
+    /* CE */ { op_unknown, 0, 0 },
+    /* CF */ { op_unknown, 0, 0 },
+    /* D0 */ { op_unknown, 0, 0 },
+    /* D1 */ { op_unknown, 0, 0 },
+    /* D2 */ { op_unknown, 0, 0 },
+    /* D3 */ { op_unknown, 0, 0 },
+    /* D4 */ { op_unknown, 0, 0 },
+    /* D5 */ { op_unknown, 0, 0 },
+    /* D6 */ { op_unknown, 0, 0 },
+    /* D7 */ { op_unknown, 0, 0 },
+    /* D8 */ { op_unknown, 0, 0 },
+    /* D9 */ { op_unknown, 0, 0 },
+    /* DA */ { op_unknown, 0, 0 },
+    /* DB */ { op_unknown, 0, 0 },
+    /* DC */ { op_unknown, 0, 0 },
+    /* DD */ { op_unknown, 0, 0 },
+    /* DE */ { op_unknown, 0, 0 },
+    /* DF */ { op_unknown, 0, 0 },
+    /* E0 */ { op_unknown, 0, 0 },
+    /* E1 */ { op_unknown, 0, 0 },
+    /* E2 */ { op_unknown, 0, 0 },
+    /* E3 */ { op_unknown, 0, 0 },
+    /* E4 */ { op_unknown, 0, 0 },
+    /* E5 */ { op_unknown, 0, 0 },
+    /* E6 */ { op_unknown, 0, 0 },
+    /* E7 */ { op_unknown, 0, 0 },
+    /* E8 */ { op_unknown, 0, 0 },
+    /* E9 */ { op_unknown, 0, 0 },
+    /* EA */ { op_unknown, 0, 0 },
+    /* EB */ { op_unknown, 0, 0 },
+    /* EC */ { op_unknown, 0, 0 },
+    /* ED */ { op_unknown, 0, 0 },
+    /* EE */ { op_unknown, 0, 0 },
+    /* EF */ { op_unknown, 0, 0 },
+    /* F0 */ { op_unknown, 0, 0 },
+    /* F1 */ { op_unknown, 0, 0 },
+    /* F2 */ { op_unknown, 0, 0 },
+    /* F3 */ { op_unknown, 0, 0 },
+    /* F4 */ { op_unknown, 0, 0 },
+    /* F5 */ { op_unknown, 0, 0 },
+    /* F6 */ { op_unknown, 0, 0 },
+    /* F7 */ { op_unknown, 0, 0 },
+    /* F8 */ { op_unknown, 0, 0 },
+    /* F9 */ { op_unknown, 0, 0 },
+    /* FA */ { op_unknown, 0, 0 },
+    /* FB */ { op_unknown, 0, 0 },
+    /* FC */ { op_unknown, 0, 0 },
+    /* FD */ { op_unknown, 0, 0 },
+    /* FE */ { op_unknown, 0, 0 },
+    /* FF */ { op_unknown, 0, 0 },
+};
@@ -18,12 +18,37 @@
  
 #pragma once
 
+#include <stdint.h>
+
 #include "exec_ctx.h"
 #include "cpu_types.h"   // for x86_status_t
 
 // Instruction handler function pointer type
 typedef x86_status_t (*x86_fn_t)(exec_ctx_t *e);
 
-// Decode one instruction at CS:IP and return the handler to execute it.
-// (Decoder consumes the opcode byte; handlers consume any ModRM/imm/etc.)
-x86_fn_t x86_decode_ctx(exec_ctx_t *e);
\ No newline at end of file
+/* Opcode table entry flags */
+enum {
+    X86_OPF_MODRM   = 1u << 0,  // ModRM byte follows the opcode
+    X86_OPF_PREFIX  = 1u << 1,  // prefix byte, not an instruction
+    X86_OPF_ESC     = 1u << 2,  // 0x0F: index the secondary table
+    X86_OPF_BRANCH  = 1u << 3,  // may change CS:IP non-sequentially
+    X86_OPF_GRP3IMM = 1u << 4,  // F6/F7: immediate only for ModRM.reg 0/1 (TEST)
+    X86_OPF_STRING  = 1u << 5,  // string op: under REP it may restart itself
+    X86_OPF_ALU     = 1u << 6   // 00-3D / 80-83: decode picks the handler (alu.c)
+};
+
+typedef struct x86_opent {
+    x86_fn_t fn;
+    uint8_t imm_bytes;   // 0,1,2,3,4
+    uint8_t flags;       // X86_OPF_*
+} x86_opent_t;
+
+// Primary (one-byte) and secondary (0x0F xx) opcode tables.
+extern const x86_opent_t x86_optab[256];
+extern const x86_opent_t x86_optab_0f[256];
+
+// Table flags for a decoded opcode (0x0Fxx => secondary table)
+static inline uint8_t x86_op_flags(uint16_t op)
+{
+    return ((op >> 8) == 0x0Fu) ? x86_optab_0f[op & 0xFFu].flags : x86_optab[op & 0xFFu].flags;
+}
@@ -23,33 +23,18 @@
 
 #include "vm/vm.h"       // VM (for vm->logger field; adjust if needed)
 #include "util/log.h"    // logger_t, log_printf, logger_enabled
+#include "cpu/disasm.h"   // x86_disasm_one_16()
 
-/* ---- 10-second fuzzy knobs ---- */
+/* ---- tier checks ---- */
 
-static int trace_debug_enabled(const exec_ctx_t *e) {
-    (void)e;
-    /* TODO: replace with real debug flag check */
-    return 1; /* ON for now while debugging */
+static unsigned trace_tier(const exec_ctx_t *e) {
+    return (e && e->vm) ? trace_active(e) : TRACE_OFF;
 }
 
-/*
- * IMPORTANT:
- * I have to assume where the logger lives.
- * The compile error proves it's NOT VM*.
- *
- * Most likely you have either:
- *   - vm->lg
- *   - vm->logger
- *   - vm->log
- *
- * Pick the right one. I default to vm->lg below.
- */
+/* vm->log is an optional mirror of the trace stream */
 static logger_t *trace_logger(exec_ctx_t *e) {
     if (!e || !e->vm) return NULL;
-
-    /* VM has member 'log' */
-    return e->vm->log;          /* vm->log is logger_t* */
-    /* If this doesn't compile (type mismatch), use: return &e->vm->log; */
+    return e->vm->log;
 }
 
 static int trace_logging_enabled(exec_ctx_t *e) {
@@ -58,16 +43,14 @@ static int trace_logging_enabled(exec_ctx_t *e) {
     return (lg != NULL) && logger_enabled(lg, LOG_TRACE);
 }
 
-/* ---- sink: stderr + (optional) log ---- */
+/* ---- sink: VM.trace.fp (stderr if unset) + (optional) log ---- */
 
 static void trace_printf(exec_ctx_t *e, const char *fmt, ...) {
-    if (!trace_debug_enabled(e)) return;
-
     va_list ap;
     va_start(ap, fmt);
 
-    /* Always print to stderr (your request) */
-    vfprintf(stderr, fmt, ap);
+    FILE *out = e->vm->trace.fp ? e->vm->trace.fp : stderr;
+    vfprintf(out, fmt, ap);
 
     /* Also dump to log if enabled */
     if (trace_logging_enabled(e)) {
@@ -87,24 +70,22 @@ static void trace_printf(exec_ctx_t *e, const char *fmt, ...) {
 
 /* ---- helpers ---- */
 
-static void dump_bytes(char *out, size_t outsz, const uint8_t *bytes, size_t n) {
-    if (!out || outsz == 0) return;
-    out[0] = 0;
-
-    size_t pos = 0;
-    for (size_t i = 0; i < n; i++) {
-        int wrote = snprintf(out + pos, (pos < outsz ? outsz - pos : 0),
-                             "%02X%s", bytes[i], (i + 1 < n ? " " : ""));
-        if (wrote <= 0) break;
-        pos += (size_t)wrote;
-        if (pos + 1 >= outsz) break;
-    }
+/* decoded fields, e.g. "op=83 modrm=C0 imm=0001 len=3" */
+static void dump_decoded(char *out, size_t outsz, const x86_decoded_t *d) {
+    int n = snprintf(out, outsz, "op=%02X", (unsigned)d->op);
+    if (n < 0 || (size_t)n >= outsz) return;
+    if (d->opflags & X86_OPF_MODRM)
+        n += snprintf(out + n, outsz - (size_t)n, " modrm=%02X disp=%04X", d->modrm, d->disp);
+    if (n < 0 || (size_t)n >= outsz) return;
+    snprintf(out + n, outsz - (size_t)n, " imm=%X len=%u", (unsigned)d->imm, (unsigned)d->len);
 }
 
 static const char *x86_status_name(x86_status_t st) {
     switch (st) {
         case X86_OK:    return "OK";
         case X86_HALT:  return "HALT";
+        case X86_IO:    return "IO";
+        case X86_ILLEGAL: return "ILLEGAL";
         case X86_FAULT: return "FAULT";
         case X86_ERR:   return "ERR";
         default:        return "STATUS";
@@ -113,42 +94,48 @@ static const char *x86_status_name(x86_status_t st) {
 
 /* ---- public API ---- */
 
-void trace_pre(exec_ctx_t *e, uint8_t op, const uint8_t *bytes, size_t nbytes) {
-    if (!trace_debug_enabled(e) || !e || !e->cpu) return;
+void trace_pre(exec_ctx_t *e, const x86_decoded_t *d) {
+    const unsigned tier = trace_tier(e);
+    if (tier < TRACE_INSN || !e->cpu) return;
 
     const x86_cpu_t *c = e->cpu;
 
-    char bbuf[128];
-    dump_bytes(bbuf, sizeof(bbuf), bytes, nbytes);
+    if (tier == TRACE_INSN) {
+        x86_disasm_t dis = x86_disasm_decoded(d);
+        trace_printf(e, "%04X:%04X  %s\n", c->cs, d->start_ip, dis.text);
+        return;
+    }
+
+    char dbuf[96];
+    dump_decoded(dbuf, sizeof(dbuf), d);
 
     trace_printf(e,
-        "TRACE PRE  %04X:%04X  op=%02X  bytes=[%s]\n"
+        "TRACE PRE  %04X:%04X  %s\n"
         "          AX=%04X BX=%04X CX=%04X DX=%04X  SI=%04X DI=%04X BP=%04X SP=%04X\n"
         "          CS=%04X IP=%04X DS=%04X ES=%04X SS=%04X  FLAGS=%04X\n",
-        c->cs, c->ip, op, bbuf,
+        c->cs, d->start_ip, dbuf,
         c->ax, c->bx, c->cx, c->dx, c->si, c->di, c->bp, c->sp,
-        c->cs, c->ip, c->ds, c->es, c->ss, c->flags
+        c->cs, c->ip, c->ds, c->es, c->ss, x86_flags(c)
     );
 }
 
-void trace_decode(exec_ctx_t *e, const char *mnemonic, const char *operands, x86_fn_t fn) {
-    if (!trace_debug_enabled(e) || !e || !e->cpu) return;
+void trace_decode(exec_ctx_t *e, const x86_decoded_t *d) {
+    if (trace_tier(e) < TRACE_STATE || !e->cpu) return;
 
     const x86_cpu_t *c = e->cpu;
+    x86_disasm_t dis = x86_disasm_decoded(d);
 
     trace_printf(e,
-        "TRACE DEC  %04X:%04X  %s %s  fn=%p\n",
-        c->cs, c->ip,
-        (mnemonic ? mnemonic : "<unknown>"),
-        (operands ? operands : ""),
-        (void*)fn
+        "TRACE DEC  %04X:%04X  %s  fn=%p\n",
+        c->cs, d->start_ip, dis.text, (void*)d->fn
     );
 }
 
-void trace_post(exec_ctx_t *e, x86_status_t st) {
-    if (!trace_debug_enabled(e) || !e || !e->cpu) return;
+void trace_post(exec_ctx_t *e, const x86_decoded_t *d, x86_status_t st) {
+    if (trace_tier(e) < TRACE_STATE || !e->cpu) return;
 
     const x86_cpu_t *c = e->cpu;
+    (void)d;
 
     trace_printf(e,
         "TRACE POST %04X:%04X  status=%s(%d)\n"
@@ -157,6 +144,17 @@ void trace_post(exec_ctx_t *e, x86_status_t st) {
         c->cs, c->ip,
         x86_status_name(st), (int)st,
         c->ax, c->bx, c->cx, c->dx, c->si, c->di, c->bp, c->sp,
-        c->cs, c->ip, c->ds, c->es, c->ss, c->flags
+        c->cs, c->ip, c->ds, c->es, c->ss, x86_flags(c)
     );
-}
\ No newline at end of file
+}
+
+void trace_branch(exec_ctx_t *e, const x86_decoded_t *d, uint16_t from_cs, x86_status_t st) {
+    if (trace_tier(e) < TRACE_BRANCH || !e->cpu) return;
+    if (!(d->opflags & X86_OPF_BRANCH)) return;
+
+    const x86_cpu_t *c = e->cpu;
+
+    trace_printf(e, "BR %04X:%04X -> %04X:%04X  op=%02X  status=%s\n",
+                 from_cs, d->start_ip, c->cs, c->ip, (unsigned)(d->op & 0xFFu),
+                 x86_status_name(st));
+}
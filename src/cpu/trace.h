@@ -23,8 +23,24 @@
 
 #include "cpu_types.h"
 #include "exec_ctx.h"
-#include "cpu/table.h"
+#include "cpu/decode.h"   // x86_decoded_t
+#include "vm/vm.h"       // VM.trace (TRACE_* tiers)
 
-void trace_pre(exec_ctx_t *e, uint8_t op, const uint8_t *bytes, size_t nbytes);
-void trace_decode(exec_ctx_t *e, const char *mnemonic, const char *operands, x86_fn_t fn);
-void trace_post(exec_ctx_t *e, x86_status_t st);
\ No newline at end of file
+/*
+ * Tracing is selected per VM through VM.trace.flags (TRACE_OFF ..
+ * TRACE_STATE). The hot path only ever asks trace_active(); everything
+ * else runs on the traced path. Building with -DX64VM_NO_TRACE turns
+ * trace_active() into a constant so the hooks are compiled out.
+ */
+#ifdef X64VM_NO_TRACE
+static inline unsigned trace_active(const exec_ctx_t *e) { (void)e; return TRACE_OFF; }
+#else
+static inline unsigned trace_active(const exec_ctx_t *e) { return e->vm->trace.flags; }
+#endif
+
+void trace_pre(exec_ctx_t *e, const x86_decoded_t *d);
+void trace_decode(exec_ctx_t *e, const x86_decoded_t *d);
+void trace_post(exec_ctx_t *e, const x86_decoded_t *d, x86_status_t st);
+
+// TRACE_BRANCH and up: report a control transfer from..to (called after execute)
+void trace_branch(exec_ctx_t *e, const x86_decoded_t *d, uint16_t from_cs, x86_status_t st);
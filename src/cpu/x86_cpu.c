@@ -24,26 +24,6 @@
 #include "exec_ctx.h"
 #include "execute.h"
 
-typedef struct x86_decoded {
-    x86_cpu_t *c;
-
-    uint16_t start_cs;
-    uint16_t start_ip;
-
-    // prefixes (start small)
-    bool rep;          // F3
-
-    // opcode
-    uint8_t op;
-
-    // decoded fields (for now)
-    uint8_t reg;       // generic reg field used by some ops
-    uint16_t imm16;
-
-    // length bookkeeping (optional now, useful soon)
-    uint8_t ilen;
-} x86_decoded_t;
-
 // --------------------------
 
 static uint16_t *reg16_by_index(x86_cpu_t *c, unsigned idx);
@@ -59,6 +39,7 @@ void x86_init(x86_cpu_t *c, uint8_t *mem, size_t mem_size) {
     c->ss = 0x0000;
     c->sp = 0xFFFE;
     c->flags = 0x0002; // bit 1 is typically always set on 8086/real-mode-ish
+    c->lf.op = X86_LF_NONE;
 }
 
 uint16_t* reg16_by_index(x86_cpu_t *c, unsigned idx) {
@@ -87,17 +68,14 @@ uint16_t *x86_reg16(exec_ctx_t *e, unsigned reg)
 
 void x86_set_cf(exec_ctx_t *e, bool v)
 {
-    if (v) e->cpu->flags |= X86_FL_CF;
-    else   e->cpu->flags &= ~X86_FL_CF;
-}
+    x86_cpu_t *c = e->cpu;
 
-void x86_set_zf_sf16(exec_ctx_t *e, uint16_t r)
-{
-    if (r == 0) e->cpu->flags |= X86_FL_ZF;
-    else        e->cpu->flags &= ~X86_FL_ZF;
+    // CF is about to become authoritative; INC/DEC records already keep
+    // it in flags, anything else has to be folded first.
+    if (c->lf.op != X86_LF_INC && c->lf.op != X86_LF_DEC) x86_flags_sync(c);
 
-    if (r & 0x8000u) e->cpu->flags |= X86_FL_SF;
-    else             e->cpu->flags &= ~X86_FL_SF;
+    if (v) c->flags |= X86_FL_CF;
+    else   c->flags &= ~X86_FL_CF;
 }
 
 /* Keep the canonical linear addr helper here unless you move it elsewhere */
@@ -111,14 +89,7 @@ uint32_t x86_linear_addr(uint16_t seg, uint16_t off)
 // caused signature mismatches and/or unused-context churn, so they are intentionally
 // not included here.
 
-
-typedef x86_status_t (*x86_op_fn)(x86_decoded_t *d);
-
-typedef struct x86_opent {
-    x86_op_fn fn;
-    uint8_t imm_bytes;   // 0,1,2,4
-    uint8_t flags;       // future: needs_modrm, etc.
-} x86_opent_t;
+// Opcode dispatch metadata (x86_opent_t) lives in table.h/table.c.
 
 static inline uint32_t rm_phys16(uint16_t seg, uint16_t off) {
     return ((uint32_t)seg << 4) + off;
@@ -28,6 +28,19 @@
 // (exec_ctx_t is defined in exec_ctx.h; we only need the name here.)
 typedef struct exec_ctx exec_ctx_t;
 
+/* Lazy flag producers (x86_cpu_t.lf.op) */
+enum {
+    X86_LF_NONE = 0,   // flags word is authoritative
+    X86_LF_ADD,        // ADD/ADC: res = dst + src (+ CF)
+    X86_LF_SUB,        // SUB/SBB/CMP/NEG: res = dst - src (- CF)
+    X86_LF_LOGIC,      // AND/OR/XOR/TEST: CF=OF=AF=0
+    X86_LF_INC,        // like ADD src=1, CF untouched
+    X86_LF_DEC         // like SUB src=1, CF untouched
+};
+
+/* The six flags the lazy record can produce */
+#define X86_FL_ARITH (X86_FL_CF | X86_FL_PF | X86_FL_AF | X86_FL_ZF | X86_FL_SF | X86_FL_OF)
+
 typedef struct x86_cpu {
     // 16-bit real-mode registers (current scope)
     uint16_t ax, bx, cx, dx;
@@ -37,8 +50,15 @@ typedef struct x86_cpu {
     uint16_t ip;
     uint16_t flags;
 
+    // Lazy arithmetic flags: the last flag-producing ALU op is recorded
+    // here and its X86_FL_ARITH bits are only computed when read.
+    struct {
+        uint8_t  op;       // X86_LF_*
+        uint8_t  width;    // 8 or 16
+        uint16_t dst, src, res;
+    } lf;
+
     bool halted;
-    bool rep_prefix;        // set when 0xF3 seen, consumed by next string op
 
     // Transitional: memory currently lives here, but you're moving it behind VM.
     uint8_t *mem;
@@ -56,6 +76,22 @@ uint16_t *x86_reg16(exec_ctx_t *e, unsigned reg);
 
 // flag helper(s)
 void x86_set_cf(exec_ctx_t *e, bool v);
-void x86_set_zf_sf16(exec_ctx_t *e, uint16_t r);
+
+/* Record a flag-producing op; nothing is computed until a reader asks */
+static inline void x86_lazy_flags(x86_cpu_t *c, uint8_t op, uint8_t width,
+                                  uint16_t dst, uint16_t src, uint16_t res)
+{
+    c->lf.op = op;
+    c->lf.width = width;
+    c->lf.dst = dst;
+    c->lf.src = src;
+    c->lf.res = res;
+}
+
+bool     x86_flag(const x86_cpu_t *c, uint16_t mask);   // one flag (X86_FL_*)
+uint16_t x86_flags(const x86_cpu_t *c);                 // full FLAGS value
+void     x86_flags_sync(x86_cpu_t *c);                  // fold lazy state into flags
+void     x86_flags_store(x86_cpu_t *c, uint16_t v);     // POPF/IRET: replace FLAGS
+bool     x86_cond(const x86_cpu_t *c, unsigned cc);     // Jcc condition 0..15
 
 x86_status_t x86_step(exec_ctx_t *e);
@@ -0,0 +1,524 @@
+// src/jit/jit.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE     // MAP_ANONYMOUS under -std=c11
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jit/jit.h"
+#include "cpu/x86_cpu.h"
+#include "cpu/decode.h"
+#include "cpu/execute.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X64 1
+#else
+#define JIT_X64 0
+#endif
+
+#if JIT_X64
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifndef JIT_MAX_LINKS
+#define JIT_MAX_LINKS 4096
+#endif
+
+/* worst-case host bytes for one block: checked before translating */
+#define JIT_BLOCK_RESERVE 4096u
+
+/* Per-entry state shared with the host code (pointed to by rbp) */
+typedef struct jit_frame {
+    int64_t budget;     // instructions left; every block entry subtracts its length
+    int32_t status;     // x86_status_t at exit
+} jit_frame_t;
+
+typedef void (*jit_enter_fn)(x86_cpu_t *c, jit_frame_t *f, const void *body);
+
+/* an exit jump waiting for its target block to be translated */
+typedef struct jit_link {
+    uint8_t *site;      // rel32 field to patch
+    uint16_t cs, ip;
+} jit_link_t;
+
+struct jit {
+    uint8_t *code;      // JIT_CACHE_BYTES, RWX
+    uint8_t *pos;       // next free byte
+    uint8_t *start;     // first byte after the enter/leave thunks
+    uint8_t *leave;     // store guest regs, restore host regs, ret
+
+    jit_enter_fn enter;
+
+    uint32_t epoch;     // bc_block_t.jit is valid iff jit_epoch == epoch
+    uint64_t bc_gen;    // bcache_t.gen the code cache was built against
+
+    jit_link_t links[JIT_MAX_LINKS];
+    unsigned   nlinks;
+
+    jit_stats_t st;
+};
+
+/* ============================================================
+ * host code emitter
+ *
+ * Fixed register roles:
+ *   rbx = x86_cpu_t*,  rbp = jit_frame_t*
+ *   r8..r15 = guest AX,CX,DX,BX,SP,BP,SI,DI (x86 register order)
+ *   rax, rcx = scratch
+ * ============================================================ */
+
+enum { H_RAX = 0, H_RCX = 1, H_RBX = 3, H_RBP = 5 };
+
+static const uint32_t guest_reg_off[8] = {
+    offsetof(x86_cpu_t, ax), offsetof(x86_cpu_t, cx),
+    offsetof(x86_cpu_t, dx), offsetof(x86_cpu_t, bx),
+    offsetof(x86_cpu_t, sp), offsetof(x86_cpu_t, bp),
+    offsetof(x86_cpu_t, si), offsetof(x86_cpu_t, di),
+};
+
+#define CPU_OFF(f)   ((uint32_t)offsetof(x86_cpu_t, f))
+#define FRAME_OFF(f) ((uint32_t)offsetof(jit_frame_t, f))
+
+static inline void e8(jit_t *j, uint8_t b) { *j->pos++ = b; }
+
+static inline void e16(jit_t *j, uint16_t v)
+{
+    e8(j, (uint8_t)v);
+    e8(j, (uint8_t)(v >> 8));
+}
+
+static inline void e32(jit_t *j, uint32_t v)
+{
+    e16(j, (uint16_t)v);
+    e16(j, (uint16_t)(v >> 16));
+}
+
+static inline uint8_t modrm(unsigned mod, unsigned reg, unsigned rm)
+{
+    return (uint8_t)((mod << 6) | ((reg & 7u) << 3) | (rm & 7u));
+}
+
+/* [base + disp32] operand, base is rbx or rbp (no SIB needed) */
+static inline void e_mem(jit_t *j, unsigned reg, unsigned base, uint32_t disp)
+{
+    e8(j, modrm(2, reg, base));
+    e32(j, disp);
+}
+
+// movzx r(8+g)d, word [rbx + off]
+static void e_load_guest(jit_t *j, unsigned g)
+{
+    e8(j, 0x44); e8(j, 0x0F); e8(j, 0xB7);
+    e_mem(j, g, H_RBX, guest_reg_off[g]);
+}
+
+// mov word [rbx + off], r(8+g)w
+static void e_store_guest_to(jit_t *j, unsigned g, uint32_t off)
+{
+    e8(j, 0x66); e8(j, 0x44); e8(j, 0x89);
+    e_mem(j, g, H_RBX, off);
+}
+
+// mov word [rbx + off], <low host reg>w
+static void e_store16_low(jit_t *j, unsigned hreg, uint32_t off)
+{
+    e8(j, 0x66); e8(j, 0x89);
+    e_mem(j, hreg, H_RBX, off);
+}
+
+// mov byte [rbx + off], imm8
+static void e_store8_imm(jit_t *j, uint32_t off, uint8_t v)
+{
+    e8(j, 0xC6);
+    e_mem(j, 0, H_RBX, off);
+    e8(j, v);
+}
+
+// mov word [rbx + off], imm16
+static void e_store16_imm(jit_t *j, uint32_t off, uint16_t v)
+{
+    e8(j, 0x66); e8(j, 0xC7);
+    e_mem(j, 0, H_RBX, off);
+    e16(j, v);
+}
+
+// mov dword [rbp + off], imm32
+static void e_frame_store32(jit_t *j, uint32_t off, uint32_t v)
+{
+    e8(j, 0xC7);
+    e_mem(j, 0, H_RBP, off);
+    e32(j, v);
+}
+
+// <op> qword [rbp + off], imm32   (op: 5 = sub, 7 = cmp)
+static void e_frame_alu64(jit_t *j, unsigned op, uint32_t off, uint32_t v)
+{
+    e8(j, 0x48); e8(j, 0x81);
+    e_mem(j, op, H_RBP, off);
+    e32(j, v);
+}
+
+// rel32 jump/jcc; returns the rel32 field so it can be patched
+static uint8_t *e_jmp(jit_t *j, const uint8_t *target)
+{
+    e8(j, 0xE9);
+    uint8_t *site = j->pos;
+    e32(j, (uint32_t)(target - (site + 4)));
+    return site;
+}
+
+static uint8_t *e_jcc(jit_t *j, unsigned cc, const uint8_t *target)
+{
+    e8(j, 0x0F); e8(j, (uint8_t)(0x80u + (cc & 0xFu)));
+    uint8_t *site = j->pos;
+    e32(j, (uint32_t)(target - (site + 4)));
+    return site;
+}
+
+static void patch_rel32(uint8_t *site, const uint8_t *target)
+{
+    const int32_t rel = (int32_t)(target - (site + 4));
+    memcpy(site, &rel, sizeof(rel));
+}
+
+/* ============================================================
+ * enter / leave thunks
+ * ============================================================ */
+
+static void emit_thunks(jit_t *j)
+{
+    // enter(cpu, frame, body): save host callee-saved regs, load guest regs
+    j->enter = (jit_enter_fn)(void*)j->pos;
+
+#ifdef _WIN32
+    e8(j, 0x56); e8(j, 0x57);                       // push rsi; push rdi
+#endif
+    e8(j, 0x53); e8(j, 0x55);                       // push rbx; push rbp
+    e8(j, 0x41); e8(j, 0x54); e8(j, 0x41); e8(j, 0x55);   // push r12; push r13
+    e8(j, 0x41); e8(j, 0x56); e8(j, 0x41); e8(j, 0x57);   // push r14; push r15
+#ifdef _WIN32
+    e8(j, 0x48); e8(j, 0x89); e8(j, 0xCB);          // mov rbx, rcx
+    e8(j, 0x48); e8(j, 0x89); e8(j, 0xD5);          // mov rbp, rdx
+    e8(j, 0x4C); e8(j, 0x89); e8(j, 0xC0);          // mov rax, r8
+#else
+    e8(j, 0x48); e8(j, 0x89); e8(j, 0xFB);          // mov rbx, rdi
+    e8(j, 0x48); e8(j, 0x89); e8(j, 0xF5);          // mov rbp, rsi
+    e8(j, 0x48); e8(j, 0x89); e8(j, 0xD0);          // mov rax, rdx
+#endif
+    for (unsigned g = 0; g < 8; g++) e_load_guest(j, g);
+    e8(j, 0xFF); e8(j, 0xE0);                       // jmp rax
+
+    // leave: write guest regs back, unwind
+    j->leave = j->pos;
+    for (unsigned g = 0; g < 8; g++) e_store_guest_to(j, g, guest_reg_off[g]);
+    e8(j, 0x41); e8(j, 0x5F); e8(j, 0x41); e8(j, 0x5E);   // pop r15; pop r14
+    e8(j, 0x41); e8(j, 0x5D); e8(j, 0x41); e8(j, 0x5C);   // pop r13; pop r12
+    e8(j, 0x5D); e8(j, 0x5B);                       // pop rbp; pop rbx
+#ifdef _WIN32
+    e8(j, 0x5F); e8(j, 0x5E);                       // pop rdi; pop rsi
+#endif
+    e8(j, 0xC3);                                    // ret
+
+    j->start = j->pos;
+}
+
+/* ============================================================
+ * code cache
+ * ============================================================ */
+
+static void jit_reset(jit_t *j, bcache_t *bc)
+{
+    if (j->pos != j->start) j->st.resets++;
+    j->pos = j->start;
+    j->nlinks = 0;
+    j->epoch++;
+    j->bc_gen = bc->gen;
+    bc->jit_epoch = j->epoch;
+}
+
+bool jit_available(void) { return true; }
+
+jit_t *jit_create(void)
+{
+    jit_t *j = (jit_t*)calloc(1, sizeof(*j));
+    if (!j) return NULL;
+
+#ifdef _WIN32
+    j->code = (uint8_t*)VirtualAlloc(NULL, JIT_CACHE_BYTES, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void *p = mmap(NULL, JIT_CACHE_BYTES, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    j->code = (p == MAP_FAILED) ? NULL : (uint8_t*)p;
+#endif
+    if (!j->code) {
+        free(j);
+        return NULL;
+    }
+
+    j->pos = j->code;
+    emit_thunks(j);
+    j->epoch = 1;
+    return j;
+}
+
+void jit_destroy(jit_t *j)
+{
+    if (!j) return;
+#ifdef _WIN32
+    VirtualFree(j->code, 0, MEM_RELEASE);
+#else
+    munmap(j->code, JIT_CACHE_BYTES);
+#endif
+    free(j);
+}
+
+void jit_get_stats(const jit_t *j, jit_stats_t *out)
+{
+    if (j) *out = j->st;
+    else memset(out, 0, sizeof(*out));
+}
+
+/* ============================================================
+ * translator
+ * ============================================================ */
+
+static bool is_grp1_reg(const x86_decoded_t *d)
+{
+    const unsigned op = x86_modrm_reg(d);
+    return x86_modrm_mod(d) == 3 && (op == 0 || op == 5 || op == 7);
+}
+
+// Can every instruction of b be emitted? Jcc must branch on flags
+// produced by an ADD/SUB/CMP earlier in the same block.
+static bool block_supported(const bc_block_t *b)
+{
+    bool host_flags = false;
+
+    for (unsigned i = 0; i < b->ninsns; i++) {
+        const x86_decoded_t *d = &b->insn[i];
+        const bool last = (i + 1u == b->ninsns);
+
+        if (d->pfx || d->seg != X86_SEG_NONE) return false;
+
+        if (d->op == 0x90 || (d->op >= 0xB8 && d->op <= 0xBF)) continue;
+        if (d->op == 0x83 && is_grp1_reg(d)) { host_flags = true; continue; }
+        if (d->op >= 0x70 && d->op <= 0x7F && last && host_flags) continue;
+        if (d->op == 0xF4 && last) continue;
+        return false;
+    }
+    return true;
+}
+
+// ADD/SUB/CMP r16, imm8 with the lazy-flag record written by movs only,
+// so the host flags from the ALU op survive to a following Jcc.
+static void emit_grp1(jit_t *j, const x86_decoded_t *d)
+{
+    const unsigned g  = x86_modrm_rm(d);
+    const unsigned op = x86_modrm_reg(d);
+    const uint16_t src = (uint16_t)(int16_t)(int8_t)d->imm;
+
+    e8(j, 0x44); e8(j, 0x89); e8(j, modrm(3, g, H_RAX));        // mov eax, r(8+g)d  (dst)
+
+    e8(j, 0x66); e8(j, 0x41); e8(j, 0x83);                      // <op> r(8+g)w, imm8
+    e8(j, modrm(3, op, g));
+    e8(j, (uint8_t)d->imm);
+
+    e_store8_imm(j, CPU_OFF(lf.op), op == 0 ? X86_LF_ADD : X86_LF_SUB);
+    e_store8_imm(j, CPU_OFF(lf.width), 16);
+    e_store16_low(j, H_RAX, CPU_OFF(lf.dst));
+    e_store16_imm(j, CPU_OFF(lf.src), src);
+
+    if (op == 7) {
+        // CMP leaves the register alone: res = dst - src via lea (no flags)
+        e8(j, 0x8D); e_mem(j, H_RCX, H_RAX, (uint32_t)-(int32_t)src);   // lea ecx, [rax - src]
+        e_store16_low(j, H_RCX, CPU_OFF(lf.res));
+    } else {
+        e_store_guest_to(j, g, CPU_OFF(lf.res));
+    }
+}
+
+// Jump to the translated block at cs:ip if there is one, else to a stub
+// that leaves with IP = ip (and remember the site for later linking).
+static void emit_exit(jit_t *j, bcache_t *bc, const bc_block_t *self, const uint8_t *body,
+                      uint8_t *site, uint16_t cs, uint16_t ip)
+{
+    const uint8_t *target = NULL;
+
+    if (cs == self->cs && ip == self->ip) {
+        target = body;
+    } else {
+        const bc_block_t *t = bcache_find(bc, cs, ip);
+        if (t && t->jit && t->jit_epoch == j->epoch) target = (const uint8_t*)t->jit;
+    }
+
+    if (target) {
+        patch_rel32(site, target);
+        j->st.links++;
+        return;
+    }
+
+    patch_rel32(site, j->pos);
+    e_store16_imm(j, CPU_OFF(ip), ip);
+    e_jmp(j, j->leave);
+
+    if (j->nlinks < JIT_MAX_LINKS) {
+        j->links[j->nlinks++] = (jit_link_t){ .site = site, .cs = cs, .ip = ip };
+    }
+}
+
+// Point every pending exit for cs:ip at body.
+static void resolve_links(jit_t *j, uint16_t cs, uint16_t ip, const uint8_t *body)
+{
+    unsigned k = 0;
+    for (unsigned i = 0; i < j->nlinks; i++) {
+        const jit_link_t *l = &j->links[i];
+        if (l->cs == cs && l->ip == ip) {
+            patch_rel32(l->site, body);
+            j->st.links++;
+        } else {
+            j->links[k++] = *l;
+        }
+    }
+    j->nlinks = k;
+}
+
+static bool jit_translate(jit_t *j, bcache_t *bc, bc_block_t *b)
+{
+    if (!block_supported(b)) {
+        j->st.rejected++;
+        return false;
+    }
+    if ((size_t)(j->code + JIT_CACHE_BYTES - j->pos) < JIT_BLOCK_RESERVE)
+        jit_reset(j, bc);
+
+    uint8_t *body = j->pos;
+
+    // budget: enough left for the whole block, else leave at its start
+    e_frame_alu64(j, 7, FRAME_OFF(budget), b->ninsns);
+    uint8_t *bail = e_jcc(j, 0xC, body);                         // jl
+    e_frame_alu64(j, 5, FRAME_OFF(budget), b->ninsns);
+
+    const x86_decoded_t *last = &b->insn[b->ninsns - 1u];
+    uint8_t *exit_a = NULL, *exit_b = NULL;
+
+    for (unsigned i = 0; i < b->ninsns; i++) {
+        const x86_decoded_t *d = &b->insn[i];
+
+        if (d->op >= 0xB8 && d->op <= 0xBF) {
+            e8(j, 0x66); e8(j, 0x41); e8(j, (uint8_t)(0xB8u + (d->op & 7u)));
+            e16(j, (uint16_t)d->imm);
+        } else if (d->op == 0x83) {
+            emit_grp1(j, d);
+        } else if (d->op >= 0x70 && d->op <= 0x7F) {
+            exit_a = e_jcc(j, d->op & 0xFu, body);               // taken
+            exit_b = e_jmp(j, body);                             // fall through
+        } else if (d->op == 0xF4) {
+            e_store16_imm(j, CPU_OFF(ip), d->next_ip);
+            e_store8_imm(j, CPU_OFF(halted), 1);
+            e_frame_store32(j, FRAME_OFF(status), (uint32_t)X86_HALT);
+            e_jmp(j, j->leave);
+        }
+        // 0x90: nothing
+    }
+
+    if (last->op >= 0x70 && last->op <= 0x7F) {
+        const uint16_t taken = (uint16_t)(last->next_ip + (uint16_t)(int16_t)(int8_t)last->imm);
+        emit_exit(j, bc, b, body, exit_a, b->cs, taken);
+        emit_exit(j, bc, b, body, exit_b, b->cs, last->next_ip);
+    } else if (last->op != 0xF4) {
+        emit_exit(j, bc, b, body, e_jmp(j, body), b->cs, last->next_ip);
+    }
+
+    patch_rel32(bail, j->pos);
+    e_store16_imm(j, CPU_OFF(ip), b->ip);
+    e_jmp(j, j->leave);
+
+    resolve_links(j, b->cs, b->ip, body);
+
+    b->jit = body;
+    b->jit_epoch = j->epoch;
+    bc->jit_epoch = j->epoch;
+    j->st.translated++;
+    return true;
+}
+
+/* ============================================================
+ * dispatcher
+ * ============================================================ */
+
+x86_status_t jit_run(jit_t *j, exec_ctx_t *e, bcache_t *bc, uint32_t budget, uint32_t *retired)
+{
+    x86_cpu_t *c = e->cpu;
+    *retired = 0;
+
+    if (c->halted) return X86_HALT;
+    if (budget == 0) return X86_OK;
+    if (bc->gen != j->bc_gen) jit_reset(j, bc);
+
+    bc_block_t *b = bcache_lookup(e, bc);
+    if (!b) {
+        *retired = 1;
+        return cpu_execute(e);
+    }
+
+    bool native = b->jit && b->jit_epoch == j->epoch;
+    if (!native && !b->jit_fail && ++b->execs >= JIT_HOT_EXECS) {
+        native = jit_translate(j, bc, b);
+        b->jit_fail = !native;
+    }
+    if (!native || budget < b->ninsns)
+        return bcache_exec_block(e, b, budget, retired);
+
+    jit_frame_t f = { .budget = budget, .status = X86_OK };
+    j->st.entries++;
+    j->enter(c, &f, b->jit);
+
+    *retired = (uint32_t)(budget - (uint64_t)f.budget);
+    return (x86_status_t)f.status;
+}
+
+#else  /* !JIT_X64 */
+
+/* No backend for this host: the interpreter is the only tier. */
+
+bool   jit_available(void) { return false; }
+jit_t *jit_create(void)    { return NULL; }
+void   jit_destroy(jit_t *j) { (void)j; }
+
+x86_status_t jit_run(jit_t *j, exec_ctx_t *e, bcache_t *bc, uint32_t budget, uint32_t *retired)
+{
+    (void)j;
+    return bcache_run_block(e, bc, budget, retired);
+}
+
+void jit_get_stats(const jit_t *j, jit_stats_t *out)
+{
+    (void)j;
+    memset(out, 0, sizeof(*out));
+}
+
+#endif /* JIT_X64 */
@@ -0,0 +1,78 @@
+// src/jit/jit.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu/cpu_types.h"
+#include "cpu/exec_ctx.h"
+#include "cpu/bcache.h"
+
+/*
+ * Block-level translator: real-mode x86 -> x86-64 host code.
+ *
+ * Sits on top of the block cache. A block that the interpreter has run
+ * JIT_HOT_EXECS times is translated into the executable code cache;
+ * after that jit_run() enters the host code instead of the handlers.
+ *
+ *  - guest AX..DI live in host r8..r15 for as long as execution stays
+ *    in translated code; they are loaded/stored once per entry/exit
+ *  - ADD/SUB/CMP run as the same host instruction, so a Jcc later in
+ *    the block branches on the host flags; the lazy-flag record is
+ *    still written (plain movs) for whatever reads FLAGS afterwards
+ *  - block exits are patchable jumps: once the successor is translated
+ *    the exit jumps straight into it, with the budget checked at every
+ *    block entry so chained loops still return on time
+ *  - a block holding anything else stays interpreted (jit_fail)
+ *
+ * Any block-cache invalidation (bcache_t.gen changes), including a
+ * translated block evicted by a colliding build, throws the whole code
+ * cache away, so links never point at stale translations.
+ *
+ * Only x86-64 hosts get a backend; elsewhere jit_available() is false
+ * and jit_create() returns NULL.
+ */
+
+#ifndef JIT_HOT_EXECS
+#define JIT_HOT_EXECS   16
+#endif
+
+#ifndef JIT_CACHE_BYTES
+#define JIT_CACHE_BYTES (4u * 1024u * 1024u)
+#endif
+
+typedef struct jit jit_t;
+
+typedef struct jit_stats {
+    uint64_t translated;   // blocks compiled
+    uint64_t rejected;     // blocks left to the interpreter
+    uint64_t entries;      // dispatcher -> host code transitions
+    uint64_t links;        // exits patched to jump block-to-block
+    uint64_t resets;       // code cache flushes
+} jit_stats_t;
+
+bool   jit_available(void);
+jit_t *jit_create(void);
+void   jit_destroy(jit_t *j);
+
+/* Same contract as bcache_run_block() */
+x86_status_t jit_run(jit_t *j, exec_ctx_t *e, bcache_t *bc, uint32_t budget, uint32_t *retired);
+
+void jit_get_stats(const jit_t *j, jit_stats_t *out);
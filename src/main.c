@@ -19,15 +19,92 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "cli/session.h"
 #include "cli/repl.h"
+#include "cli/headless.h"
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--jit]                      interactive shell\n"
+          "       %s [--jit] [--vga] [--ram N[K|M]] [--max-steps N]\n"
+          "              [--bin file [--load-addr A] [--cs S] [--ip O] [--ds S] [--es S] [--ss S] | --boot img]\n",
+          argv0, argv0);
+}
+
+static bool parse_num(const char *s, uint64_t max, uint64_t *out) {
+  char *end = NULL;
+  unsigned long long v = strtoull(s, &end, 0);
+  if (end == s) return false;
+
+  if (*end == 'K' || *end == 'k') { v <<= 10; end++; }
+  else if (*end == 'M' || *end == 'm') { v <<= 20; end++; }
+
+  if (*end || v > max) return false;
+  *out = v;
+  return true;
+}
 
 int main(int argc, char **argv) {
-  (void)argc; (void)argv;
+  headless_opts_t h;
+  headless_defaults(&h);
+  bool headless = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *opt = argv[i];
+    uint64_t v = 0;
+
+    if (!strcmp(opt, "--jit")) {
+      h.jit = true;
+      continue;
+    }
+    if (!strcmp(opt, "--vga")) {
+      h.vga = true;
+      headless = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "unknown option: %s\n", opt);
+      usage(argv[0]);
+      return 2;
+    }
+
+    const char *arg = argv[++i];
+    bool ok = true;
+    headless = true;
+
+    if (!strcmp(opt, "--bin"))                h.bin = arg;
+    else if (!strcmp(opt, "--boot"))          h.boot = arg;
+    else if (!strcmp(opt, "--load-addr"))     { ok = parse_num(arg, 0xFFFFFu, &v); h.load_addr = (uint32_t)v; }
+    else if (!strcmp(opt, "--cs"))            { ok = parse_num(arg, 0xFFFFu, &v);  h.cs = (uint16_t)v; }
+    else if (!strcmp(opt, "--ip"))            { ok = parse_num(arg, 0xFFFFu, &v);  h.ip = (uint16_t)v; }
+    else if (!strcmp(opt, "--ds"))            { ok = parse_num(arg, 0xFFFFu, &v);  h.ds = (uint16_t)v; }
+    else if (!strcmp(opt, "--es"))            { ok = parse_num(arg, 0xFFFFu, &v);  h.es = (uint16_t)v; }
+    else if (!strcmp(opt, "--ss"))            { ok = parse_num(arg, 0xFFFFu, &v);  h.ss = (uint16_t)v; }
+    else if (!strcmp(opt, "--max-steps"))     { ok = parse_num(arg, UINT64_MAX, &v); h.max_steps = v; }
+    else if (!strcmp(opt, "--ram"))           { ok = parse_num(arg, 1u << 30, &v) && v; h.ram = (size_t)v; }
+    else {
+      fprintf(stderr, "unknown option: %s\n", opt);
+      usage(argv[0]);
+      return 2;
+    }
+
+    if (!ok) {
+      fprintf(stderr, "bad value for %s: %s\n", opt, arg);
+      return 2;
+    }
+  }
+
+  // any run flag means a one-shot headless run: no session, no prompt
+  if (headless) return headless_run(&h);
+
   Session s;
   session_init(&s);
+  s.jit = h.jit;
+
   repl(&s);
   session_shutdown(&s);
   return 0;
-}
\ No newline at end of file
+}
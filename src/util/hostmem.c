@@ -0,0 +1,276 @@
+// src/util/hostmem.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE     // MAP_ANONYMOUS, madvise(), mincore() under -std=c11
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "util/hostmem.h"
+
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+size_t hostmem_page_size(void)
+{
+    static size_t page;
+    if (!page) {
+#ifdef _WIN32
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        page = si.dwPageSize;
+#else
+        long n = sysconf(_SC_PAGESIZE);
+        page = n > 0 ? (size_t)n : 4096u;
+#endif
+    }
+    return page;
+}
+
+static size_t round_up(size_t n)
+{
+    const size_t pg = hostmem_page_size();
+    return (n + pg - 1u) & ~(pg - 1u);
+}
+
+/* ============================================================
+ * allocation
+ * ============================================================ */
+
+uint8_t *hostmem_alloc(size_t bytes)
+{
+    if (bytes == 0) return NULL;
+#ifdef _WIN32
+    // committed pages are demand-zero; nothing is resident until touched
+    return (uint8_t*)VirtualAlloc(NULL, round_up(bytes), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void *p = mmap(NULL, round_up(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : (uint8_t*)p;
+#endif
+}
+
+void hostmem_free(uint8_t *p, size_t bytes)
+{
+    if (!p) return;
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, round_up(bytes));
+#endif
+}
+
+/* ============================================================
+ * release / residency
+ * ============================================================ */
+
+bool hostmem_discard(uint8_t *p, size_t bytes)
+{
+    if (!p || !bytes) return true;
+
+    // only whole host pages go back to the OS; the ragged ends are cleared
+    const size_t pg = hostmem_page_size();
+    uint8_t *lo = (uint8_t*)(((uintptr_t)p + pg - 1u) & ~(uintptr_t)(pg - 1u));
+    uint8_t *hi = (uint8_t*)(((uintptr_t)p + bytes) & ~(uintptr_t)(pg - 1u));
+
+    if (hi <= lo) {
+        memset(p, 0, bytes);
+        return true;
+    }
+    memset(p, 0, (size_t)(lo - p));
+    memset(hi, 0, (size_t)(p + bytes - hi));
+
+#ifdef _WIN32
+    // decommit + recommit: the pages come back demand-zero
+    return VirtualFree(lo, (size_t)(hi - lo), MEM_DECOMMIT) &&
+           VirtualAlloc(lo, (size_t)(hi - lo), MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    // private anonymous mapping: DONTNEED drops the pages, next touch is zero
+    return madvise(lo, (size_t)(hi - lo), MADV_DONTNEED) == 0;
+#endif
+}
+
+uint8_t *hostmem_map_file(const char *path, uint64_t offset, size_t bytes)
+{
+    if (!path || !bytes || (offset % HOSTMEM_MAP_ALIGN)) return NULL;
+#ifdef _WIN32
+    (void)offset;
+    return NULL;        // no private file views here yet: callers read instead
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    // touching a page past EOF would be SIGBUS, so the file must cover it
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= offset + bytes)
+        p = mmap(NULL, round_up(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+    close(fd);          // the mapping keeps its own reference
+
+    return p == MAP_FAILED ? NULL : (uint8_t*)p;
+#endif
+}
+
+bool hostmem_map_file_at(uint8_t *p, const char *path, uint64_t offset, size_t bytes)
+{
+    const size_t pg = hostmem_page_size();
+    if (!p || !path || !bytes || ((uintptr_t)p | offset | bytes) & (pg - 1u)) return false;
+#ifdef _WIN32
+    return false;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    void *r = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size >= offset + bytes)
+        r = mmap(p, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, (off_t)offset);
+    close(fd);
+
+    return r != MAP_FAILED;
+#endif
+}
+
+bool hostmem_protect(uint8_t *p, size_t bytes)
+{
+    if (!p || !bytes || ((uintptr_t)p & (hostmem_page_size() - 1u))) return false;
+#ifdef _WIN32
+    DWORD old;
+    return VirtualProtect(p, round_up(bytes), PAGE_READONLY, &old) != 0;
+#else
+    return mprotect(p, round_up(bytes), PROT_READ) == 0;
+#endif
+}
+
+bool hostmem_zero(uint8_t *p, size_t bytes)
+{
+    if (!p || !bytes) return true;
+#ifdef _WIN32
+    memset(p, 0, bytes);
+    return true;
+#else
+    const size_t pg = hostmem_page_size();
+    uint8_t *lo = (uint8_t*)(((uintptr_t)p + pg - 1u) & ~(uintptr_t)(pg - 1u));
+    uint8_t *hi = (uint8_t*)(((uintptr_t)p + bytes) & ~(uintptr_t)(pg - 1u));
+
+    if (hi <= lo) {
+        memset(p, 0, bytes);
+        return true;
+    }
+    memset(p, 0, (size_t)(lo - p));
+    memset(hi, 0, (size_t)(p + bytes - hi));
+
+    // fresh anonymous pages over the range: zero, and nothing resident
+    void *r = mmap(lo, (size_t)(hi - lo), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    return r != MAP_FAILED;
+#endif
+}
+
+#define RES_BATCH 256u
+
+// residency of n host pages from page-aligned lo: res[k] = 1 if backed
+static bool resident_map(uintptr_t lo, size_t n, uint8_t *res)
+{
+    const size_t pg = hostmem_page_size();
+#ifdef _WIN32
+    PSAPI_WORKING_SET_EX_INFORMATION ws[RES_BATCH];
+    for (size_t k = 0; k < n; k++) ws[k].VirtualAddress = (void*)(lo + k * pg);
+    if (!K32QueryWorkingSetEx(GetCurrentProcess(), ws, (DWORD)(n * sizeof(ws[0])))) return false;
+    for (size_t k = 0; k < n; k++) res[k] = ws[k].VirtualAttributes.Valid ? 1u : 0u;
+#else
+#ifdef __linux__
+    unsigned char vec[RES_BATCH];
+#else
+    char vec[RES_BATCH];
+#endif
+    if (mincore((void*)lo, n * pg, vec) != 0) return false;
+    for (size_t k = 0; k < n; k++) res[k] = (uint8_t)(vec[k] & 1u);
+#endif
+    return true;
+}
+
+size_t hostmem_resident(const uint8_t *p, size_t bytes)
+{
+    if (!p || !bytes) return 0;
+
+    const size_t pg = hostmem_page_size();
+    const uintptr_t lo = (uintptr_t)p & ~(uintptr_t)(pg - 1u);
+    const size_t npages = ((uintptr_t)p + bytes - lo + pg - 1u) / pg;
+
+    uint8_t res[RES_BATCH];
+    size_t resident = 0;
+
+    for (size_t i = 0; i < npages; i += RES_BATCH) {
+        const size_t n = npages - i < RES_BATCH ? npages - i : RES_BATCH;
+        if (!resident_map(lo + i * pg, n, res)) return 0;
+        for (size_t k = 0; k < n; k++) resident += res[k];
+    }
+    return resident * pg;
+}
+
+static bool page_is_zero(const uint8_t *p, size_t n)
+{
+    // word compare; host pages are always word aligned
+    const uint64_t *w = (const uint64_t*)(const void*)p;
+    for (size_t i = 0; i < n / sizeof(*w); i++)
+        if (w[i]) return false;
+    return true;
+}
+
+size_t hostmem_trim(uint8_t *p, size_t bytes)
+{
+    if (!p || !bytes) return 0;
+
+    // whole host pages inside [p, p+bytes) only
+    const size_t pg = hostmem_page_size();
+    const uintptr_t lo = ((uintptr_t)p + pg - 1u) & ~(uintptr_t)(pg - 1u);
+    const uintptr_t hi = ((uintptr_t)p + bytes) & ~(uintptr_t)(pg - 1u);
+    if (hi <= lo) return 0;
+
+    const size_t npages = (hi - lo) / pg;
+    uint8_t res[RES_BATCH];
+    size_t released = 0;
+
+    for (size_t i = 0; i < npages; i += RES_BATCH) {
+        const size_t n = npages - i < RES_BATCH ? npages - i : RES_BATCH;
+        if (!resident_map(lo + i * pg, n, res)) break;
+
+        // untouched pages are skipped: reading them would fault them in
+        for (size_t k = 0; k < n; k++) {
+            uint8_t *page = (uint8_t*)(lo + (i + k) * pg);
+            if (!res[k] || !page_is_zero(page, pg)) continue;
+            if (hostmem_discard(page, pg)) released += pg;
+        }
+    }
+    return released;
+}
@@ -0,0 +1,65 @@
+// src/util/hostmem.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Demand-zero host memory for guest RAM.
+ *
+ * hostmem_alloc() reserves address space from the OS (anonymous mmap,
+ * or VirtualAlloc on Windows); nothing is resident until the guest
+ * touches it, so a 128 MiB VM that runs a boot sector costs a few
+ * pages. hostmem_discard() hands a range back (it reads as zero again
+ * afterwards), hostmem_trim() hands back just the resident pages that
+ * are all zero, and hostmem_resident() counts what is actually backed.
+ *
+ * Ranges passed to discard/resident must lie inside one allocation;
+ * discard only releases whole host pages (hostmem_page_size()).
+ */
+
+size_t   hostmem_page_size(void);
+
+uint8_t *hostmem_alloc(size_t bytes);               /* zeroed, NULL on failure */
+void     hostmem_free(uint8_t *p, size_t bytes);
+
+bool     hostmem_discard(uint8_t *p, size_t bytes); /* range reads as zero after */
+
+/* Private (copy-on-write) mapping of `bytes` of a file from `offset`,
+   which must be a multiple of HOSTMEM_MAP_ALIGN; pages load on first
+   touch and writes never reach the file. Free with hostmem_free().
+   NULL if the host cannot map it (callers fall back to reading). */
+#define HOSTMEM_MAP_ALIGN 0x10000u
+uint8_t *hostmem_map_file(const char *path, uint64_t offset, size_t bytes);
+
+/* Same, in place over [p, p+bytes) of an existing allocation (p, offset
+   and bytes host-page aligned). false: nothing changed, read instead. */
+bool     hostmem_map_file_at(uint8_t *p, const char *path, uint64_t offset, size_t bytes);
+
+/* Make [p, p+bytes) read-only (host-page aligned); a stray host write
+   faults instead of corrupting memory other VMs share */
+bool     hostmem_protect(uint8_t *p, size_t bytes);
+
+/* Like hostmem_discard() for a file mapping, where dropping pages would
+   bring the file contents back: the range is replaced by zero pages */
+bool     hostmem_zero(uint8_t *p, size_t bytes);
+size_t   hostmem_trim(uint8_t *p, size_t bytes);    /* bytes released */
+size_t   hostmem_resident(const uint8_t *p, size_t bytes);
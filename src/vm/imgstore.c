@@ -0,0 +1,223 @@
+// src/vm/imgstore.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "vm/imgstore.h"
+#include "vm/memmap.h"
+#include "util/hostmem.h"
+
+struct img {
+    uint8_t *mem;           // hostmem: file mapping or a private copy
+    size_t   len, size;
+    uint64_t hash;
+    unsigned refs;          // under the store lock
+    img_t   *next;
+};
+
+/* ============================================================
+ * store
+ * ============================================================ */
+
+// few distinct images per process: a list is plenty
+static img_t   *g_imgs;
+static uint64_t g_hits;
+
+#ifdef _WIN32
+static SRWLOCK g_lock = SRWLOCK_INIT;
+static void store_lock(void)   { AcquireSRWLockExclusive(&g_lock); }
+static void store_unlock(void) { ReleaseSRWLockExclusive(&g_lock); }
+#else
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static void store_lock(void)   { pthread_mutex_lock(&g_lock); }
+static void store_unlock(void) { pthread_mutex_unlock(&g_lock); }
+#endif
+
+static size_t pad_pages(size_t len)
+{
+    return (len + MM_PAGE_MASK) & ~(size_t)MM_PAGE_MASK;
+}
+
+static uint64_t content_hash(const uint8_t *p, size_t len)
+{
+    uint64_t h = 14695981039346656037ull;     // FNV-1a
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 1099511628211ull;
+    return h ^ len;
+}
+
+/* Under the lock: an image holding exactly these bytes, with a new ref */
+static img_t *store_find(const uint8_t *data, size_t len, uint64_t hash)
+{
+    for (img_t *i = g_imgs; i; i = i->next) {
+        if (i->hash != hash || i->len != len || memcmp(i->mem, data, len)) continue;
+        i->refs++;
+        g_hits++;
+        return i;
+    }
+    return NULL;
+}
+
+/* Under the lock: a new image over mem (the store takes it over) */
+static img_t *store_add(uint8_t *mem, size_t len, uint64_t hash)
+{
+    img_t *img = (img_t*)calloc(1, sizeof(*img));
+    if (!img) return NULL;
+
+    img->mem  = mem;
+    img->len  = len;
+    img->size = pad_pages(len);
+    img->hash = hash;
+    img->refs = 1;
+
+    // guest writes never get here (ROM, COW); this catches host ones
+    hostmem_protect(mem, img->size);
+
+    img->next = g_imgs;
+    g_imgs = img;
+    return img;
+}
+
+/* ============================================================
+ * images
+ * ============================================================ */
+
+static long file_len(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    long len = -1;
+    if (fseek(f, 0, SEEK_END) == 0) len = ftell(f);
+    fclose(f);
+    return len;
+}
+
+/* Page-padded private copy of a file, for hosts that cannot map it */
+static uint8_t *file_read(const char *path, size_t len)
+{
+    uint8_t *mem = hostmem_alloc(pad_pages(len));
+    FILE *f = mem ? fopen(path, "rb") : NULL;
+
+    const bool ok = f && fread(mem, 1, len, f) == len;
+    if (f) fclose(f);
+    if (!ok) {
+        hostmem_free(mem, pad_pages(len));
+        return NULL;
+    }
+    return mem;
+}
+
+img_t *img_open(const char *path)
+{
+    const long n = path ? file_len(path) : -1;
+    if (n <= 0) return NULL;
+    const size_t len = (size_t)n;
+
+    // the mapping ends on a host page, which reads as zero past EOF;
+    // that covers the MM_PAGE_SIZE padding when host pages are no smaller
+    uint8_t *mem = NULL;
+    if (hostmem_page_size() >= MM_PAGE_SIZE) mem = hostmem_map_file(path, 0, len);
+    if (!mem) mem = file_read(path, len);
+    if (!mem) return NULL;
+
+    const uint64_t hash = content_hash(mem, len);
+
+    store_lock();
+    img_t *img = store_find(mem, len, hash);
+    const bool dup = img != NULL;
+    if (!img) img = store_add(mem, len, hash);
+    store_unlock();
+
+    if (dup || !img) hostmem_free(mem, pad_pages(len));
+    return img;
+}
+
+img_t *img_from(const uint8_t *data, size_t len)
+{
+    if (!data || !len) return NULL;
+
+    const uint64_t hash = content_hash(data, len);
+
+    store_lock();
+    img_t *img = store_find(data, len, hash);
+    if (!img) {
+        uint8_t *mem = hostmem_alloc(pad_pages(len));
+        if (mem) {
+            memcpy(mem, data, len);
+            img = store_add(mem, len, hash);
+            if (!img) hostmem_free(mem, pad_pages(len));
+        }
+    }
+    store_unlock();
+    return img;
+}
+
+img_t *img_ref(img_t *img)
+{
+    if (!img) return NULL;
+    store_lock();
+    img->refs++;
+    store_unlock();
+    return img;
+}
+
+void img_release(img_t *img)
+{
+    if (!img) return;
+
+    store_lock();
+    const bool last = --img->refs == 0;
+    if (last) {
+        img_t **link = &g_imgs;
+        while (*link != img) link = &(*link)->next;
+        *link = img->next;
+    }
+    store_unlock();
+
+    if (!last) return;
+    hostmem_free(img->mem, img->size);
+    free(img);
+}
+
+const uint8_t *img_data(const img_t *img) { return img->mem; }
+size_t img_len (const img_t *img)         { return img->len; }
+size_t img_size(const img_t *img)         { return img->size; }
+
+void img_get_stats(img_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    store_lock();
+    for (const img_t *i = g_imgs; i; i = i->next) {
+        out->images++;
+        out->bytes += i->size;
+        out->refs  += i->refs;
+    }
+    out->hits = g_hits;
+    store_unlock();
+}
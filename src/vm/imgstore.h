@@ -0,0 +1,65 @@
+// src/vm/imgstore.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Shared read-only images (ROMs, boot and program images).
+ *
+ * An image is loaded once per process and then mapped by any number of
+ * VMs: their memmap pages point straight at the image, so a hundred VMs
+ * booting the same BIOS hold one copy of it. Images are content
+ * addressed (hash of the bytes, checked with a compare), so the same
+ * contents under two paths, or loaded from a buffer, are one image.
+ *
+ * Image memory is a file mapping where the host has one, padded with
+ * zeros to whole MM_PAGE_SIZE pages, and is write-protected on the host
+ * as well as in the guest: ROM pages drop guest writes, RAM pages
+ * backed by an image are copy-on-write (vm_load_image).
+ *
+ * The store is process-wide and thread-safe; images are reference
+ * counted and unmapped when the last holder lets go. As with any file
+ * mapping, the file must not be rewritten while its image is in use.
+ */
+
+typedef struct img img_t;
+
+typedef struct img_stats {
+    unsigned images;        /* distinct images loaded */
+    size_t   bytes;         /* their size, page padded */
+    unsigned refs;          /* holders (VMs and callers) */
+    uint64_t hits;          /* opens satisfied by an existing image */
+} img_stats_t;
+
+/* Shared image of a file's contents, or NULL; the caller holds a reference */
+img_t *img_open(const char *path);
+/* Same for bytes already in memory (copied on a miss) */
+img_t *img_from(const uint8_t *data, size_t len);
+
+img_t *img_ref(img_t *img);
+void   img_release(img_t *img);
+
+const uint8_t *img_data(const img_t *img);
+size_t img_len (const img_t *img);     /* bytes of content */
+size_t img_size(const img_t *img);     /* padded to whole pages */
+
+void   img_get_stats(img_stats_t *out);
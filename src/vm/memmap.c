@@ -0,0 +1,229 @@
+// src/vm/memmap.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm/memmap.h"
+
+/* ============================================================
+ * lifecycle
+ * ============================================================ */
+
+bool mm_init(memmap_t *m, uint32_t npages)
+{
+    memset(m, 0, sizeof(*m));
+    if (npages == 0) return false;
+
+    m->rd = (uint8_t**)calloc(npages, sizeof(*m->rd));
+    m->wr = (uint8_t**)calloc(npages, sizeof(*m->wr));
+    m->pg = (mm_page_t*)calloc(npages, sizeof(*m->pg));
+
+    if (!m->rd || !m->wr || !m->pg) {
+        mm_free(m);
+        return false;
+    }
+    m->npages = npages;
+    return true;
+}
+
+void mm_free(memmap_t *m)
+{
+    if (!m) return;
+    free(m->rd);
+    free(m->wr);
+    free(m->pg);
+    memset(m, 0, sizeof(*m));
+}
+
+/* ============================================================
+ * mapping
+ * ============================================================ */
+
+// Recompute the fast-path pointers for one page from its descriptor.
+static void mm_refresh(memmap_t *m, uint32_t pg)
+{
+    const mm_page_t *p = &m->pg[pg];
+
+    m->rd[pg] = (p->kind == MM_RAM || p->kind == MM_ROM) ? p->host : NULL;
+    m->wr[pg] = (p->kind == MM_RAM && !p->flags) ? p->host : NULL;
+}
+
+static bool mm_range(const memmap_t *m, uint32_t base, uint32_t size, uint32_t *first, uint32_t *count)
+{
+    if ((base & MM_PAGE_MASK) || (size & MM_PAGE_MASK) || size == 0) return false;
+
+    *first = base >> MM_PAGE_SHIFT;
+    *count = size >> MM_PAGE_SHIFT;
+    return *first < m->npages && *count <= m->npages - *first;
+}
+
+static bool mm_map(memmap_t *m, uint32_t base, uint32_t size, mm_kind_t kind, uint8_t *host, uint8_t mmio)
+{
+    uint32_t first, count;
+    if (!mm_range(m, base, size, &first, &count)) return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        mm_page_t *p = &m->pg[first + i];
+        p->kind  = (uint8_t)kind;
+        p->host  = host ? host + ((size_t)i << MM_PAGE_SHIFT) : NULL;
+        p->mmio  = mmio;
+        p->flags = 0;
+        mm_refresh(m, first + i);
+    }
+    return true;
+}
+
+bool mm_map_ram(memmap_t *m, uint32_t base, uint32_t size, uint8_t *host)
+{
+    return host && mm_map(m, base, size, MM_RAM, host, 0);
+}
+
+bool mm_map_rom(memmap_t *m, uint32_t base, uint32_t size, const uint8_t *host)
+{
+    // rd[] is shared with RAM and so non-const; ROM pages never get a wr[]
+    return host && mm_map(m, base, size, MM_ROM, (uint8_t*)(uintptr_t)host, 0);
+}
+
+bool mm_map_mmio(memmap_t *m, uint32_t base, uint32_t size,
+                 mm_read_fn rd, mm_write_fn wr, void *opaque, const char *name)
+{
+    if (m->nmmio >= MM_MAX_MMIO) return false;
+
+    mm_mmio_t *io = &m->mmio[m->nmmio];
+    if (!mm_map(m, base, size, MM_MMIO, NULL, (uint8_t)m->nmmio)) return false;
+
+    io->read   = rd;
+    io->write  = wr;
+    io->opaque = opaque;
+    io->base   = base;
+    io->size   = size;
+    io->name   = name ? name : "mmio";
+    m->nmmio++;
+    return true;
+}
+
+bool mm_unmap(memmap_t *m, uint32_t base, uint32_t size)
+{
+    return mm_map(m, base, size, MM_UNMAPPED, NULL, 0);
+}
+
+void mm_mmio_rebind(memmap_t *m, const void *from, void *to)
+{
+    for (unsigned i = 0; i < m->nmmio; i++)
+        if (m->mmio[i].opaque == from) m->mmio[i].opaque = to;
+}
+
+bool mm_clone(memmap_t *dst, const memmap_t *src)
+{
+    if (!mm_init(dst, src->npages)) return false;
+
+    memcpy(dst->pg, src->pg, (size_t)src->npages * sizeof(*src->pg));
+    memcpy(dst->mmio, src->mmio, sizeof(src->mmio));
+    dst->nmmio = src->nmmio;
+
+    for (uint32_t pg = 0; pg < dst->npages; pg++) {
+        dst->pg[pg].flags = 0;
+        mm_refresh(dst, pg);
+    }
+    return true;
+}
+
+void mm_set_host(memmap_t *m, uint32_t page, uint8_t *host)
+{
+    if (page >= m->npages) return;
+    m->pg[page].host = host;
+    mm_refresh(m, page);
+}
+
+/* ============================================================
+ * page flags
+ * ============================================================ */
+
+void mm_set_flags(memmap_t *m, uint32_t page, uint8_t flags)
+{
+    if (page >= m->npages) return;
+    m->pg[page].flags |= flags;
+    mm_refresh(m, page);
+}
+
+void mm_clear_flags(memmap_t *m, uint32_t page, uint8_t flags)
+{
+    if (page >= m->npages) return;
+    m->pg[page].flags &= (uint8_t)~flags;
+    mm_refresh(m, page);
+}
+
+void mm_clear_flags_all(memmap_t *m, uint8_t flags)
+{
+    for (uint32_t pg = 0; pg < m->npages; pg++) {
+        if (!(m->pg[pg].flags & flags)) continue;
+        m->pg[pg].flags &= (uint8_t)~flags;
+        mm_refresh(m, pg);
+    }
+}
+
+/* ============================================================
+ * MMIO slow path
+ * ============================================================ */
+
+uint8_t mm_mmio_read(const memmap_t *m, const mm_page_t *p, uint32_t addr)
+{
+    const mm_mmio_t *io = &m->mmio[p->mmio];
+    return io->read ? io->read(io->opaque, addr - io->base) : 0xFF;
+}
+
+void mm_mmio_write(const memmap_t *m, const mm_page_t *p, uint32_t addr, uint8_t val)
+{
+    const mm_mmio_t *io = &m->mmio[p->mmio];
+    if (io->write) io->write(io->opaque, addr - io->base, val);
+}
+
+/* ============================================================
+ * debug
+ * ============================================================ */
+
+static const char *mm_kind_name(uint8_t kind)
+{
+    switch (kind) {
+        case MM_RAM:  return "ram";
+        case MM_ROM:  return "rom";
+        case MM_MMIO: return "mmio";
+        default:      return "unmapped";
+    }
+}
+
+void mm_dump(const memmap_t *m, FILE *fp)
+{
+    uint32_t pg = 0;
+
+    while (pg < m->npages) {
+        const mm_page_t *p = &m->pg[pg];
+        uint32_t end = pg + 1;
+
+        while (end < m->npages && m->pg[end].kind == p->kind && m->pg[end].mmio == p->mmio)
+            end++;
+
+        fprintf(fp, "%08X-%08X  %s", pg << MM_PAGE_SHIFT, (end << MM_PAGE_SHIFT) - 1u, mm_kind_name(p->kind));
+        if (p->kind == MM_MMIO) fprintf(fp, "  %s", m->mmio[p->mmio].name);
+        fputc('\n', fp);
+        pg = end;
+    }
+}
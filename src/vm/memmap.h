@@ -0,0 +1,142 @@
+// src/vm/memmap.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Physical memory map.
+ *
+ * Guest physical space is cut into 4 KiB pages. Each page has a
+ * descriptor (RAM, ROM, MMIO or unmapped) and two host pointers:
+ *
+ *   rd[page]  page base for direct reads,  NULL => slow path
+ *   wr[page]  page base for direct writes, NULL => slow path
+ *
+ * Plain RAM has both set, so an ordinary access is one table lookup.
+ * ROM has rd only (writes are dropped in the slow path). MMIO and
+ * unmapped pages have neither. Page flags (e.g. MM_PF_CODE) can pull a
+ * RAM page's writes onto the slow path without changing its kind.
+ */
+
+#define MM_PAGE_SHIFT 12
+#define MM_PAGE_SIZE  (1u << MM_PAGE_SHIFT)
+#define MM_PAGE_MASK  (MM_PAGE_SIZE - 1u)
+
+#ifndef MM_MAX_MMIO
+#define MM_MAX_MMIO   16
+#endif
+
+typedef enum mm_kind {
+    MM_UNMAPPED = 0,
+    MM_RAM,
+    MM_ROM,
+    MM_MMIO
+} mm_kind_t;
+
+/* page flags: any set flag forces writes through the slow path */
+enum {
+    MM_PF_CODE  = 1u << 0,  /* decoded blocks cached from this page */
+    MM_PF_COW   = 1u << 1,  /* host page shared with a clone: copy on write */
+    MM_PF_CLEAN = 1u << 2   /* dirty tracking: not written since the last snapshot */
+};
+
+typedef uint8_t (*mm_read_fn)(void *opaque, uint32_t addr);
+typedef void    (*mm_write_fn)(void *opaque, uint32_t addr, uint8_t val);
+
+typedef struct mm_mmio {
+    mm_read_fn  read;       /* NULL: reads float (0xFF) */
+    mm_write_fn write;      /* NULL: writes ignored */
+    void       *opaque;
+    uint32_t    base, size;
+    const char *name;
+} mm_mmio_t;
+
+typedef struct mm_page {
+    uint8_t *host;          /* RAM/ROM backing for this page */
+    uint8_t  kind;          /* mm_kind_t */
+    uint8_t  flags;         /* MM_PF_* */
+    uint8_t  mmio;          /* index into mmio[] (MM_MMIO) */
+} mm_page_t;
+
+typedef struct memmap {
+    uint8_t  **rd;
+    uint8_t  **wr;
+    mm_page_t *pg;
+    uint32_t   npages;
+
+    mm_mmio_t  mmio[MM_MAX_MMIO];
+    unsigned   nmmio;
+} memmap_t;
+
+bool mm_init(memmap_t *m, uint32_t npages);
+void mm_free(memmap_t *m);
+
+/* base and size must be page aligned; later maps replace earlier ones */
+bool mm_map_ram (memmap_t *m, uint32_t base, uint32_t size, uint8_t *host);
+bool mm_map_rom (memmap_t *m, uint32_t base, uint32_t size, const uint8_t *host);
+bool mm_map_mmio(memmap_t *m, uint32_t base, uint32_t size,
+                 mm_read_fn rd, mm_write_fn wr, void *opaque, const char *name);
+bool mm_unmap   (memmap_t *m, uint32_t base, uint32_t size);
+
+/* point MMIO regions whose opaque is `from` at `to` instead (e.g. a
+   clone's own copy of a device after mm_clone) */
+void mm_mmio_rebind(memmap_t *m, const void *from, void *to);
+
+/* dst becomes a copy of src's layout pointing at the same host pages
+   (no flags; the caller decides what is shared COW) */
+bool mm_clone(memmap_t *dst, const memmap_t *src);
+
+/* repoint one RAM/ROM page at another host page (e.g. after a COW copy) */
+void mm_set_host(memmap_t *m, uint32_t page, uint8_t *host);
+
+void mm_set_flags  (memmap_t *m, uint32_t page, uint8_t flags);
+void mm_clear_flags(memmap_t *m, uint32_t page, uint8_t flags);
+void mm_clear_flags_all(memmap_t *m, uint8_t flags);
+
+/* slow-path MMIO access (page already known to be MM_MMIO) */
+uint8_t mm_mmio_read (const memmap_t *m, const mm_page_t *p, uint32_t addr);
+void    mm_mmio_write(const memmap_t *m, const mm_page_t *p, uint32_t addr, uint8_t val);
+
+/* print the region layout (adjacent identical pages merged) */
+void mm_dump(const memmap_t *m, FILE *fp);
+
+static inline const mm_page_t *mm_page(const memmap_t *m, uint32_t addr)
+{
+    const uint32_t pg = addr >> MM_PAGE_SHIFT;
+    return pg < m->npages ? &m->pg[pg] : NULL;
+}
+
+/* fast paths: host pointer for addr, or NULL to take the slow path */
+static inline uint8_t *mm_rd_ptr(const memmap_t *m, uint32_t addr)
+{
+    const uint32_t pg = addr >> MM_PAGE_SHIFT;
+    if (pg >= m->npages || !m->rd[pg]) return NULL;
+    return m->rd[pg] + (addr & MM_PAGE_MASK);
+}
+
+static inline uint8_t *mm_wr_ptr(const memmap_t *m, uint32_t addr)
+{
+    const uint32_t pg = addr >> MM_PAGE_SHIFT;
+    if (pg >= m->npages || !m->wr[pg]) return NULL;
+    return m->wr[pg] + (addr & MM_PAGE_MASK);
+}
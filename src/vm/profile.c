@@ -0,0 +1,309 @@
+// src/vm/profile.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "vm/profile.h"
+
+#define PROF_INIT_CAP 1024u
+
+/* ============================================================
+ * histogram
+ * ============================================================ */
+
+static size_t slot_of(uint32_t lin, size_t cap)
+{
+    return (size_t)((lin * 2654435761u) >> 7) & (cap - 1u);
+}
+
+static bool prof_grow(vm_prof_t *p)
+{
+    const size_t cap = p->cap ? p->cap * 2u : PROF_INIT_CAP;
+    prof_bucket_t *tab = (prof_bucket_t*)calloc(cap, sizeof(*tab));
+    if (!tab) return false;
+
+    for (size_t i = 0; i < p->cap; i++) {
+        const prof_bucket_t *b = &p->tab[i];
+        if (!b->count) continue;
+        size_t s = slot_of(b->lin, cap);
+        while (tab[s].count) s = (s + 1u) & (cap - 1u);
+        tab[s] = *b;
+    }
+    free(p->tab);
+    p->tab = tab;
+    p->cap = cap;
+    return true;
+}
+
+void prof_sample(vm_prof_t *p, uint16_t cs, uint16_t ip)
+{
+    const uint32_t lin = ((uint32_t)cs << 4) + ip;
+
+    // keep the load under 3/4
+    if ((p->used + 1u) * 4u > p->cap * 3u && !prof_grow(p)) return;
+
+    size_t s = slot_of(lin, p->cap);
+    while (p->tab[s].count && p->tab[s].lin != lin) s = (s + 1u) & (p->cap - 1u);
+
+    prof_bucket_t *b = &p->tab[s];
+    if (!b->count) {
+        b->lin = lin;
+        b->cs = cs;
+        b->ip = ip;
+        p->used++;
+    }
+    b->count++;
+    p->samples++;
+}
+
+static void free_syms(vm_prof_t *p)
+{
+    for (size_t i = 0; i < p->nsyms; i++) free(p->syms[i].name);
+    free(p->syms);
+    p->syms = NULL;
+    p->nsyms = 0;
+}
+
+void prof_free(vm_prof_t *p)
+{
+    free(p->tab);
+    free_syms(p);
+    memset(p, 0, sizeof(*p));
+}
+
+void prof_start(vm_prof_t *p, uint64_t period)
+{
+    free(p->tab);
+    p->tab = NULL;
+    p->cap = p->used = 0;
+    p->samples = 0;
+
+    p->period = period ? period : PROF_DEFAULT_PERIOD;
+    p->left = p->period;
+    p->on = true;
+}
+
+void prof_stop(vm_prof_t *p)
+{
+    p->on = false;
+}
+
+/* ============================================================
+ * symbols
+ *
+ * NASM map ("Real  Virtual  Name" rows under -- Symbols --):
+ *              7C10              7C10  print
+ * NASM listing (a label line takes the offset of the next code line):
+ *     12                                  print:
+ *     13 00000010 B40E                        mov ah, 0x0e
+ * ============================================================ */
+
+static bool add_sym(prof_sym_t **v, size_t *n, size_t *cap, uint32_t lin, const char *name, size_t len)
+{
+    if (*n == *cap) {
+        const size_t nc = *cap ? *cap * 2u : 64u;
+        prof_sym_t *nv = (prof_sym_t*)realloc(*v, nc * sizeof(*nv));
+        if (!nv) return false;
+        *v = nv;
+        *cap = nc;
+    }
+    char *s = (char*)malloc(len + 1u);
+    if (!s) return false;
+    memcpy(s, name, len);
+    s[len] = 0;
+    (*v)[*n].lin = lin;
+    (*v)[*n].name = s;
+    (*n)++;
+    return true;
+}
+
+static int cmp_sym(const void *a, const void *b)
+{
+    const prof_sym_t *x = (const prof_sym_t*)a, *y = (const prof_sym_t*)b;
+    return (x->lin > y->lin) - (x->lin < y->lin);
+}
+
+static const char *skip_ws(const char *s)
+{
+    while (*s == ' ' || *s == '\t') s++;
+    return s;
+}
+
+// Identifier at s ending in ':' (listing label); *len excludes the colon
+static bool label_at(const char *s, size_t *len)
+{
+    size_t i = 0;
+    if (!(isalpha((unsigned char)s[0]) || s[0] == '_' || s[0] == '.')) return false;
+    while (isalnum((unsigned char)s[i]) || s[i] == '_' || s[i] == '.' || s[i] == '$' || s[i] == '@') i++;
+    if (s[i] != ':') return false;
+    *len = i;
+    return true;
+}
+
+long prof_load_map(vm_prof_t *p, const char *path, uint32_t base)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    prof_sym_t *v = NULL;
+    size_t n = 0, cap = 0;
+    bool in_syms = false, ok = true;
+    char line[512];
+
+    // listing state: labels waiting for the next code offset
+    char pending[8][64];
+    size_t npending = 0;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        const char *s = skip_ws(line);
+
+        if (!strncmp(s, "-- Symbols", 10)) { in_syms = true; continue; }
+        if (!strncmp(s, "-- ", 3) && in_syms) { in_syms = false; continue; }
+
+        char *end;
+        if (in_syms) {
+            // Real  Virtual  Name (the header row fails the hex parse)
+            strtoul(s, &end, 16);
+            if (end == s) continue;
+            const char *q = skip_ws(end);
+            const unsigned long virt = strtoul(q, &end, 16);
+            if (end == q) continue;
+            q = skip_ws(end);
+            size_t len = strcspn(q, " \t\r\n");
+            if (len) ok = add_sym(&v, &n, &cap, base + (uint32_t)virt, q, len);
+            continue;
+        }
+
+        // listing: "<line#> [offset bytes] source"
+        if (!isdigit((unsigned char)*s)) continue;
+        strtoul(s, &end, 10);
+        const char *q = skip_ws(end);
+        const char *src = q;
+        size_t len;
+
+        char *oend;
+        const unsigned long off = strtoul(q, &oend, 16);
+        const bool has_off = (oend - q) == 8 && (*oend == ' ' || *oend == '\t');
+
+        if (has_off) {
+            for (size_t i = 0; ok && i < npending; i++)
+                ok = add_sym(&v, &n, &cap, base + (uint32_t)off, pending[i], strlen(pending[i]));
+            npending = 0;
+
+            // "label: insn" on the code line itself: skip the byte column
+            q = skip_ws(oend);
+            while (*q && (isxdigit((unsigned char)*q) || strchr("()[]", *q))) q++;
+            q = skip_ws(q);
+            if (ok && label_at(q, &len)) ok = add_sym(&v, &n, &cap, base + (uint32_t)off, q, len);
+            continue;
+        }
+        if (label_at(src, &len) && npending < 8 && len < sizeof(pending[0])) {
+            memcpy(pending[npending], src, len);
+            pending[npending][len] = 0;
+            npending++;
+        }
+    }
+    fclose(fp);
+
+    if (!ok) {
+        for (size_t i = 0; i < n; i++) free(v[i].name);
+        free(v);
+        return -1;
+    }
+
+    qsort(v, n, sizeof(*v), cmp_sym);
+    free_syms(p);
+    p->syms = v;
+    p->nsyms = n;
+    return (long)n;
+}
+
+// Nearest symbol at or below lin, or NULL
+static const prof_sym_t *sym_for(const vm_prof_t *p, uint32_t lin)
+{
+    size_t lo = 0, hi = p->nsyms;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2u;
+        if (p->syms[mid].lin <= lin) lo = mid + 1u;
+        else hi = mid;
+    }
+    return lo ? &p->syms[lo - 1u] : NULL;
+}
+
+/* ============================================================
+ * report
+ * ============================================================ */
+
+typedef struct prof_row {
+    uint64_t count;
+    const prof_bucket_t *b;     // by address
+    const prof_sym_t *sym;      // by symbol (NULL: below every symbol)
+} prof_row_t;
+
+static int cmp_row(const void *a, const void *b)
+{
+    const uint64_t x = ((const prof_row_t*)a)->count, y = ((const prof_row_t*)b)->count;
+    return (x < y) - (x > y);
+}
+
+void prof_report(const vm_prof_t *p, FILE *fp, unsigned n)
+{
+    fprintf(fp, "profile: %s, period %llu, %llu samples, %zu addresses\n",
+            p->on ? "running" : "stopped", (unsigned long long)p->period,
+            (unsigned long long)p->samples, p->used);
+    if (!p->samples) return;
+
+    const bool by_sym = p->nsyms != 0;
+    prof_row_t *rows = (prof_row_t*)calloc(by_sym ? p->nsyms + 1u : p->used, sizeof(*rows));
+    if (!rows) return;
+
+    size_t nrows = 0;
+    if (by_sym) {
+        // row i = syms[i - 1], row 0 = "(no symbol)"
+        nrows = p->nsyms + 1u;
+        for (size_t i = 1; i < nrows; i++) rows[i].sym = &p->syms[i - 1u];
+        for (size_t i = 0; i < p->cap; i++) {
+            if (!p->tab[i].count) continue;
+            const prof_sym_t *sym = sym_for(p, p->tab[i].lin);
+            rows[sym ? (size_t)(sym - p->syms) + 1u : 0].count += p->tab[i].count;
+        }
+    } else {
+        for (size_t i = 0; i < p->cap; i++)
+            if (p->tab[i].count) rows[nrows++] = (prof_row_t){ p->tab[i].count, &p->tab[i], NULL };
+    }
+    qsort(rows, nrows, sizeof(*rows), cmp_row);
+
+    for (size_t i = 0; i < nrows && i < n && rows[i].count; i++) {
+        const double pct = 100.0 * (double)rows[i].count / (double)p->samples;
+        if (!by_sym) {
+            const prof_bucket_t *b = rows[i].b;
+            fprintf(fp, "  %6.2f%%  %10llu  %05X  %04X:%04X\n", pct, (unsigned long long)rows[i].count,
+                    (unsigned)b->lin, b->cs, b->ip);
+        } else if (rows[i].sym) {
+            fprintf(fp, "  %6.2f%%  %10llu  %05X  %s\n", pct, (unsigned long long)rows[i].count,
+                    (unsigned)rows[i].sym->lin, rows[i].sym->name);
+        } else {
+            fprintf(fp, "  %6.2f%%  %10llu  %5s  (no symbol)\n", pct, (unsigned long long)rows[i].count, "");
+        }
+    }
+    free(rows);
+}
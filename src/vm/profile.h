@@ -0,0 +1,92 @@
+// src/vm/profile.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Guest sampling profiler.
+ *
+ * vm_run() shortens its run slices so one ends every `period` retired
+ * instructions; at that boundary prof_tick() takes the linear CS:IP
+ * into a hash histogram. Nothing is added to the per-instruction path,
+ * and with the profiler stopped the run loop only tests `on`.
+ *
+ * Samples can be folded by function: prof_load_map() reads symbols
+ * from a NASM map file ([map all ...]) or a NASM listing (-l), and
+ * each sample is charged to the nearest symbol at or below it.
+ */
+
+#ifndef PROF_DEFAULT_PERIOD
+#define PROF_DEFAULT_PERIOD 1000u
+#endif
+
+typedef struct prof_bucket {
+    uint32_t lin;           // sampled linear address
+    uint16_t cs, ip;        // first CS:IP seen for it
+    uint64_t count;         // 0: free slot
+} prof_bucket_t;
+
+typedef struct prof_sym {
+    uint32_t lin;
+    char    *name;
+} prof_sym_t;
+
+typedef struct vm_prof {
+    bool     on;
+    uint64_t period;        // instructions between samples
+    uint64_t left;          // until the next sample
+
+    prof_bucket_t *tab;     // open addressing, power-of-two size
+    size_t   cap, used;
+    uint64_t samples;
+
+    prof_sym_t *syms;       // sorted by lin
+    size_t   nsyms;
+} vm_prof_t;
+
+void prof_free (vm_prof_t *p);
+void prof_start(vm_prof_t *p, uint64_t period);     // clears the histogram
+void prof_stop (vm_prof_t *p);
+
+/* Load symbols (replacing any loaded before); each symbol value is
+   offset by `base` (linear). Returns the symbol count, -1 on error. */
+long prof_load_map(vm_prof_t *p, const char *path, uint32_t base);
+
+/* Top-n report: by symbol when a map is loaded, else by address */
+void prof_report(const vm_prof_t *p, FILE *fp, unsigned n);
+
+void prof_sample(vm_prof_t *p, uint16_t cs, uint16_t ip);
+
+/* `n` instructions retired since the last call (call only when p->on) */
+static inline void prof_tick(vm_prof_t *p, uint64_t n, uint16_t cs, uint16_t ip)
+{
+    if (n < p->left) { p->left -= n; return; }
+    p->left = p->period;
+    prof_sample(p, cs, ip);
+}
+
+/* Largest slice vm_run() may hand the CPU before the next sample */
+static inline uint64_t prof_slice(const vm_prof_t *p)
+{
+    return p->left ? p->left : 1u;
+}
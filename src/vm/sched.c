@@ -0,0 +1,437 @@
+// src/vm/sched.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "vm/sched.h"
+
+/* ============================================================
+ * threads
+ * ============================================================ */
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION   lock_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE             thread_t;
+static void lock_init(lock_t *l)              { InitializeCriticalSection(l); }
+static void lock_fini(lock_t *l)              { DeleteCriticalSection(l); }
+static void lock(lock_t *l)                   { EnterCriticalSection(l); }
+static void unlock(lock_t *l)                 { LeaveCriticalSection(l); }
+static void cond_init(cond_t *c)              { InitializeConditionVariable(c); }
+static void cond_fini(cond_t *c)              { (void)c; }
+static void cond_wait(cond_t *c, lock_t *l)   { SleepConditionVariableCS(c, l, INFINITE); }
+static void cond_signal(cond_t *c)            { WakeConditionVariable(c); }
+static void cond_broadcast(cond_t *c)         { WakeAllConditionVariable(c); }
+#else
+typedef pthread_mutex_t lock_t;
+typedef pthread_cond_t  cond_t;
+typedef pthread_t       thread_t;
+static void lock_init(lock_t *l)              { pthread_mutex_init(l, NULL); }
+static void lock_fini(lock_t *l)              { pthread_mutex_destroy(l); }
+static void lock(lock_t *l)                   { pthread_mutex_lock(l); }
+static void unlock(lock_t *l)                 { pthread_mutex_unlock(l); }
+static void cond_init(cond_t *c)              { pthread_cond_init(c, NULL); }
+static void cond_fini(cond_t *c)              { pthread_cond_destroy(c); }
+static void cond_wait(cond_t *c, lock_t *l)   { pthread_cond_wait(c, l); }
+static void cond_signal(cond_t *c)            { pthread_cond_signal(c); }
+static void cond_broadcast(cond_t *c)         { pthread_cond_broadcast(c); }
+#endif
+
+static unsigned cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (unsigned)si.dwNumberOfProcessors : 1u;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1u;
+#endif
+}
+
+/* ============================================================
+ * state
+ * ============================================================ */
+
+/* Runnable VMs, linked through VM.sched. A VM is on at most one deque
+   at a time, so the list needs no storage of its own. */
+typedef struct deque {
+    lock_t   lock;
+    VM      *head, *tail;
+    unsigned count;
+} deque_t;
+
+typedef struct worker {
+    sched_t *s;
+    unsigned idx;
+    deque_t  q;
+    thread_t th;
+    bool     started;
+    uint64_t slices, steals;    // under sched_t.lock
+} worker_t;
+
+struct sched {
+    VMManager *m;
+
+    lock_t lock;            // everything below but the deques
+    cond_t work;            // workers: something was queued / quit
+    cond_t idle;            // waiters: a VM was parked
+    unsigned running;       // VMs in VM_SCHED_RUNNING
+    unsigned next_q;        // round robin for sched_start
+    bool quit;
+
+    atomic_uint pending;    // VMs on all deques (raised under lock)
+
+    lock_t io_lock;
+    sched_io_fn io;
+    void *io_opaque;
+
+    worker_t w[SCHED_MAX_WORKERS];
+    unsigned nworkers;
+};
+
+static void push(sched_t *s, worker_t *w, VM *vm)
+{
+    deque_t *q = &w->q;
+    lock(&q->lock);
+    vm->sched.next = NULL;
+    vm->sched.prev = q->tail;
+    if (q->tail) q->tail->sched.next = vm;
+    else q->head = vm;
+    q->tail = vm;
+    q->count++;
+    unlock(&q->lock);
+
+    // raised under the lock so a worker going to sleep cannot miss it
+    lock(&s->lock);
+    atomic_fetch_add(&s->pending, 1u);
+    cond_signal(&s->work);
+    unlock(&s->lock);
+}
+
+/* Under q->lock */
+static VM *pop_head(deque_t *q)
+{
+    VM *vm = q->head;
+    if (!vm) return NULL;
+    q->head = vm->sched.next;
+    if (q->head) q->head->sched.prev = NULL;
+    else q->tail = NULL;
+    q->count--;
+    vm->sched.next = vm->sched.prev = NULL;
+    return vm;
+}
+
+static VM *pop_tail(deque_t *q)
+{
+    VM *vm = q->tail;
+    if (!vm) return NULL;
+    q->tail = vm->sched.prev;
+    if (q->tail) q->tail->sched.next = NULL;
+    else q->head = NULL;
+    q->count--;
+    vm->sched.next = vm->sched.prev = NULL;
+    return vm;
+}
+
+/* own deque from the head, other deques from the tail */
+static VM *take(sched_t *s, worker_t *w, bool *stolen)
+{
+    *stolen = false;
+
+    lock(&w->q.lock);
+    VM *vm = pop_head(&w->q);
+    unlock(&w->q.lock);
+
+    for (unsigned k = 1; !vm && k < s->nworkers; k++) {
+        deque_t *q = &s->w[(w->idx + k) % s->nworkers].q;
+        lock(&q->lock);
+        vm = pop_tail(q);
+        unlock(&q->lock);
+        *stolen = vm != NULL;
+    }
+
+    if (vm) atomic_fetch_sub(&s->pending, 1u);
+    return vm;
+}
+
+/* Under s->lock: the VM leaves the workers */
+static void park(sched_t *s, vm_sched_slot_t *e, vm_sched_state_t state, const vm_exit_t *x)
+{
+    e->state = state;
+    e->pause_req = false;
+    if (x) e->last = *x;
+    s->running--;
+    cond_broadcast(&s->idle);
+}
+
+/* ============================================================
+ * workers
+ * ============================================================ */
+
+static void run_slice(sched_t *s, worker_t *w, VM *vm, bool stolen)
+{
+    vm_sched_slot_t *e = &vm->sched;
+
+    lock(&s->lock);
+    const bool skip = e->pause_req || s->quit;
+    if (skip) park(s, e, VM_SCHED_PAUSED, NULL);
+    unlock(&s->lock);
+    if (skip) return;
+
+    // the VM is ours until it goes back on a deque or is parked
+    vm_exit_t x = {0};
+    uint64_t done = 0;
+    while (done < SCHED_SLICE) {
+        vm_run(vm, SCHED_SLICE - done, &x);
+        done += x.retired;
+        if (x.reason != VM_EXIT_IO) break;
+
+        lock(&s->io_lock);
+        if (s->io) s->io(s->io_opaque, vm->id, &x);
+        unlock(&s->io_lock);
+    }
+
+    bool again = false;
+    lock(&s->lock);
+    e->retired += done;
+    e->slices++;
+    w->slices++;
+    if (stolen) w->steals++;
+
+    if (x.reason == VM_EXIT_HALT || x.reason == VM_EXIT_FAULT) park(s, e, VM_SCHED_STOPPED, &x);
+    else if (x.reason == VM_EXIT_BREAKPOINT || e->pause_req) park(s, e, VM_SCHED_PAUSED, &x);
+    else again = true;
+    unlock(&s->lock);
+
+    if (again) push(s, w, vm);
+}
+
+static void work(worker_t *w)
+{
+    sched_t *s = w->s;
+
+    for (;;) {
+        bool stolen;
+        VM *vm = take(s, w, &stolen);
+        if (vm) {
+            run_slice(s, w, vm, stolen);
+            continue;
+        }
+
+        lock(&s->lock);
+        while (!s->quit && atomic_load(&s->pending) == 0) cond_wait(&s->work, &s->lock);
+        const bool quit = s->quit && atomic_load(&s->pending) == 0;
+        unlock(&s->lock);
+        if (quit) return;
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) { work((worker_t*)arg); return 0; }
+#else
+static void *worker_main(void *arg) { work((worker_t*)arg); return NULL; }
+#endif
+
+/* ============================================================
+ * lifecycle
+ * ============================================================ */
+
+sched_t *sched_create(VMManager *m, unsigned workers)
+{
+    if (!m) return NULL;
+    if (!workers) workers = cpu_count();
+    if (workers > SCHED_MAX_WORKERS) workers = SCHED_MAX_WORKERS;
+
+    sched_t *s = (sched_t*)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+
+    s->m = m;
+    lock_init(&s->lock);
+    lock_init(&s->io_lock);
+    cond_init(&s->work);
+    cond_init(&s->idle);
+    atomic_init(&s->pending, 0u);
+
+    // nworkers and the deques are fixed before any worker can look at them
+    s->nworkers = workers;
+    for (unsigned i = 0; i < workers; i++) {
+        s->w[i].s = s;
+        s->w[i].idx = i;
+        lock_init(&s->w[i].q.lock);
+    }
+
+    bool ok = true;
+    for (unsigned i = 0; ok && i < workers; i++) {
+        worker_t *w = &s->w[i];
+#ifdef _WIN32
+        ok = w->started = (w->th = CreateThread(NULL, 0, worker_main, w, 0, NULL)) != NULL;
+#else
+        ok = w->started = pthread_create(&w->th, NULL, worker_main, w) == 0;
+#endif
+    }
+
+    // a deque nobody drains would strand its VMs: all workers or none
+    if (!ok) {
+        sched_destroy(s);
+        return NULL;
+    }
+    return s;
+}
+
+void sched_destroy(sched_t *s)
+{
+    if (!s) return;
+
+    for (VM *vm = vm_next(s->m, NULL); vm; vm = vm_next(s->m, vm)) sched_pause(s, vm->id);
+
+    lock(&s->lock);
+    s->quit = true;
+    cond_broadcast(&s->work);
+    unlock(&s->lock);
+
+    for (unsigned i = 0; i < s->nworkers; i++) {
+        worker_t *w = &s->w[i];
+        if (!w->started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(w->th, INFINITE);
+        CloseHandle(w->th);
+#else
+        pthread_join(w->th, NULL);
+#endif
+    }
+
+    // only once every worker is gone: idle ones poll all the deques
+    for (unsigned i = 0; i < s->nworkers; i++) lock_fini(&s->w[i].q.lock);
+
+    cond_fini(&s->work);
+    cond_fini(&s->idle);
+    lock_fini(&s->io_lock);
+    lock_fini(&s->lock);
+    free(s);
+}
+
+void sched_set_io(sched_t *s, sched_io_fn fn, void *opaque)
+{
+    lock(&s->io_lock);
+    s->io = fn;
+    s->io_opaque = opaque;
+    unlock(&s->io_lock);
+}
+
+/* ============================================================
+ * control
+ * ============================================================ */
+
+bool sched_start(sched_t *s, int id)
+{
+    VM *vm = vm_get(s->m, id);
+    if (!vm) return false;
+
+    lock(&s->lock);
+    vm_sched_slot_t *e = &vm->sched;
+    if (e->state == VM_SCHED_RUNNING) {
+        unlock(&s->lock);
+        return true;
+    }
+    if (e->state != VM_SCHED_PAUSED) {
+        e->retired = 0;
+        e->slices = 0;
+    }
+    e->state = VM_SCHED_RUNNING;
+    e->pause_req = false;
+    memset(&e->last, 0, sizeof(e->last));
+    s->running++;
+    worker_t *w = &s->w[s->next_q++ % s->nworkers];
+    unlock(&s->lock);
+
+    push(s, w, vm);
+    return true;
+}
+
+bool sched_pause(sched_t *s, int id)
+{
+    VM *vm = vm_get(s->m, id);
+    if (!vm) return false;
+
+    lock(&s->lock);
+    vm_sched_slot_t *e = &vm->sched;
+    const bool was = e->state == VM_SCHED_RUNNING;
+    if (was) e->pause_req = true;
+    while (e->state == VM_SCHED_RUNNING) cond_wait(&s->idle, &s->lock);
+    unlock(&s->lock);
+    return was;
+}
+
+void sched_wait(sched_t *s)
+{
+    lock(&s->lock);
+    while (s->running) cond_wait(&s->idle, &s->lock);
+    unlock(&s->lock);
+}
+
+bool sched_running(sched_t *s, int id)
+{
+    VM *vm = s ? vm_get(s->m, id) : NULL;
+    if (!vm) return false;
+
+    lock(&s->lock);
+    const bool r = vm->sched.state == VM_SCHED_RUNNING;
+    unlock(&s->lock);
+    return r;
+}
+
+void sched_info(sched_t *s, int id, sched_info_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    VM *vm = s ? vm_get(s->m, id) : NULL;
+    if (!vm) return;
+
+    lock(&s->lock);
+    const vm_sched_slot_t *e = &vm->sched;
+    out->state   = e->state;
+    out->last    = e->last;
+    out->retired = e->retired;
+    out->slices  = e->slices;
+    unlock(&s->lock);
+}
+
+void sched_get_stats(sched_t *s, sched_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!s) return;
+
+    lock(&s->lock);
+    out->workers = s->nworkers;
+    for (unsigned i = 0; i < s->nworkers; i++) {
+        out->slices += s->w[i].slices;
+        out->steals += s->w[i].steals;
+    }
+    unlock(&s->lock);
+}
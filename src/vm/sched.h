@@ -0,0 +1,95 @@
+// src/vm/sched.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vm/vm.h"
+
+/*
+ * VM scheduler: a pool of worker threads running every started VM of a
+ * VMManager in instruction-budget slices.
+ *
+ *  - each worker has a deque of runnable VMs; it takes from the head
+ *    of its own (round robin among its VMs) and, when that is empty,
+ *    steals from the tail of the others, so a worker whose VMs halted
+ *    picks up slices from busier ones
+ *  - a slice is one vm_run() of SCHED_SLICE instructions (plus I/O
+ *    exits serviced through the io hook); after it the VM goes back on
+ *    the worker's own deque unless it halted, faulted, hit a breakpoint
+ *    or was asked to pause
+ *  - VMs share nothing mutable (clone bases are read-only), so slices
+ *    run without locks; the scheduler lock only covers the state below
+ *
+ * A VM that is VM_SCHED_RUNNING belongs to the workers: the caller must
+ * not touch it (or destroy/clone it) until sched_pause()/sched_wait()
+ * has returned it.
+ */
+
+#ifndef SCHED_SLICE
+#define SCHED_SLICE        200000u    // instructions per slice
+#endif
+
+#ifndef SCHED_MAX_WORKERS
+#define SCHED_MAX_WORKERS  64
+#endif
+
+typedef enum vm_sched_state {
+    VM_SCHED_IDLE = 0,      /* never started here */
+    VM_SCHED_RUNNING,       /* queued or in a slice on some worker */
+    VM_SCHED_PAUSED,        /* parked by sched_pause() or a breakpoint */
+    VM_SCHED_STOPPED        /* halted or faulted (see last) */
+} vm_sched_state_t;
+
+typedef struct sched_info {
+    vm_sched_state_t state;
+    vm_exit_t last;         /* exit that parked it */
+    uint64_t  retired;      /* instructions run by the scheduler */
+    uint64_t  slices;
+} sched_info_t;
+
+typedef struct sched_stats {
+    unsigned workers;
+    uint64_t slices;        /* all workers */
+    uint64_t steals;        /* slices taken from another worker's deque */
+} sched_stats_t;
+
+/* I/O exit hook, called on a worker thread (serialized between workers) */
+typedef void (*sched_io_fn)(void *opaque, int id, const vm_exit_t *x);
+
+typedef struct sched sched_t;
+
+/* workers 0: one per host CPU, at most SCHED_MAX_WORKERS */
+sched_t *sched_create(VMManager *m, unsigned workers);
+/* pauses everything still running, then joins the workers */
+void     sched_destroy(sched_t *s);
+
+void     sched_set_io(sched_t *s, sched_io_fn fn, void *opaque);
+
+/* Queue a VM (resumes a paused one); false if there is no such VM */
+bool     sched_start(sched_t *s, int id);
+/* Park a running VM after its current slice; returns once it is parked */
+bool     sched_pause(sched_t *s, int id);
+/* Block until no VM is running */
+void     sched_wait(sched_t *s);
+
+bool     sched_running(sched_t *s, int id);
+void     sched_info(sched_t *s, int id, sched_info_t *out);
+void     sched_get_stats(sched_t *s, sched_stats_t *out);
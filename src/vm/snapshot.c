@@ -0,0 +1,536 @@
+// src/vm/snapshot.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "vm/snapshot.h"
+#include "util/hostmem.h"
+
+#define SNAP_HDR_LEN    128u
+#define SNAP_CPU_LEN    32u
+#define SNAP_PATH_MAX   sizeof(((VM*)0)->snap_path)
+
+enum { SNAP_F_DELTA = 1u << 0 };
+
+/* ============================================================
+ * little-endian fields
+ * ============================================================ */
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put32(uint8_t *p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+static void put64(uint8_t *p, uint64_t v) { put32(p, (uint32_t)v); put32(p + 4, (uint32_t)(v >> 32)); }
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+static uint64_t get64(const uint8_t *p) { return get32(p) | ((uint64_t)get32(p + 4) << 32); }
+
+typedef struct snap_hdr {
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t npages;            // memmap pages (device block length)
+    uint32_t cpu_off, dev_off;
+    uint32_t flags;             // SNAP_F_*
+    uint64_t mem_off, mem_size;
+    uint64_t id, parent_id;     // version 2 on; 0 = none
+    uint32_t par_off, par_len;  // delta: parent path (no NUL)
+    uint32_t map_off;           // delta: bitmap of the RAM pages held
+} snap_hdr_t;
+
+/* a save-state file's metadata (everything but the RAM image) */
+typedef struct snap_file {
+    snap_hdr_t h;
+    uint8_t  cpu[SNAP_CPU_LEN];
+    uint8_t *kinds;             // npages memmap kinds
+    uint8_t *map;               // delta only
+    char     parent[SNAP_PATH_MAX];
+} snap_file_t;
+
+static void hdr_encode(const snap_hdr_t *h, uint8_t *b)
+{
+    memset(b, 0, SNAP_HDR_LEN);
+    memcpy(b, SNAP_MAGIC, 8);
+    put32(b + 8,  h->version);
+    put32(b + 12, h->page_size);
+    put32(b + 16, h->npages);
+    put32(b + 20, h->cpu_off);
+    put32(b + 24, h->dev_off);
+    put32(b + 28, h->flags);
+    put64(b + 32, h->mem_off);
+    put64(b + 40, h->mem_size);
+    put64(b + 48, h->id);
+    put64(b + 56, h->parent_id);
+    put32(b + 64, h->par_off);
+    put32(b + 68, h->par_len);
+    put32(b + 72, h->map_off);
+}
+
+static bool hdr_decode(const uint8_t *b, snap_hdr_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    if (memcmp(b, SNAP_MAGIC, 8) != 0) return false;
+    h->version   = get32(b + 8);
+    h->page_size = get32(b + 12);
+    h->npages    = get32(b + 16);
+    h->cpu_off   = get32(b + 20);
+    h->dev_off   = get32(b + 24);
+    h->mem_off   = get64(b + 32);
+    h->mem_size  = get64(b + 40);
+
+    // version 1 headers are 64 bytes with no ids and no deltas
+    if (h->version >= 2) {
+        h->flags     = get32(b + 28);
+        h->id        = get64(b + 48);
+        h->parent_id = get64(b + 56);
+        h->par_off   = get32(b + 64);
+        h->par_len   = get32(b + 68);
+        h->map_off   = get32(b + 72);
+    }
+    return true;
+}
+
+/* CPU block: ax bx cx dx sp bp si di cs ds es ss ip flags halted */
+static void cpu_encode(const x86_cpu_t *c, uint8_t *b)
+{
+    const uint16_t r[14] = {
+        c->ax, c->bx, c->cx, c->dx, c->sp, c->bp, c->si, c->di,
+        c->cs, c->ds, c->es, c->ss, c->ip, x86_flags(c)
+    };
+    memset(b, 0, SNAP_CPU_LEN);
+    for (unsigned i = 0; i < 14; i++) put16(b + 2 * i, r[i]);
+    b[28] = c->halted ? 1u : 0u;
+}
+
+static void cpu_decode(x86_cpu_t *c, const uint8_t *b)
+{
+    uint16_t *r[13] = {
+        &c->ax, &c->bx, &c->cx, &c->dx, &c->sp, &c->bp, &c->si, &c->di,
+        &c->cs, &c->ds, &c->es, &c->ss, &c->ip
+    };
+    for (unsigned i = 0; i < 13; i++) *r[i] = get16(b + 2 * i);
+    x86_flags_store(c, get16(b + 26));
+    c->halted = b[28] != 0;
+}
+
+/* RAM image pages (the last may be partial) and the delta bitmap size */
+static uint32_t img_pages(uint64_t mem_size) { return (uint32_t)((mem_size + MM_PAGE_MASK) >> MM_PAGE_SHIFT); }
+static size_t   map_bytes(uint64_t mem_size) { return (img_pages(mem_size) + 7u) / 8u; }
+
+static bool map_bit(const uint8_t *map, uint32_t pg) { return (map[pg / 8u] >> (pg % 8u)) & 1u; }
+
+static bool page_zero(const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (p[i]) return false;
+    return true;
+}
+
+static uint64_t snap_new_id(void)
+{
+    // unique enough to tell files apart: time, a counter and ASLR through
+    // a splitmix64 finalizer
+    static uint64_t seq;
+    uint64_t x = ((uint64_t)time(NULL) << 20) ^ (uint64_t)clock() ^ (++seq << 48) ^ (uint64_t)(uintptr_t)&seq;
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x ? x : 1u;
+}
+
+/* The next delta of vm is relative to this file (ids stay 0 if the
+   path would not fit, which just rules deltas out) */
+static void snap_set_parent(VM *vm, uint64_t id, const char *path)
+{
+    const bool fits = strlen(path) < sizeof(vm->snap_path);
+    vm->snap_id = fits ? id : 0;
+    snprintf(vm->snap_path, sizeof(vm->snap_path), "%s", fits ? path : "");
+    vm_dirty_start(vm);
+}
+
+/* ============================================================
+ * save
+ * ============================================================ */
+
+static bool snap_write(VM *vm, const char *path, bool delta)
+{
+    if (!vm || !path) return false;
+    if (delta && (!vm->dirty || !vm->snap_id)) return false;
+
+    const memmap_t *mm = &vm->mm;
+    for (uint32_t pg = 0; pg < mm->npages; pg++)
+        if (mm->pg[pg].kind == MM_MMIO) return false;
+
+    const uint32_t pages = img_pages(vm->mem_size);
+    const size_t   mlen  = delta ? map_bytes(vm->mem_size) : 0;
+    const uint32_t plen  = delta ? (uint32_t)strlen(vm->snap_path) : 0;
+
+    snap_hdr_t h = {
+        .version   = SNAP_VERSION,
+        .page_size = MM_PAGE_SIZE,
+        .npages    = mm->npages,
+        .cpu_off   = SNAP_HDR_LEN,
+        .dev_off   = SNAP_HDR_LEN + SNAP_CPU_LEN,
+        .flags     = delta ? SNAP_F_DELTA : 0u,
+        .mem_size  = vm->mem_size,
+        .id        = snap_new_id(),
+        .parent_id = delta ? vm->snap_id : 0u,
+    };
+    h.par_off = h.dev_off + h.npages;
+    h.par_len = plen;
+    h.map_off = h.par_off + plen;
+    h.mem_off = ((uint64_t)h.map_off + mlen + HOSTMEM_MAP_ALIGN - 1u) & ~(uint64_t)(HOSTMEM_MAP_ALIGN - 1u);
+
+    // a delta holds just the pages written since the parent
+    uint8_t *map = delta ? (uint8_t*)calloc(mlen, 1) : NULL;
+    if (delta && !map) return false;
+    for (uint32_t pg = 0; map && pg < pages; pg++)
+        if (vm_dirty_test(vm, pg)) map[pg / 8u] |= (uint8_t)(1u << (pg % 8u));
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        free(map);
+        return false;
+    }
+
+    uint8_t hdr[SNAP_HDR_LEN], cpu[SNAP_CPU_LEN];
+    hdr_encode(&h, hdr);
+    cpu_encode(&vm->cpu, cpu);
+
+    bool ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr) &&
+              fwrite(cpu, 1, sizeof(cpu), f) == sizeof(cpu);
+    for (uint32_t pg = 0; ok && pg < h.npages; pg++)
+        ok = fputc(mm->pg[pg].kind, f) != EOF;
+    if (ok && delta)
+        ok = fwrite(vm->snap_path, 1, plen, f) == plen && fwrite(map, 1, mlen, f) == mlen;
+
+    // RAM through the memmap (clone pages may live in a shared base);
+    // all-zero pages are skipped and stay holes
+    uint64_t end = h.mem_off;
+    for (uint32_t pg = 0; ok && pg < pages; pg++) {
+        if (map && !map_bit(map, pg)) continue;
+
+        const size_t off = (size_t)pg << MM_PAGE_SHIFT;
+        const size_t n = vm->mem_size - off < MM_PAGE_SIZE ? vm->mem_size - off : MM_PAGE_SIZE;
+        const uint8_t *src = mm_rd_ptr(mm, (uint32_t)off);
+        if (!src) src = vm->mem + off;  // unmapped or the ragged tail
+
+        // untouched demand-zero pages: don't fault them in just to scan
+        const bool own = src >= vm->mem && src < vm->mem + vm->mem_size;
+        if (own && !vm->mem_file && hostmem_resident(src, n) == 0) continue;
+        if (page_zero(src, n)) continue;
+
+        ok = fseek(f, (long)(h.mem_off + off), SEEK_SET) == 0 && fwrite(src, 1, n, f) == n;
+        end = h.mem_off + off + n;
+    }
+
+    // the image must reach its full length for the mapping
+    if (ok && end < h.mem_off + h.mem_size)
+        ok = fseek(f, (long)(h.mem_off + h.mem_size - 1u), SEEK_SET) == 0 && fputc(0, f) != EOF;
+
+    if (fclose(f) != 0) ok = false;
+    free(map);
+    if (!ok) {
+        remove(path);
+        return false;
+    }
+    snap_set_parent(vm, h.id, path);
+    return true;
+}
+
+bool vm_save(VM *vm, const char *path)
+{
+    return snap_write(vm, path, false);
+}
+
+bool vm_save_delta(VM *vm, const char *path)
+{
+    return snap_write(vm, path, true);
+}
+
+/* ============================================================
+ * restore
+ * ============================================================ */
+
+static void snap_close(snap_file_t *sf)
+{
+    free(sf->kinds);
+    free(sf->map);
+    sf->kinds = NULL;
+    sf->map = NULL;
+}
+
+static bool snap_read(const char *path, snap_file_t *sf)
+{
+    memset(sf, 0, sizeof(*sf));
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    uint8_t hdr[SNAP_HDR_LEN];
+    snap_hdr_t *h = &sf->h;
+
+    bool ok = fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && hdr_decode(hdr, h) &&
+              (h->version == 1u || h->version == SNAP_VERSION) && h->page_size == MM_PAGE_SIZE &&
+              h->mem_size >= 64u * 1024u && h->mem_size <= (1u << 30) && (h->mem_size & MM_PAGE_MASK) == 0 &&
+              (h->mem_off % HOSTMEM_MAP_ALIGN) == 0;
+    ok = ok && fseek(f, (long)h->cpu_off, SEEK_SET) == 0 && fread(sf->cpu, 1, SNAP_CPU_LEN, f) == SNAP_CPU_LEN;
+
+    // the memmap must come out the same size as at save time
+    const size_t phys = h->mem_size > VM_PHYS_MIN ? (size_t)h->mem_size : VM_PHYS_MIN;
+    ok = ok && h->npages == (uint32_t)((phys + MM_PAGE_MASK) >> MM_PAGE_SHIFT);
+
+    sf->kinds = ok ? (uint8_t*)malloc(h->npages) : NULL;
+    ok = sf->kinds && fseek(f, (long)h->dev_off, SEEK_SET) == 0 && fread(sf->kinds, 1, h->npages, f) == h->npages;
+
+    if (ok && (h->flags & SNAP_F_DELTA)) {
+        const size_t mlen = map_bytes(h->mem_size);
+        sf->map = (uint8_t*)malloc(mlen);
+        ok = sf->map && h->parent_id && h->par_len > 0 && h->par_len < SNAP_PATH_MAX &&
+             fseek(f, (long)h->par_off, SEEK_SET) == 0 && fread(sf->parent, 1, h->par_len, f) == h->par_len &&
+             fseek(f, (long)h->map_off, SEEK_SET) == 0 && fread(sf->map, 1, mlen, f) == mlen;
+    }
+    fclose(f);
+
+    // RAM/ROM pages must lie inside the image
+    for (uint32_t pg = 0; ok && pg < h->npages; pg++) {
+        const uint8_t k = sf->kinds[pg];
+        const bool backed = ((uint64_t)(pg + 1) << MM_PAGE_SHIFT) <= h->mem_size;
+        ok = k == MM_UNMAPPED || ((k == MM_RAM || k == MM_ROM) && backed);
+    }
+    if (!ok) snap_close(sf);
+    return ok;
+}
+
+/* A delta names its parent as it was given at save time; if that does
+   not open from here, look for the same file name next to the delta */
+static void snap_parent_path(const char *child, const char *parent, char *out, size_t cap)
+{
+    FILE *f = fopen(parent, "rb");
+    const char *dir = strrchr(child, '/');
+    const char *base = strrchr(parent, '/');
+#ifdef _WIN32
+    const char *bs = strrchr(child, '\\');
+    if (bs && (!dir || bs > dir)) dir = bs;
+    bs = strrchr(parent, '\\');
+    if (bs && (!base || bs > base)) base = bs;
+#endif
+    if (f || !dir) {
+        if (f) fclose(f);
+        snprintf(out, cap, "%s", parent);
+        return;
+    }
+    snprintf(out, cap, "%.*s%s", (int)(dir - child + 1), child, base ? base + 1 : parent);
+}
+
+/* Map (or read) the RAM pages a file holds into mem: all of them for a
+   full snapshot, the bitmap's for a delta */
+static bool snap_load_pages(const char *path, const snap_file_t *sf, uint8_t *mem, bool *mapped)
+{
+    const snap_hdr_t *h = &sf->h;
+    const uint32_t pages = img_pages(h->mem_size);
+    const size_t hpg = hostmem_page_size();
+    FILE *f = NULL;
+    bool ok = true;
+
+    uint32_t pg = 0;
+    while (ok && pg < pages) {
+        if (sf->map && !map_bit(sf->map, pg)) { pg++; continue; }
+        uint32_t end = pg + 1;
+        while (end < pages && (!sf->map || map_bit(sf->map, end))) end++;
+
+        const size_t off = (size_t)pg << MM_PAGE_SHIFT;
+        size_t n = ((size_t)end << MM_PAGE_SHIFT) - off;
+        if (off + n > h->mem_size) n = (size_t)h->mem_size - off;
+
+        // whole host pages are mapped over the buffer; the rest is read
+        size_t done = n & ~(hpg - 1u);
+        if (done && hostmem_map_file_at(mem + off, path, h->mem_off + off, done)) *mapped = true;
+        else done = 0;
+
+        if (done < n) {
+            if (!f) f = fopen(path, "rb");
+            ok = f && fseek(f, (long)(h->mem_off + off + done), SEEK_SET) == 0 &&
+                 fread(mem + off + done, 1, n - done, f) == n - done;
+        }
+        pg = end;
+    }
+    if (f) fclose(f);
+    return ok;
+}
+
+/* RAM image for the file at path with its chain of parents applied
+   (root first); sf gets path's own metadata. NULL on any mismatch. */
+static uint8_t *snap_image(const char *path, snap_file_t *sf, bool *mapped, unsigned depth)
+{
+    memset(sf, 0, sizeof(*sf));
+    if (depth > SNAP_MAX_CHAIN || !snap_read(path, sf)) return NULL;
+
+    const size_t len = (size_t)sf->h.mem_size;
+    uint8_t *mem = NULL;
+
+    if (!(sf->h.flags & SNAP_F_DELTA)) {
+        // full image: one private mapping of the whole section
+        mem = hostmem_map_file(path, sf->h.mem_off, len);
+        *mapped = mem != NULL;
+        if (!mem && (mem = hostmem_alloc(len)) != NULL && !snap_load_pages(path, sf, mem, mapped)) {
+            hostmem_free(mem, len);
+            mem = NULL;
+        }
+    } else {
+        char ppath[SNAP_PATH_MAX];
+        snap_file_t parent;
+        snap_parent_path(path, sf->parent, ppath, sizeof(ppath));
+
+        mem = snap_image(ppath, &parent, mapped, depth + 1u);
+        const bool ok = mem && parent.h.id == sf->h.parent_id && parent.h.mem_size == sf->h.mem_size &&
+                        snap_load_pages(path, sf, mem, mapped);
+        snap_close(&parent);
+        if (!ok) {
+            hostmem_free(mem, len);
+            mem = NULL;
+        }
+    }
+    if (!mem) snap_close(sf);
+    return mem;
+}
+
+int vm_restore(VMManager *m, const char *path, const char *name)
+{
+    snap_file_t sf;
+    bool mapped = false;
+
+    uint8_t *mem = snap_image(path, &sf, &mapped, 0);
+    if (!mem) return -1;
+
+    int id = vm_create_on(m, mem, (size_t)sf.h.mem_size, name, mapped);
+    if (id < 0) {
+        snap_close(&sf);
+        return -1;
+    }
+    VM *vm = vm_get(m, id);
+
+    // page kinds in runs (create mapped all of RAM)
+    uint32_t pg = 0;
+    while (pg < sf.h.npages) {
+        uint32_t end = pg + 1;
+        while (end < sf.h.npages && sf.kinds[end] == sf.kinds[pg]) end++;
+
+        const uint32_t base = pg << MM_PAGE_SHIFT, size = (end - pg) << MM_PAGE_SHIFT;
+        if (sf.kinds[pg] == MM_ROM)           mm_map_rom(&vm->mm, base, size, vm->mem + base);
+        else if (sf.kinds[pg] == MM_UNMAPPED) mm_unmap(&vm->mm, base, size);
+        pg = end;
+    }
+
+    cpu_decode(&vm->cpu, sf.cpu);
+    vm_code_flush(vm);
+    snap_set_parent(vm, sf.h.id, path);
+    snap_close(&sf);
+    return id;
+}
+
+/* ============================================================
+ * diff
+ * ============================================================ */
+
+/* Pages that can differ between the file at path and its ancestor
+   stop_id: the union of the delta maps in between. NULL if stop_id is
+   not an ancestor (then everything has to be compared). */
+static uint8_t *snap_changed_since(const char *path, const snap_file_t *top, uint64_t stop_id)
+{
+    const size_t mlen = map_bytes(top->h.mem_size);
+    uint8_t *u = stop_id ? (uint8_t*)calloc(mlen, 1) : NULL;
+    if (!u) return NULL;
+
+    char cur[SNAP_PATH_MAX], next[SNAP_PATH_MAX];
+    snap_file_t anc = {0};
+    const snap_file_t *sf = top;
+    snprintf(cur, sizeof(cur), "%s", path);
+
+    for (unsigned depth = 0; sf && depth <= SNAP_MAX_CHAIN; depth++) {
+        if (sf->h.id == stop_id) {
+            snap_close(&anc);
+            return u;
+        }
+        if (!(sf->h.flags & SNAP_F_DELTA) || sf->h.mem_size != top->h.mem_size) break;
+        for (size_t i = 0; i < mlen; i++) u[i] |= sf->map[i];
+
+        snap_parent_path(cur, sf->parent, next, sizeof(next));
+        memcpy(cur, next, sizeof(cur));
+        snap_close(&anc);
+        sf = snap_read(cur, &anc) ? &anc : NULL;
+    }
+    snap_close(&anc);
+    free(u);
+    return NULL;
+}
+
+long vm_snap_diff(const char *a, const char *b, FILE *out)
+{
+    snap_file_t sa, sb;
+    bool ma = false, mb = false;
+    long n = -1;
+
+    uint8_t *ia = snap_image(a, &sa, &ma, 0);
+    uint8_t *ib = ia ? snap_image(b, &sb, &mb, 0) : NULL;
+
+    if (ib && sa.h.mem_size == sb.h.mem_size && sa.h.npages == sb.h.npages) {
+        // along one chain only the deltas' pages need comparing
+        uint8_t *cand = snap_changed_since(b, &sb, sa.h.id);
+        if (!cand) cand = snap_changed_since(a, &sa, sb.h.id);
+
+        const uint32_t pages = img_pages(sa.h.mem_size);
+        uint32_t run = 0;
+        bool in_run = false;
+        n = 0;
+
+        for (uint32_t pg = 0; pg <= sa.h.npages; pg++) {
+            bool d = false;
+            if (pg < sa.h.npages) {
+                d = sa.kinds[pg] != sb.kinds[pg];
+                if (!d && pg < pages && (!cand || map_bit(cand, pg))) {
+                    const size_t off = (size_t)pg << MM_PAGE_SHIFT;
+                    const size_t len = sa.h.mem_size - off < MM_PAGE_SIZE ? (size_t)sa.h.mem_size - off : MM_PAGE_SIZE;
+                    d = memcmp(ia + off, ib + off, len) != 0;
+                }
+            }
+            if (d) n++;
+            if (d && !in_run) run = pg;
+            if (!d && in_run && out)
+                fprintf(out, "%08X-%08X  %u page%s\n", run << MM_PAGE_SHIFT, (pg << MM_PAGE_SHIFT) - 1u,
+                        pg - run, pg - run == 1 ? "" : "s");
+            in_run = d;
+        }
+        free(cand);
+    }
+
+    if (ib) {
+        hostmem_free(ib, (size_t)sb.h.mem_size);
+        snap_close(&sb);
+    }
+    if (ia) {
+        hostmem_free(ia, (size_t)sa.h.mem_size);
+        snap_close(&sa);
+    }
+    return n;
+}
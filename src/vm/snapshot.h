@@ -0,0 +1,69 @@
+// src/vm/snapshot.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "vm/vm.h"
+
+/*
+ * Save-state files.
+ *
+ *   0x0000  header: magic "X64VMSNP", version, ids, section offsets
+ *   ......  CPU block: registers, materialized FLAGS, halted
+ *   ......  device block: one memmap kind byte per guest page
+ *   ......  delta only: parent path, then a bitmap of the RAM pages held
+ *   mem_off RAM image, mem_size bytes, mem_off a HOSTMEM_MAP_ALIGN
+ *           multiple so restore can map it MAP_PRIVATE in place
+ *
+ * All integers are little endian. Every file has a random id. A full
+ * snapshot holds all of RAM, with all-zero pages left as holes (sparse
+ * file). A delta holds only the pages written since its parent (the
+ * VM's previous save or the file it was restored from, see
+ * vm_dirty_start), at the same offsets, so restore maps the root image
+ * and then maps each delta's pages over it: nothing is read up front,
+ * pages come in as the guest touches them and writes stay in the
+ * process. Hosts without private file mappings read the pages instead.
+ *
+ * MMIO devices are host callbacks and cannot be saved; a VM with MMIO
+ * pages is refused.
+ */
+
+#define SNAP_MAGIC      "X64VMSNP"
+#define SNAP_VERSION    2u
+
+#ifndef SNAP_MAX_CHAIN
+#define SNAP_MAX_CHAIN  64      // deltas between a file and its full root
+#endif
+
+/* Full save-state; the file becomes vm's parent for the next delta */
+bool vm_save(VM *vm, const char *path);
+
+/* Only the pages dirtied since vm's last save/restore (false if it has
+   none); the new file becomes the parent in turn */
+bool vm_save_delta(VM *vm, const char *path);
+
+/* New VM (made current) from a save-state and its parents; id or -1 */
+int  vm_restore(VMManager *m, const char *path, const char *name);
+
+/* Print the guest pages whose contents or kind differ between two
+   save-states as merged ranges; number of pages, -1 on error */
+long vm_snap_diff(const char *a, const char *b, FILE *out);
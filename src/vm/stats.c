@@ -0,0 +1,187 @@
+// src/vm/stats.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L     // clock_gettime under -std=c11
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "vm/stats.h"
+
+/* ============================================================
+ * counting
+ * ============================================================ */
+
+void stats_reset(vm_stats_t *s)
+{
+    const bool on = s->on;
+    memset(s, 0, sizeof(*s));
+    s->on = on;
+}
+
+void stats_count_handler(vm_stats_t *s, const x86_decoded_t *d)
+{
+    const uintptr_t h = (uintptr_t)d->fn;
+    unsigned slot = (unsigned)((h >> 4) ^ (h >> 12)) & (STATS_HANDLERS - 1u);
+
+    for (unsigned n = 0; n < STATS_HANDLERS; n++) {
+        stats_handler_t *e = &s->handler[slot];
+        if (e->fn == d->fn) { e->count++; return; }
+        if (!e->fn) {
+            e->fn = d->fn;
+            e->op = d->op;
+            e->modrm = d->modrm;
+            e->count = 1;
+            return;
+        }
+        slot = (slot + 1u) & (STATS_HANDLERS - 1u);
+    }
+    s->handler_overflow++;
+}
+
+uint64_t stats_clock_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (uint64_t)((double)t.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* ============================================================
+ * reports
+ * ============================================================ */
+
+static uint64_t op_total(const vm_stats_t *s)
+{
+    uint64_t t = 0;
+    for (unsigned i = 0; i < STATS_NOPS; i++) t += s->op_retired[i];
+    return t;
+}
+
+static double ips(const vm_stats_t *s)
+{
+    return s->run_ns ? (double)s->run_retired * 1e9 / (double)s->run_ns : 0.0;
+}
+
+// "8B" or "0FB6"
+static const char *op_name(unsigned op, char buf[8])
+{
+    snprintf(buf, 8, (op >> 8) ? "%04X" : "%02X", op);
+    return buf;
+}
+
+static unsigned op_code(unsigned i)
+{
+    return i < 256u ? i : 0x0F00u | (i - 256u);
+}
+
+static int cmp_count_desc(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x < y) - (x > y);
+}
+
+void stats_print(const vm_stats_t *s, FILE *fp)
+{
+    const uint64_t total = op_total(s);
+
+    fprintf(fp, "stats: %s\n", s->on ? "on" : "off");
+    fprintf(fp, "run:   %llu insns in %.3f ms (%.2f MIPS)\n",
+            (unsigned long long)s->run_retired, (double)s->run_ns / 1e6, ips(s) / 1e6);
+    fprintf(fp, "rep:   %llu insns, %llu iterations\n",
+            (unsigned long long)s->rep_insns, (unsigned long long)s->rep_iters);
+    if (!total) return;
+
+    fprintf(fp, "\n  %-4s %12s  %5s  %8s %8s\n", "op", "retired", "%", "fault", "illegal");
+    for (unsigned i = 0; i < STATS_NOPS; i++) {
+        if (!s->op_retired[i] && !s->op_fault[i] && !s->op_illegal[i]) continue;
+        char nb[8];
+        fprintf(fp, "  %-4s %12llu  %5.1f  %8llu %8llu\n", op_name(op_code(i), nb),
+                (unsigned long long)s->op_retired[i], 100.0 * (double)s->op_retired[i] / (double)total,
+                (unsigned long long)s->op_fault[i], (unsigned long long)s->op_illegal[i]);
+    }
+
+    // handlers, busiest first: sort (count, slot) pairs
+    uint64_t order[STATS_HANDLERS][2];
+    unsigned n = 0;
+    for (unsigned i = 0; i < STATS_HANDLERS; i++) {
+        if (!s->handler[i].fn) continue;
+        order[n][0] = s->handler[i].count;
+        order[n][1] = i;
+        n++;
+    }
+    qsort(order, n, sizeof(order[0]), cmp_count_desc);
+
+    fprintf(fp, "\n  %-18s  %-8s  %12s\n", "handler", "first", "retired");
+    for (unsigned k = 0; k < n; k++) {
+        const stats_handler_t *h = &s->handler[order[k][1]];
+        char nb[8];
+        fprintf(fp, "  %-18p  %-4s /%02X  %12llu\n", (void*)h->fn, op_name(h->op, nb), h->modrm,
+                (unsigned long long)h->count);
+    }
+    if (s->handler_overflow)
+        fprintf(fp, "  %-18s  %-8s  %12llu\n", "(other)", "", (unsigned long long)s->handler_overflow);
+}
+
+void stats_json(const vm_stats_t *s, FILE *fp)
+{
+    fprintf(fp, "{\"on\":%s,\"run_retired\":%llu,\"run_ns\":%llu,\"ips\":%.0f,"
+                "\"rep_insns\":%llu,\"rep_iters\":%llu,\"opcodes\":[",
+            s->on ? "true" : "false",
+            (unsigned long long)s->run_retired, (unsigned long long)s->run_ns, ips(s),
+            (unsigned long long)s->rep_insns, (unsigned long long)s->rep_iters);
+
+    const char *sep = "";
+    for (unsigned i = 0; i < STATS_NOPS; i++) {
+        if (!s->op_retired[i] && !s->op_fault[i] && !s->op_illegal[i]) continue;
+        char nb[8];
+        fprintf(fp, "%s{\"op\":\"%s\",\"retired\":%llu,\"fault\":%llu,\"illegal\":%llu}", sep, op_name(op_code(i), nb),
+                (unsigned long long)s->op_retired[i], (unsigned long long)s->op_fault[i],
+                (unsigned long long)s->op_illegal[i]);
+        sep = ",";
+    }
+
+    fprintf(fp, "],\"handlers\":[");
+    sep = "";
+    for (unsigned i = 0; i < STATS_HANDLERS; i++) {
+        const stats_handler_t *h = &s->handler[i];
+        if (!h->fn) continue;
+        char nb[8];
+        fprintf(fp, "%s{\"fn\":\"%p\",\"op\":\"%s\",\"modrm\":\"%02X\",\"retired\":%llu}", sep,
+                (void*)h->fn, op_name(h->op, nb), h->modrm, (unsigned long long)h->count);
+        sep = ",";
+    }
+    fprintf(fp, "],\"handler_overflow\":%llu}\n", (unsigned long long)s->handler_overflow);
+}
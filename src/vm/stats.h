@@ -0,0 +1,89 @@
+// src/vm/stats.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "cpu/cpu_types.h"
+#include "cpu/decode.h"     // x86_decoded_t, x86_fn_t
+
+/*
+ * Per-VM execution counters.
+ *
+ * Off by default. The interpreter hooks (cpu_execute, the block
+ * executor, the REP engine) test `on` and do nothing else while it is
+ * clear. When on, every retired instruction bumps its opcode's count
+ * and its handler's count; non-OK statuses are booked by opcode as
+ * faults (X86_FAULT) or illegal (X86_ERR/X86_ILLEGAL).
+ *
+ * Instructions run inside JIT-translated blocks only show up in the
+ * retired/time totals (vm_run), not per opcode.
+ */
+
+#define STATS_NOPS      512     // 00-FF, then 0F00-0FFF at +256
+#define STATS_HANDLERS  256     // open-addressed, power of two
+
+typedef struct stats_handler {
+    x86_fn_t fn;                // NULL: free slot
+    uint16_t op;                // first opcode seen with this handler
+    uint8_t  modrm;             // ... and its ModRM byte
+    uint64_t count;
+} stats_handler_t;
+
+typedef struct vm_stats {
+    bool on;
+
+    uint64_t op_retired[STATS_NOPS];
+    uint64_t op_fault[STATS_NOPS];
+    uint64_t op_illegal[STATS_NOPS];
+
+    stats_handler_t handler[STATS_HANDLERS];
+    uint64_t handler_overflow;  // table full: counted here
+
+    uint64_t rep_insns;         // REP-prefixed string dispatches
+    uint64_t rep_iters;         // elements they processed
+
+    uint64_t run_retired;       // vm_run totals, all tiers
+    uint64_t run_ns;
+} vm_stats_t;
+
+void     stats_reset(vm_stats_t *s);                // clears counters, keeps `on`
+void     stats_print(const vm_stats_t *s, FILE *fp);
+void     stats_json (const vm_stats_t *s, FILE *fp);
+uint64_t stats_clock_ns(void);                      // monotonic
+
+void stats_count_handler(vm_stats_t *s, const x86_decoded_t *d);
+
+static inline unsigned stats_op_index(uint16_t op)
+{
+    return (op >> 8) ? 256u + (op & 0xFFu) : op;
+}
+
+/* One retired instruction (call only when s->on) */
+static inline void stats_retire(vm_stats_t *s, const x86_decoded_t *d, x86_status_t st)
+{
+    const unsigned i = stats_op_index(d->op);
+
+    s->op_retired[i]++;
+    if (st == X86_FAULT) s->op_fault[i]++;
+    else if (st == X86_ERR || st == X86_ILLEGAL) s->op_illegal[i]++;
+    stats_count_handler(s, d);
+}
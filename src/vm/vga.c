@@ -0,0 +1,96 @@
+// src/vm/vga.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm/vga.h"
+#include "vm/vm.h"
+
+/* ============================================================
+ * MMIO callbacks (offsets are relative to VGA_TEXT_BASE)
+ * ============================================================ */
+
+static uint8_t vga_read(void *opaque, uint32_t off)
+{
+    return ((const vga_text_t*)opaque)->vram[off];
+}
+
+static void vga_write(void *opaque, uint32_t off, uint8_t val)
+{
+    vga_text_t *g = (vga_text_t*)opaque;
+    g->vram[off] = val;
+    g->writes++;
+}
+
+/* ============================================================
+ * attach / clone
+ * ============================================================ */
+
+bool vga_attach(VM *vm)
+{
+    if (!vm) return false;
+    if (vm->vga) return true;
+
+    vga_text_t *g = (vga_text_t*)calloc(1, sizeof(*g));
+    if (!g) return false;
+
+    if (!mm_map_mmio(&vm->mm, VGA_TEXT_BASE, VGA_TEXT_SIZE, vga_read, vga_write, g, "vga text")) {
+        free(g);
+        return false;
+    }
+    vm->vga = g;
+
+    // the window now hides whatever RAM blocks were decoded there
+    vm_code_flush(vm);
+    return true;
+}
+
+bool vga_clone(VM *dst, const VM *src)
+{
+    if (!src->vga) return true;
+
+    vga_text_t *g = (vga_text_t*)malloc(sizeof(*g));
+    if (!g) return false;
+    memcpy(g, src->vga, sizeof(*g));
+
+    // dst's memmap is a copy of src's and still points at src's screen
+    mm_mmio_rebind(&dst->mm, src->vga, g);
+    dst->vga = g;
+    return true;
+}
+
+/* ============================================================
+ * text dump
+ * ============================================================ */
+
+void vga_dump(const vga_text_t *g, FILE *fp)
+{
+    for (unsigned row = 0; row < VGA_TEXT_ROWS; row++) {
+        const uint8_t *cell = g->vram + row * VGA_TEXT_COLS * 2u;
+
+        unsigned len = VGA_TEXT_COLS;
+        while (len && (cell[(len - 1u) * 2u] == ' ' || cell[(len - 1u) * 2u] == 0)) len--;
+
+        for (unsigned col = 0; col < len; col++) {
+            const uint8_t ch = cell[col * 2u];
+            fputc(ch >= 0x20 && ch < 0x7F ? ch : ' ', fp);
+        }
+        fputc('\n', fp);
+    }
+}
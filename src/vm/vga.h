@@ -0,0 +1,57 @@
+// src/vm/vga.h
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * VGA text window.
+ *
+ * 0xB8000-0xBFFFF as an MMIO region over device memory of its own, so
+ * a guest writing the screen lands in vga_text_t rather than in RAM and
+ * the host can see every store. Those eight pages are the only ones
+ * that go through callbacks; the rest of RAM keeps its direct tables.
+ *
+ * Attaching is opt-in (REPL `vga on`, manifest `vga = on`). Clones get
+ * their own copy of the screen; save-states refuse MMIO pages, so a VM
+ * with the window attached cannot be saved.
+ */
+
+#define VGA_TEXT_BASE 0xB8000u
+#define VGA_TEXT_SIZE 0x8000u
+#define VGA_TEXT_COLS 80u
+#define VGA_TEXT_ROWS 25u
+
+typedef struct vga_text {
+    uint8_t  vram[VGA_TEXT_SIZE];   /* char, attribute pairs */
+    uint64_t writes;                /* guest stores into the window */
+} vga_text_t;
+
+typedef struct VM VM;    // forward declare the real VM type (vm/vm.h)
+
+/* Map the window over vm's physical space (no-op if already attached) */
+bool vga_attach(VM *vm);
+
+/* dst (a fresh clone of src) gets its own copy of src's screen */
+bool vga_clone(VM *dst, const VM *src);
+
+/* Print page 0 as 80x25 text, trailing blanks trimmed */
+void vga_dump(const vga_text_t *g, FILE *fp);
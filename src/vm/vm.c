@@ -17,84 +17,240 @@
  */
 
 #include "vm/vm.h"
-#include "cpu/disasm.h"
 #include "util/log.h"
+#include "util/hostmem.h"
 #include "cpu/exec_ctx.h"
 #include "cpu/x86_cpu.h"
 #include "cpu/execute.h"
+#include "cpu/trace.h"
+#include "jit/jit.h"
+#include "vm/vga.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+/* ============================================================
+ * registry
+ * ============================================================ */
+
+#define VM_NAME_BUCKETS 64u     // initial; doubles with the VM count
+
+static uint32_t name_hash(const char *name) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (; *name; name++) h = (h ^ (uint8_t)*name) * 16777619u;
+    return h;
+}
+
+static int vm_id_of(const VMManager *m, uint32_t idx) {
+    return (int)(m->slots[idx].gen << VM_ID_INDEX_BITS | idx);
+}
+
+static uint32_t vm_index(const VM *v) {
+    return (uint32_t)v->id & VM_ID_INDEX_MASK;
+}
+
 void vmman_init(VMManager *m) {
     memset(m, 0, sizeof(*m));
+    m->free_head = -1;
     m->current = -1;
-    for (int i = 0; i < VM_MAX; i++) {
-        m->vms[i].id = i;
-        m->vms[i].in_use = false;
+}
+
+void vmman_free(VMManager *m) {
+    if (!m) return;
+    for (VM *v = vm_next(m, NULL); v; v = vm_next(m, v))
+        vm_destroy(m, v->id);
+    for (unsigned i = 0; i < m->nslabs; i++) free(m->slabs[i]);
+    free(m->slabs);
+    free(m->slots);
+    free(m->names);
+    vmman_init(m);
+}
+
+/* Another slab of VM objects; its slots go on the free list lowest first */
+static bool vm_slab_add(VMManager *m) {
+    if (m->nslots + VM_SLAB > VM_ID_INDEX_MASK + 1u) return false;
+
+    VM **slabs = (VM**)realloc(m->slabs, (m->nslabs + 1u) * sizeof(*slabs));
+    if (!slabs) return false;
+    m->slabs = slabs;
+
+    vm_slot_t *slots = (vm_slot_t*)realloc(m->slots, (m->nslots + VM_SLAB) * sizeof(*slots));
+    if (!slots) return false;
+    m->slots = slots;
+
+    // calloc'd objects are already clear, and untouched parts (stats
+    // tables) stay unbacked until a VM uses them
+    VM *slab = (VM*)calloc(VM_SLAB, sizeof(*slab));
+    if (!slab) return false;
+    m->slabs[m->nslabs++] = slab;
+
+    for (uint32_t i = VM_SLAB; i-- > 0; ) {
+        const uint32_t idx = m->nslots + i;
+        m->slots[idx] = (vm_slot_t){ .vm = &slab[i], .gen = 0, .next_free = m->free_head, .next_name = -1 };
+        m->free_head = (int32_t)idx;
     }
+    m->nslots += VM_SLAB;
+    return true;
 }
 
-static int find_free_slot(VMManager *m) {
-    for (int i = 0; i < VM_MAX; i++) {
-        if (!m->vms[i].in_use) return i;
+static bool names_grow(VMManager *m) {
+    const uint32_t n = m->nbuckets ? m->nbuckets * 2u : VM_NAME_BUCKETS;
+    int32_t *b = (int32_t*)malloc(n * sizeof(*b));
+    if (!b) return false;
+    for (uint32_t i = 0; i < n; i++) b[i] = -1;
+
+    // rehash oldest first so each chain stays newest-first
+    for (uint32_t idx = 0; idx < m->nslots; idx++) m->slots[idx].next_name = -1;
+    free(m->names);
+    m->names = b;
+    m->nbuckets = n;
+    for (uint32_t idx = 0; idx < m->nslots; idx++) {
+        VM *v = m->slots[idx].vm;
+        if (!v->in_use) continue;
+        int32_t *head = &m->names[name_hash(v->name) & (n - 1u)];
+        m->slots[idx].next_name = *head;
+        *head = (int32_t)idx;
     }
-    return -1;
+    return true;
 }
 
-int vm_create_default(VMManager *m, size_t ram_bytes, const char *name) {
-    int id = find_free_slot(m);
-    if (id < 0) return -1;
+static void name_unlink(VMManager *m, uint32_t idx) {
+    int32_t *link = &m->names[name_hash(m->slots[idx].vm->name) & (m->nbuckets - 1u)];
+    while (*link >= 0 && *link != (int32_t)idx) link = &m->slots[*link].next_name;
+    if (*link >= 0) *link = m->slots[idx].next_name;
+    m->slots[idx].next_name = -1;
+}
+
+/* Take a free VM object and give it an id and a name */
+static VM *claim_slot(VMManager *m, const char *name) {
+    if (m->count + 1u > m->nbuckets && !names_grow(m) && !m->nbuckets) return NULL;
+    if (m->free_head < 0 && !vm_slab_add(m)) return NULL;
 
-    VM *v = &m->vms[id];
-    memset(v, 0, sizeof(*v));
-    v->id = id;
+    const uint32_t idx = (uint32_t)m->free_head;
+    vm_slot_t *sl = &m->slots[idx];
+    m->free_head = sl->next_free;
+
+    VM *v = sl->vm;
+    if (sl->used) memset(v, 0, sizeof(*v));
+    sl->used = true;
+    v->id = vm_id_of(m, idx);
     v->in_use = true;
 
     if (name && *name) {
         strncpy(v->name, name, sizeof(v->name) - 1);
         v->name[sizeof(v->name) - 1] = '\0';
     } else {
-        snprintf(v->name, sizeof(v->name), "vm%d", id);
+        snprintf(v->name, sizeof(v->name), "vm%d", v->id);
+    }
+
+    int32_t *head = &m->names[name_hash(v->name) & (m->nbuckets - 1u)];
+    sl->next_name = *head;
+    *head = (int32_t)idx;
+    m->count++;
+    return v;
+}
+
+/* Back on the free list under a new generation; a slot whose generation
+   would overflow the id is retired instead */
+static void release_slot(VMManager *m, VM *v) {
+    const uint32_t idx = vm_index(v);
+    vm_slot_t *sl = &m->slots[idx];
+
+    name_unlink(m, idx);
+    v->in_use = false;
+    v->name[0] = '\0';
+    m->count--;
+    if (m->current == v->id) m->current = -1;
+
+    if (sl->gen == VM_ID_GEN_MAX) return;
+    sl->gen++;
+    sl->next_free = m->free_head;
+    m->free_head = (int32_t)idx;
+}
+
+int vm_create_default(VMManager *m, size_t ram_bytes, const char *name) {
+    // the memory map works in whole pages: round a partial last page up
+    if (ram_bytes <= SIZE_MAX - MM_PAGE_MASK)
+        ram_bytes = (ram_bytes + MM_PAGE_MASK) & ~(size_t)MM_PAGE_MASK;
+
+    // demand-zero: only pages the guest touches become resident
+    return vm_create_on(m, hostmem_alloc(ram_bytes), ram_bytes, name, false);
+}
+
+int vm_create_on(VMManager *m, uint8_t *mem, size_t ram_bytes, const char *name, bool mem_file) {
+    // a partial last page could be neither mapped nor snapshotted
+    const bool whole = ram_bytes && !(ram_bytes & MM_PAGE_MASK);
+    VM *v = mem && whole ? claim_slot(m, name) : NULL;
+    if (!v) {
+        hostmem_free(mem, ram_bytes);
+        return -1;
     }
 
     /* trace/log defaults */
-    v->trace.enabled = false;
-    v->trace.flags   = 0;
+    v->trace.flags   = TRACE_OFF;
+    v->trace.fp      = NULL;
     v->log           = NULL;
 
-    v->mem = (uint8_t*)calloc(1, ram_bytes);
-    if (!v->mem) {
-        v->in_use = false;
+    v->mem = mem;
+    v->mem_size = ram_bytes;
+    v->mem_file = mem_file;
+
+    size_t phys = ram_bytes > VM_PHYS_MIN ? ram_bytes : VM_PHYS_MIN;
+    uint32_t npages = (uint32_t)((phys + MM_PAGE_MASK) >> MM_PAGE_SHIFT);
+
+    if (!mm_init(&v->mm, npages) ||
+        !mm_map_ram(&v->mm, 0, (uint32_t)ram_bytes, v->mem) ||
+        !bcache_init(&v->bc)) {
+        mm_free(&v->mm);
+        hostmem_free(v->mem, ram_bytes);
+        v->mem = NULL;
+        release_slot(m, v);
         return -1;
     }
-    v->mem_size = ram_bytes;
 
     x86_init(&v->cpu, v->mem, v->mem_size);
     v->cpu_inited = true;
 
+    v->ctx = (exec_ctx_t){ .cpu = &v->cpu, .vm = v };
+
     /* default start (you can change later) */
     v->cpu.cs = 0x0000;
     v->cpu.ip = 0x1000;
 
     /* auto-select created VM */
-    m->current = id;
-    return id;
+    m->current = v->id;
+    return v->id;
+}
+
+static void vm_bases_release(VM *v);
+static void vm_imgs_release(VM *v);
+
+/* free everything a VM owns; the slot itself stays claimed */
+static void vm_release(VM *v) {
+    jit_destroy(v->jit);
+    v->jit = NULL;
+    bcache_free(&v->bc);
+    prof_free(&v->prof);
+    mm_free(&v->mm);
+    hostmem_free(v->mem, v->mem_size);
+    vm_bases_release(v);
+    vm_imgs_release(v);
+    free(v->dirty);
+    v->dirty = NULL;
+    free(v->vga);
+    v->vga = NULL;
+    v->mem = NULL;
+    v->mem_size = 0;
 }
 
 bool vm_destroy(VMManager *m, int id) {
     VM *v = vm_get(m, id);
     if (!v) return false;
 
-    free(v->mem);
-    v->mem = NULL;
-    v->mem_size = 0;
+    vm_release(v);
     v->cpu_inited = false;
-    v->in_use = false;
-    v->name[0] = '\0';
-
-    if (m->current == id) m->current = -1;
+    release_slot(m, v);
     return true;
 }
 
@@ -106,96 +262,673 @@ bool vm_use(VMManager *m, int id) {
 }
 
 VM *vm_get(VMManager *m, int id) {
-    if (!m) return NULL;
-    if (id < 0 || id >= VM_MAX) return NULL;
-    if (!m->vms[id].in_use) return NULL;
-    return &m->vms[id];
+    if (!m || id < 0) return NULL;
+
+    const uint32_t idx = (uint32_t)id & VM_ID_INDEX_MASK;
+    if (idx >= m->nslots) return NULL;
+
+    const vm_slot_t *sl = &m->slots[idx];
+    if (!sl->vm->in_use || sl->vm->id != id) return NULL;
+    return sl->vm;
 }
 
 VM *vm_current(VMManager *m) {
     return vm_get(m, m->current);
 }
 
+VM *vm_find(VMManager *m, const char *name) {
+    if (!m || !name || !m->nbuckets) return NULL;
+
+    for (int32_t i = m->names[name_hash(name) & (m->nbuckets - 1u)]; i >= 0; i = m->slots[i].next_name) {
+        VM *v = m->slots[i].vm;
+        if (!strcmp(v->name, name)) return v;
+    }
+    return NULL;
+}
+
+VM *vm_next(VMManager *m, const VM *prev) {
+    for (uint32_t i = prev ? vm_index(prev) + 1u : 0; i < m->nslots; i++)
+        if (m->slots[i].vm->in_use) return m->slots[i].vm;
+    return NULL;
+}
+
+unsigned vm_count(const VMManager *m) {
+    return m->count;
+}
+
 void vm_list(VMManager *m) {
     printf("VMs:\n");
-    for (int i = 0; i < VM_MAX; i++) {
-        VM *v = &m->vms[i];
-        if (!v->in_use) continue;
-        printf("  %c id=%d name=%s ram=%zu\n",
-               (m->current == i) ? '*' : ' ',
-               i, v->name, v->mem_size);
+    for (VM *v = vm_next(m, NULL); v; v = vm_next(m, v)) {
+        printf("  %c id=%d name=%s ram=%zu resident=%zu\n",
+               (m->current == v->id) ? '*' : ' ',
+               v->id, v->name, v->mem_size, vm_ram_resident(v));
     }
+
+    img_stats_t st;
+    img_get_stats(&st);
+    if (st.images)
+        printf("shared images: %u, %zu KiB, %u refs, %llu reused\n",
+               st.images, st.bytes / 1024u, st.refs, (unsigned long long)st.hits);
 }
 
 x86_status_t vm_step(VM *vm) {
     if (!vm) return X86_HALT; /* or whatever "bad" status you prefer */
-    x86_cpu_t *c = &vm->cpu;
-
-    /* ---- TRACE PRE ---- */
-    if (vm->trace.enabled && vm->log) {
-        uint32_t lin = ((uint32_t)c->cs << 4) + c->ip;
-
-        char bytes[3 * 16 + 1];
-        size_t n = 0;
-        for (unsigned i = 0; i < 16 && (size_t)(lin + i) < vm->mem_size; i++) {
-            n += (size_t)snprintf(bytes + n, sizeof(bytes) - n,
-                                  "%02X ", vm->mem[lin + i]);
-            if (n >= sizeof(bytes)) break;
-        }
-        if (n) bytes[(n - 1 < sizeof(bytes)) ? (n - 1) : (sizeof(bytes) - 1)] = 0;
+    return x86_step(&vm->ctx);
+}
+
+static bool at_breakpoint(const VM *vm)
+{
+    const uint32_t lin = x86_linear_addr(vm->cpu.cs, vm->cpu.ip);
+    for (unsigned i = 0; i < vm->nbp; i++) {
+        if (vm->bp[i] == lin) return true;
+    }
+    return false;
+}
 
-        x86_disasm_t d = x86_disasm_one_16(vm->mem, vm->mem_size, lin);
+/*
+ * Batched run loop.
+ *
+ * Fast path (no breakpoints, trace tier off): whole cached basic blocks,
+ * nothing per instruction beyond the handler call, or translated host
+ * code when the JIT tier is on. Breakpoints or tracing drop to one
+ * instruction at a time so they can be checked before each one. After
+ * a breakpoint exit the next call steps over that breakpoint once so
+ * that 'run' resumes.
+ */
+x86_status_t vm_run(VM *vm, uint64_t budget, vm_exit_t *why)
+{
+    vm_exit_t x = {0};
+    x86_status_t st = X86_OK;
+    uint64_t done = 0;
+
+    if (!vm) return X86_ERR;
+    exec_ctx_t *e = &vm->ctx;
+    const uint64_t t0 = vm->stats.on ? stats_clock_ns() : 0;
+
+    if (vm->cpu.halted) {
+        st = X86_HALT;
+    } else if (vm->nbp == 0 && !trace_active(e)) {
+        while (done < budget) {
+            uint64_t left = budget - done;
+            uint32_t n = 0;
+            if (vm->prof.on && left > prof_slice(&vm->prof)) left = prof_slice(&vm->prof);
+            uint32_t slice = (left > UINT32_MAX) ? UINT32_MAX : (uint32_t)left;
+            st = vm->jit ? jit_run(vm->jit, e, &vm->bc, slice, &n)
+                         : bcache_run_block(e, &vm->bc, slice, &n);
+            done += n;
+            if (vm->prof.on) prof_tick(&vm->prof, n, vm->cpu.cs, vm->cpu.ip);
+            if (st != X86_OK) break;
+        }
+    } else {
+        bool skip = vm->bp_resume;
+        while (done < budget) {
+            if (!skip && at_breakpoint(vm)) { x.reason = VM_EXIT_BREAKPOINT; break; }
+            skip = false;
+            st = vm_step(vm);
+            done++;
+            if (vm->prof.on) prof_tick(&vm->prof, 1, vm->cpu.cs, vm->cpu.ip);
+            if (st != X86_OK) break;
+        }
+    }
 
-        log_printf(vm->log, LOG_TRACE, "dis",
-                   "%04X:%04X  %-47s  %s\n",
-                   c->cs, c->ip, bytes, d.text);
+    switch (st) {
+        case X86_OK:   if (x.reason != VM_EXIT_BREAKPOINT) x.reason = VM_EXIT_BUDGET; break;
+        case X86_HALT: x.reason = VM_EXIT_HALT; break;
+        case X86_IO:
+            x.reason   = VM_EXIT_IO;
+            x.port     = e->io.port;
+            x.io_size  = e->io.size;
+            x.io_in    = e->io.in;
+            x.io_value = e->io.value;
+            break;
+        default:       x.reason = VM_EXIT_FAULT; break;
     }
 
-    /* ---- EXECUTE ---- */
-	exec_ctx_t e = { .cpu = &vm->cpu, .vm = vm };
-	x86_status_t st = x86_step(&e);
+    if (done || x.reason == VM_EXIT_BREAKPOINT)
+        vm->bp_resume = (x.reason == VM_EXIT_BREAKPOINT);
 
-    /* ---- TRACE POST ---- */
-    if (vm->trace.enabled && vm->log) {
-        log_printf(vm->log, LOG_TRACE, "cpu",
-                   "AX=%04X BX=%04X CX=%04X DX=%04X "
-                   "CS:IP=%04X:%04X FLAGS=%04X\n",
-                   c->ax, c->bx, c->cx, c->dx,
-                   c->cs, c->ip, c->flags);
+    if (vm->stats.on) {
+        vm->stats.run_retired += done;
+        vm->stats.run_ns += stats_clock_ns() - t0;
     }
 
+    x.status  = st;
+    x.retired = done;
+    x.cs      = vm->cpu.cs;
+    x.ip      = vm->cpu.ip;
+    if (why) *why = x;
     return st;
 }
 
+bool vm_set_jit(VM *vm, bool on)
+{
+    if (!vm) return false;
+    if (!on) {
+        jit_destroy(vm->jit);
+        vm->jit = NULL;
+        return true;
+    }
+    if (!vm->jit) vm->jit = jit_create();
+    return vm->jit != NULL;
+}
+
+bool vm_break_add(VM *vm, uint32_t lin)
+{
+    if (!vm || vm->nbp >= VM_MAX_BREAKPOINTS) return false;
+    for (unsigned i = 0; i < vm->nbp; i++) {
+        if (vm->bp[i] == lin) return true;
+    }
+    vm->bp[vm->nbp++] = lin;
+    return true;
+}
+
+void vm_break_clear(VM *vm)
+{
+    if (vm) vm->nbp = 0;
+}
+
+/* ============================================================
+ * guest physical memory
+ *
+ * Fast path: one memmap lookup yielding a host pointer. Everything
+ * else (ROM writes, MMIO, code-page traps, unmapped) is in the
+ * *_slow helpers.
+ * ============================================================ */
+
+static bool vm_read8_slow(VM *vm, uint32_t a, uint8_t *out)
+{
+    const mm_page_t *p = mm_page(&vm->mm, a);
+    if (!p || p->kind != MM_MMIO) return false;
+    *out = mm_mmio_read(&vm->mm, p, a);
+    return true;
+}
+
+static void vm_unshare(VM *vm, uint32_t pg);
+static void vm_dirty_mark(VM *vm, uint32_t first, uint32_t last);
+
+static bool vm_write8_slow(VM *vm, uint32_t a, uint8_t v)
+{
+    const mm_page_t *p = mm_page(&vm->mm, a);
+    if (!p) return false;
+
+    if (p->flags & MM_PF_COW) vm_unshare(vm, a >> MM_PAGE_SHIFT);
+    if (p->flags & MM_PF_CLEAN) vm_dirty_mark(vm, a >> MM_PAGE_SHIFT, a >> MM_PAGE_SHIFT);
+
+    if (p->flags & MM_PF_CODE) {
+        const uint32_t pg = a >> MM_PAGE_SHIFT;
+        bcache_invalidate_page(&vm->bc, pg);
+        mm_clear_flags(&vm->mm, pg, MM_PF_CODE);
+    }
+
+    switch (p->kind) {
+        case MM_RAM:  p->host[a & MM_PAGE_MASK] = v; return true;
+        case MM_ROM:  return true;                  // writes to ROM are dropped
+        case MM_MMIO: mm_mmio_write(&vm->mm, p, a, v); return true;
+        default:      return false;
+    }
+}
+
 bool vm_read8(VM *vm, uint32_t a, uint8_t *out)
 {
     if (!vm || !out) return false;
-    if (a >= (uint32_t)vm->mem_size) return false;
-    *out = vm->mem[a];
-    return true;
+
+    const uint8_t *h = mm_rd_ptr(&vm->mm, a);
+    if (h) { *out = *h; return true; }
+    return vm_read8_slow(vm, a, out);
 }
 
 bool vm_read16(VM *vm, uint32_t a, uint16_t *out)
 {
     if (!vm || !out) return false;
-    if (a + 1u >= (uint32_t)vm->mem_size) return false;
-    *out = (uint16_t)(vm->mem[a] | (vm->mem[a + 1u] << 8));
+
+    if ((a & MM_PAGE_MASK) != MM_PAGE_MASK) {
+        const uint8_t *h = mm_rd_ptr(&vm->mm, a);
+        if (h) { *out = (uint16_t)(h[0] | (h[1] << 8)); return true; }
+    }
+
+    uint8_t lo, hi;
+    if (!vm_read8(vm, a, &lo) || !vm_read8(vm, a + 1u, &hi)) return false;
+    *out = (uint16_t)(lo | (hi << 8));
     return true;
 }
 
+/* Instruction fetch: copy up to n bytes, short at the first unreadable byte */
+size_t vm_fetch(VM *vm, uint32_t a, uint8_t *buf, size_t n)
+{
+    size_t got = 0;
+    if (!vm) return 0;
+
+    while (got < n) {
+        const uint8_t *h = mm_rd_ptr(&vm->mm, a);
+        if (!h) {
+            if (!vm_read8_slow(vm, a, buf + got)) break;
+            got++; a++;
+            continue;
+        }
+        size_t chunk = MM_PAGE_SIZE - (a & MM_PAGE_MASK);
+        if (chunk > n - got) chunk = n - got;
+        memcpy(buf + got, h, chunk);
+        got += chunk;
+        a += (uint32_t)chunk;
+    }
+    return got;
+}
+
+const uint8_t *vm_code_ptr(VM *vm, uint32_t a, uint32_t *left)
+{
+    const uint8_t *h = vm ? mm_rd_ptr(&vm->mm, a) : NULL;
+    if (!h) return NULL;
+
+    *left = MM_PAGE_SIZE - (a & MM_PAGE_MASK);
+    return h;
+}
+
 bool vm_write8(VM *vm, uint32_t a, uint8_t v)
 {
     if (!vm) return false;
-    if (a >= (uint32_t)vm->mem_size) return false;
-    vm->mem[a] = v;
-    return true;
+
+    uint8_t *h = mm_wr_ptr(&vm->mm, a);
+    if (h) { *h = v; return true; }
+    return vm_write8_slow(vm, a, v);
 }
 
 bool vm_write16(VM *vm, uint32_t a, uint16_t v)
 {
     if (!vm) return false;
-    if (a + 1u >= (uint32_t)vm->mem_size) return false;
-    vm->mem[a]     = (uint8_t)(v & 0xFF);
-    vm->mem[a + 1] = (uint8_t)((v >> 8) & 0xFF);
+
+    if ((a & MM_PAGE_MASK) != MM_PAGE_MASK) {
+        uint8_t *h = mm_wr_ptr(&vm->mm, a);
+        if (h) {
+            h[0] = (uint8_t)(v & 0xFF);
+            h[1] = (uint8_t)((v >> 8) & 0xFF);
+            return true;
+        }
+    }
+    return vm_write8(vm, a, (uint8_t)(v & 0xFF)) &&
+           vm_write8(vm, a + 1u, (uint8_t)((v >> 8) & 0xFF));
+}
+
+void vm_note_code(VM *vm, uint32_t lin, uint32_t lin_end)
+{
+    for (uint32_t pg = lin >> MM_PAGE_SHIFT; pg <= ((lin_end - 1u) >> MM_PAGE_SHIFT); pg++)
+        mm_set_flags(&vm->mm, pg, MM_PF_CODE);
+}
+
+void vm_code_flush(VM *vm)
+{
+    bcache_flush(&vm->bc);
+    mm_clear_flags_all(&vm->mm, MM_PF_CODE);
+    x86_fetch_reset(&vm->ctx);
+}
+
+/* ============================================================
+ * shared images
+ *
+ * ROM pages point straight into an image from the store; RAM pages
+ * loaded from one point into it with MM_PF_COW, so the first write
+ * copies the page into vm->mem as for clones. The VM holds a reference
+ * to every image any of its pages (or a clone's) may point into.
+ * ============================================================ */
+
+static bool vm_img_add(VM *vm, img_t *img)
+{
+    for (unsigned i = 0; i < vm->nimgs; i++)
+        if (vm->imgs[i] == img) return true;
+
+    img_t **n = (img_t**)realloc(vm->imgs, (vm->nimgs + 1u) * sizeof(*n));
+    if (!n) return false;
+
+    vm->imgs = n;
+    vm->imgs[vm->nimgs++] = img_ref(img);
+    return true;
+}
+
+static void vm_imgs_release(VM *v)
+{
+    for (unsigned i = 0; i < v->nimgs; i++) img_release(v->imgs[i]);
+    free(v->imgs);
+    v->imgs = NULL;
+    v->nimgs = 0;
+}
+
+bool vm_map_image(VM *vm, uint32_t base, img_t *img)
+{
+    if (!vm || !img || (base & MM_PAGE_MASK)) return false;
+
+    // kept inside RAM so save-states can hold the ROM contents
+    const size_t size = img_size(img);
+    if ((size_t)base + size > vm->mem_size) return false;
+
+    if (!vm_img_add(vm, img)) return false;
+    if (!mm_map_rom(&vm->mm, base, (uint32_t)size, (uint8_t*)(uintptr_t)img_data(img))) return false;
+
+    vm_dirty_mark(vm, base >> MM_PAGE_SHIFT, (uint32_t)((base + size - 1u) >> MM_PAGE_SHIFT));
+    vm_code_flush(vm);
+    return true;
+}
+
+bool vm_map_rom(VM *vm, uint32_t base, const uint8_t *data, size_t len)
+{
+    img_t *img = img_from(data, len);
+    const bool ok = vm_map_image(vm, base, img);
+    img_release(img);
+    return ok;
+}
+
+bool vm_load_image(VM *vm, uint32_t addr, img_t *img)
+{
+    if (!vm || !img) return false;
+
+    const size_t len = img_len(img);
+    if ((size_t)addr + len > vm->mem_size) return false;
+
+    // whole RAM pages point at the image, COW; a ragged head or tail is copied
+    size_t shared = (addr & MM_PAGE_MASK) ? 0 : len & ~(size_t)MM_PAGE_MASK;
+    const uint8_t *src = img_data(img);
+    if (shared && !vm_img_add(vm, img)) shared = 0;
+
+    size_t off = 0;
+    while (off < shared) {
+        const uint32_t pg = (uint32_t)((addr + off) >> MM_PAGE_SHIFT);
+        if (vm->mm.pg[pg].kind != MM_RAM) {
+            memcpy(vm_ram_range(vm, (uint32_t)(addr + off), MM_PAGE_SIZE), src + off, MM_PAGE_SIZE);
+            off += MM_PAGE_SIZE;
+            continue;
+        }
+
+        size_t end = off;
+        for (; end < shared && vm->mm.pg[(addr + end) >> MM_PAGE_SHIFT].kind == MM_RAM; end += MM_PAGE_SIZE) {
+            const uint32_t p = (uint32_t)((addr + end) >> MM_PAGE_SHIFT);
+            mm_set_host(&vm->mm, p, (uint8_t*)(uintptr_t)(src + end));
+            mm_set_flags(&vm->mm, p, MM_PF_COW);
+        }
+        vm_dirty_mark(vm, pg, (uint32_t)((addr + end - 1u) >> MM_PAGE_SHIFT));
+
+        // our own copies of those pages are dead now: give them back
+        if (vm->mem_file) hostmem_zero(vm->mem + addr + off, end - off);
+        else              hostmem_discard(vm->mem + addr + off, end - off);
+        off = end;
+    }
+
+    if (len > shared) {
+        uint8_t *dst = vm_ram_range(vm, (uint32_t)(addr + shared), len - shared);
+        if (!dst) return false;
+        memcpy(dst, src + shared, len - shared);
+    }
+
+    vm_code_flush(vm);
+    return true;
+}
+
+/* ============================================================
+ * RAM residency
+ * ============================================================ */
+
+size_t vm_ram_resident(const VM *vm)
+{
+    size_t n = hostmem_resident(vm->mem, vm->mem_size);
+
+    // a base whose other clones are gone is nobody's memory but ours
+    for (unsigned i = 0; i < vm->nbases; i++)
+        if (vm->bases[i]->refs == 1) n += hostmem_resident(vm->bases[i]->mem, vm->bases[i]->size);
+    return n;
+}
+
+size_t vm_ram_trim(VM *vm)
+{
+    // a discarded page of a snapshot mapping would read back the file
+    if (vm->mem_file) return 0;
+
+    // contents are unchanged (zero stays zero), so no cache to flush
+    return hostmem_trim(vm->mem, vm->mem_size);
+}
+
+void vm_reset(VM *vm, bool clear_ram)
+{
+    if (clear_ram) {
+        // give RAM pages back in runs; ROM images copied into mem stay
+        uint32_t pg = 0;
+        const uint32_t ram_pages = (uint32_t)(vm->mem_size >> MM_PAGE_SHIFT);
+
+        while (pg < ram_pages) {
+            if (vm->mm.pg[pg].kind != MM_RAM) { pg++; continue; }
+            uint32_t end = pg + 1;
+            while (end < ram_pages && vm->mm.pg[end].kind == MM_RAM) end++;
+
+            // pages still shared with a clone base go back to our own
+            for (uint32_t i = pg; i < end; i++) {
+                if (!(vm->mm.pg[i].flags & MM_PF_COW)) continue;
+                mm_clear_flags(&vm->mm, i, MM_PF_COW);
+                mm_set_host(&vm->mm, i, vm->mem + ((size_t)i << MM_PAGE_SHIFT));
+                vm->owned++;
+            }
+
+            vm_dirty_mark(vm, pg, end - 1u);
+
+            const size_t off = (size_t)pg << MM_PAGE_SHIFT;
+            const size_t len = (size_t)(end - pg) << MM_PAGE_SHIFT;
+            if (vm->mem_file) hostmem_zero(vm->mem + off, len);
+            else              hostmem_discard(vm->mem + off, len);
+            pg = end;
+        }
+        if (vm->vga) memset(vm->vga->vram, 0, sizeof(vm->vga->vram));
+    }
+
+    x86_init(&vm->cpu, vm->mem, vm->mem_size);
+    vm->cpu.cs = 0x0000;
+    vm->cpu.ip = 0x1000;
+    vm->bp_resume = false;
+    vm_code_flush(vm);
+}
+
+/* ============================================================
+ * dirty-page tracking
+ *
+ * A bitmap over RAM pages. Clean pages carry MM_PF_CLEAN, which keeps
+ * them off the direct-write tables, so the first write lands in
+ * vm_write8_slow() and marks the page; after that the flag is gone and
+ * the page is on the fast path again. String ops and the JIT go through
+ * the same tables, so nothing else needs a hook.
+ * ============================================================ */
+
+static uint32_t vm_ram_pages(const VM *vm)
+{
+    return (uint32_t)(vm->mem_size >> MM_PAGE_SHIFT);
+}
+
+static size_t vm_dirty_words(const VM *vm)
+{
+    return (vm_ram_pages(vm) + 63u) / 64u;
+}
+
+bool vm_dirty_start(VM *vm)
+{
+    if (!vm) return false;
+
+    const size_t words = vm_dirty_words(vm);
+    if (!vm->dirty) {
+        vm->dirty = (uint64_t*)calloc(words + 1u, sizeof(*vm->dirty));
+        if (!vm->dirty) return false;
+    } else {
+        memset(vm->dirty, 0, words * sizeof(*vm->dirty));
+    }
+
+    const uint32_t ram_pages = vm_ram_pages(vm);
+    for (uint32_t pg = 0; pg < ram_pages; pg++)
+        if (vm->mm.pg[pg].kind == MM_RAM) mm_set_flags(&vm->mm, pg, MM_PF_CLEAN);
     return true;
-}
\ No newline at end of file
+}
+
+static void vm_dirty_mark(VM *vm, uint32_t first, uint32_t last)
+{
+    if (!vm->dirty) return;
+
+    const uint32_t ram_pages = vm_ram_pages(vm);
+    for (uint32_t pg = first; pg <= last && pg < ram_pages; pg++) {
+        vm->dirty[pg / 64u] |= 1ull << (pg % 64u);
+        if (vm->mm.pg[pg].flags & MM_PF_CLEAN) mm_clear_flags(&vm->mm, pg, MM_PF_CLEAN);
+    }
+}
+
+bool vm_dirty_test(const VM *vm, uint32_t pg)
+{
+    return vm->dirty && pg < vm_ram_pages(vm) && (vm->dirty[pg / 64u] >> (pg % 64u)) & 1u;
+}
+
+size_t vm_dirty_count(const VM *vm)
+{
+    size_t n = 0;
+    for (size_t i = 0; vm->dirty && i < vm_dirty_words(vm); i++)
+        for (uint64_t w = vm->dirty[i]; w; w &= w - 1u) n++;
+    return n;
+}
+
+/* ============================================================
+ * copy-on-write clones
+ *
+ * Cloning freezes the source's RAM buffer into a refcounted base and
+ * gives both VMs a fresh demand-zero buffer. Their RAM pages keep
+ * pointing into the base with MM_PF_COW set, so the first write to a
+ * page (slow path) copies it into the writer's own buffer at the same
+ * offset; pages nobody writes are never copied. A base is freed when
+ * the last VM referencing it is destroyed. A source that has copied no
+ * page since its last freeze is all base already, so cloning it again
+ * just shares the same bases.
+ * ============================================================ */
+
+static bool vm_base_add(VM *vm, vm_ram_base_t *b)
+{
+    vm_ram_base_t **n = (vm_ram_base_t**)realloc(vm->bases, (vm->nbases + 1u) * sizeof(*n));
+    if (!n) return false;
+
+    vm->bases = n;
+    vm->bases[vm->nbases++] = b;
+    b->refs++;
+    return true;
+}
+
+static void vm_bases_release(VM *v)
+{
+    for (unsigned i = 0; i < v->nbases; i++) {
+        vm_ram_base_t *b = v->bases[i];
+        if (--b->refs) continue;
+        hostmem_free(b->mem, b->size);
+        free(b);
+    }
+    free(v->bases);
+    v->bases = NULL;
+    v->nbases = 0;
+}
+
+/* Give page pg a private copy in vm->mem (no-op if it already is) */
+static void vm_unshare(VM *vm, uint32_t pg)
+{
+    const mm_page_t *p = &vm->mm.pg[pg];
+    uint8_t *own = vm->mem + ((size_t)pg << MM_PAGE_SHIFT);
+
+    if ((p->kind != MM_RAM && p->kind != MM_ROM) || p->host == own) return;
+    if (((size_t)pg << MM_PAGE_SHIFT) >= vm->mem_size) return;
+
+    memcpy(own, p->host, MM_PAGE_SIZE);
+    mm_clear_flags(&vm->mm, pg, MM_PF_COW);
+    mm_set_host(&vm->mm, pg, own);
+    vm->owned++;
+    x86_fetch_reset(&vm->ctx);      // the fetch window may hold the shared copy
+}
+
+uint8_t *vm_ram_range(VM *vm, uint32_t addr, size_t len)
+{
+    if (!vm || len == 0 || (size_t)addr + len > vm->mem_size) return NULL;
+
+    const uint32_t last = (uint32_t)(((size_t)addr + len - 1u) >> MM_PAGE_SHIFT);
+    for (uint32_t pg = addr >> MM_PAGE_SHIFT; pg <= last; pg++)
+        vm_unshare(vm, pg);
+    vm_dirty_mark(vm, addr >> MM_PAGE_SHIFT, last);
+    return vm->mem + addr;
+}
+
+/* Turn vm's current buffer into a base and start a fresh one */
+static bool vm_freeze(VM *vm)
+{
+    // nothing of its own since the last freeze: its bases are all of it
+    if (vm->nbases && !vm->owned) return true;
+
+    vm_ram_base_t *b = (vm_ram_base_t*)calloc(1, sizeof(*b));
+    uint8_t *fresh = b ? hostmem_alloc(vm->mem_size) : NULL;
+
+    if (!fresh || !vm_base_add(vm, b)) {
+        hostmem_free(fresh, vm->mem_size);
+        free(b);
+        return false;
+    }
+    b->mem  = vm->mem;
+    b->size = vm->mem_size;
+    vm->mem = fresh;
+    vm->mem_file = false;
+    vm->owned = 0;
+    vm->cpu.mem = fresh;
+
+    // every RAM page now lives in some base: write-protect them all
+    const uint32_t ram_pages = (uint32_t)(vm->mem_size >> MM_PAGE_SHIFT);
+    for (uint32_t pg = 0; pg < ram_pages; pg++)
+        if (vm->mm.pg[pg].kind == MM_RAM) mm_set_flags(&vm->mm, pg, MM_PF_COW);
+
+    x86_fetch_reset(&vm->ctx);
+    return true;
+}
+
+int vm_clone(VMManager *m, int src_id, const char *name)
+{
+    VM *src = vm_get(m, src_id);
+    if (!src) return -1;
+
+    VM *v = claim_slot(m, name);
+    if (!v) return -1;
+    if (!vm_freeze(src)) {
+        release_slot(m, v);
+        return -1;
+    }
+
+    v->mem = hostmem_alloc(src->mem_size);
+    v->mem_size = src->mem_size;
+
+    bool ok = v->mem && mm_clone(&v->mm, &src->mm) && vga_clone(v, src) && bcache_init(&v->bc);
+    for (unsigned i = 0; ok && i < src->nbases; i++)
+        ok = vm_base_add(v, src->bases[i]);
+    for (unsigned i = 0; ok && i < src->nimgs; i++)
+        ok = vm_img_add(v, src->imgs[i]);
+    if (!ok) {
+        vm_release(v);
+        release_slot(m, v);
+        return -1;
+    }
+
+    const uint32_t ram_pages = (uint32_t)(v->mem_size >> MM_PAGE_SHIFT);
+    for (uint32_t pg = 0; pg < ram_pages; pg++)
+        if (v->mm.pg[pg].kind == MM_RAM) mm_set_flags(&v->mm, pg, MM_PF_COW);
+
+    // same RAM, so the same changes relative to src's last snapshot
+    if (src->dirty && vm_dirty_start(v)) {
+        memcpy(v->dirty, src->dirty, vm_dirty_words(v) * sizeof(*v->dirty));
+        for (uint32_t pg = 0; pg < ram_pages; pg++)
+            if (vm_dirty_test(v, pg)) mm_clear_flags(&v->mm, pg, MM_PF_CLEAN);
+        v->snap_id = src->snap_id;
+        memcpy(v->snap_path, src->snap_path, sizeof(v->snap_path));
+    }
+
+    v->cpu = src->cpu;
+    v->cpu.mem = v->mem;
+    v->cpu_inited = true;
+    v->ctx = (exec_ctx_t){ .cpu = &v->cpu, .vm = v };
+
+    v->trace    = src->trace;
+    v->log      = src->log;
+    v->stats.on = src->stats.on;
+    memcpy(v->bp, src->bp, sizeof(v->bp));
+    v->nbp = src->nbp;
+    v->bp_resume = src->bp_resume;
+    if (src->jit) vm_set_jit(v, true);
+
+    m->current = v->id;
+    return v->id;
+}
@@ -20,21 +20,93 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 #include "cpu/x86_cpu.h"   // x86_cpu_t, x86_status_t
+#include "cpu/bcache.h"    // bcache_t
+#include "vm/memmap.h"     // memmap_t
+#include "vm/stats.h"      // vm_stats_t
+#include "vm/profile.h"    // vm_prof_t
+#include "cpu/exec_ctx.h"  // exec_ctx_t
+#include "vm/imgstore.h"   // img_t
 
-#ifndef VM_MAX
-#define VM_MAX 8
+/* VM ids are handles: generation << VM_ID_INDEX_BITS | slot index.
+   A destroyed VM's id never names a later VM in the same slot. */
+#define VM_ID_INDEX_BITS 20
+#define VM_ID_INDEX_MASK ((1u << VM_ID_INDEX_BITS) - 1u)
+#define VM_ID_GEN_MAX    ((1u << (31 - VM_ID_INDEX_BITS)) - 1u)   // keeps ids positive
+
+#ifndef VM_SLAB
+#define VM_SLAB 64          // VM objects per slab allocation
+#endif
+
+#ifndef VM_MAX_BREAKPOINTS
+#define VM_MAX_BREAKPOINTS 16
 #endif
 
+#define VM_PAGE_SIZE MM_PAGE_SIZE   // fetch window / code-page granularity
+#define VM_PHYS_MIN  0x110000u      // map at least 1 MiB + HMA
+
 /* forward declare logger type from util/log.h */
 typedef struct logger logger_t;
 
+/* forward declare the translator from jit/jit.h */
+typedef struct jit jit_t;
+
+/* forward declare the text window from vm/vga.h */
+typedef struct vga_text vga_text_t;
+
+/* Trace tiers for trace_t.flags; each tier includes the ones below it */
+enum {
+    TRACE_OFF    = 0,   /* nothing: fast path, no hooks run */
+    TRACE_BRANCH = 1,   /* control transfers only: from -> to */
+    TRACE_INSN   = 2,   /* one line per instruction: CS:IP, bytes, disasm */
+    TRACE_STATE  = 3    /* full register state before and after */
+};
+
 typedef struct trace_cfg {
-    bool enabled;      /* runtime enable */
-    unsigned flags;    /* future: TRACE_* bitflags */
+    unsigned flags;    /* TRACE_* tier */
+    FILE    *fp;       /* sink; NULL => stderr */
 } trace_t;
 
+/* Why vm_run() returned */
+typedef enum vm_exit_reason {
+    VM_EXIT_BUDGET = 0,   /* instruction budget used up */
+    VM_EXIT_HALT,         /* HLT */
+    VM_EXIT_FAULT,        /* X86_ERR / X86_ILLEGAL / X86_FAULT (see status) */
+    VM_EXIT_BREAKPOINT,   /* CS:IP reached a breakpoint (not yet executed) */
+    VM_EXIT_IO            /* IN/OUT needs servicing (see io) */
+} vm_exit_reason_t;
+
+typedef struct vm_exit {
+    vm_exit_reason_t reason;
+    x86_status_t     status;    /* last CPU status */
+    uint64_t         retired;   /* instructions executed by this call */
+    uint16_t         cs, ip;    /* where execution stopped */
+
+    /* VM_EXIT_IO only */
+    uint16_t port;
+    uint8_t  io_size;
+    bool     io_in;
+    uint16_t io_value;
+} vm_exit_t;
+
+/* per-VM state owned by the background scheduler (vm/sched.c, under its lock) */
+typedef struct vm_sched_slot {
+    int        state;       /* vm_sched_state_t */
+    bool       pause_req;   /* park at the next slice boundary */
+    vm_exit_t  last;        /* exit that parked it */
+    uint64_t   retired, slices;
+    struct VM *next, *prev; /* run queue links */
+} vm_sched_slot_t;
+
+/* a frozen RAM image shared copy-on-write by clones (see vm_clone) */
+typedef struct vm_ram_base {
+    uint8_t *mem;
+    size_t   size;
+    unsigned refs;          /* VMs referencing it */
+} vm_ram_base_t;
+
 typedef struct VM {
     int id;
     bool in_use;
@@ -44,31 +116,171 @@ typedef struct VM {
     trace_t   trace;
     logger_t *log;
 
-    /* RAM backing */
+    /* RAM backing: pages this VM owns (COW pages point into bases) */
     uint8_t *mem;
     size_t   mem_size;
+    vm_ram_base_t **bases;
+    unsigned        nbases;
+    unsigned        owned;    /* pages copied into mem since the last freeze */
+    img_t         **imgs;     /* shared images some pages point into */
+    unsigned        nimgs;
+    bool     mem_file;      /* mem is a private mapping of a snapshot file */
+
+    /* RAM pages written since the last snapshot (NULL: not tracking) */
+    uint64_t *dirty;
+    uint64_t  snap_id;      /* that snapshot's id, 0 if none */
+    char      snap_path[260];
+
+    /* physical memory map (RAM/ROM/MMIO pages over mem) */
+    memmap_t mm;
+
+    /* VGA text window at 0xB8000 (NULL: that range is plain RAM) */
+    vga_text_t *vga;
 
     /* CPU state */
     x86_cpu_t cpu;
     bool cpu_inited;
+
+    /* decoded basic-block cache */
+    bcache_t bc;
+
+    /* optional block translator on top of bc (NULL: interpret only) */
+    jit_t *jit;
+
+    /* execution counters (stats.on gates all counting) */
+    vm_stats_t stats;
+
+    /* sampling profiler (prof.on gates the slice clamp in vm_run) */
+    vm_prof_t prof;
+
+    /* persistent execution context (cpu/vm wired once at create) */
+    exec_ctx_t ctx;
+
+    /* breakpoints: linear addresses */
+    uint32_t bp[VM_MAX_BREAKPOINTS];
+    unsigned nbp;
+    bool     bp_resume;   /* last exit was a breakpoint: step over it once */
+
+    /* background scheduler bookkeeping */
+    vm_sched_slot_t sched;
 } VM;
 
+/* one handle-table entry per VM object ever allocated */
+typedef struct vm_slot {
+    VM      *vm;            /* in its slab: never moves, never freed before vmman_free */
+    uint32_t gen;           /* generation of the id it currently answers to */
+    int32_t  next_free;     /* free list link, -1 = end */
+    int32_t  next_name;     /* name hash chain link, -1 = end */
+    bool     used;          /* object has held a VM (needs clearing on reuse) */
+} vm_slot_t;
+
+/*
+ * VM registry. VM objects come from slabs of VM_SLAB and are recycled
+ * through a free list; ids resolve in O(1) through the slot table and
+ * go stale (vm_get() returns NULL) once their VM is destroyed. Names
+ * are hashed for vm_find(). Not thread-safe: one thread owns the
+ * manager (the scheduler's workers only touch VMs they are running).
+ */
 typedef struct VMManager {
-    VM vms[VM_MAX];
+    VM       **slabs;
+    unsigned   nslabs;
+    vm_slot_t *slots;       /* nslabs * VM_SLAB entries */
+    uint32_t   nslots;
+    int32_t    free_head;   /* lowest-index free slot first, -1 = none */
+    unsigned   count;       /* live VMs */
+
+    int32_t   *names;       /* name hash buckets: slot index, -1 = empty */
+    uint32_t   nbuckets;    /* power of two */
+
     int current; // -1 if none
 } VMManager;
 
 void  vmman_init(VMManager *m);
+/* destroy every VM and free the registry itself */
+void  vmman_free(VMManager *m);
+/* ram_bytes is rounded up to a whole 4 KiB page */
 int   vm_create_default(VMManager *m, size_t ram_bytes, const char *name);
+/* Same, over a caller-provided hostmem buffer the VM takes ownership of
+   (freed on failure too); mem_file marks a snapshot file mapping.
+   ram_bytes must be a nonzero multiple of the page size */
+int   vm_create_on(VMManager *m, uint8_t *mem, size_t ram_bytes, const char *name, bool mem_file);
 bool  vm_destroy(VMManager *m, int id);
+
+/* New VM with src's CPU state whose RAM shares pages copy-on-write with
+   src (neither sees the other's later writes). O(pages) flag updates,
+   no RAM copy. Returns the new id (made current) or -1. */
+int   vm_clone(VMManager *m, int src_id, const char *name);
 bool  vm_use(VMManager *m, int id);
 VM   *vm_get(VMManager *m, int id);
 VM   *vm_current(VMManager *m);
+/* most recently created live VM with this name, or NULL */
+VM   *vm_find(VMManager *m, const char *name);
+/* live VMs in slot order: vm_next(m, NULL) is the first */
+VM   *vm_next(VMManager *m, const VM *prev);
+unsigned vm_count(const VMManager *m);
 void  vm_list(VMManager *m);
 bool  vm_read8 (VM *vm, uint32_t addr, uint8_t *out);
 bool  vm_read16(VM *vm, uint32_t addr, uint16_t *out);
 bool  vm_write8 (VM *vm, uint32_t addr, uint8_t val);
+size_t vm_fetch(VM *vm, uint32_t addr, uint8_t *buf, size_t n);  /* bytes copied */
+/* Host pointer to guest code at addr and the readable bytes to the end
+ * of its page, or NULL if addr is not plain RAM (instruction fetch window) */
+const uint8_t *vm_code_ptr(VM *vm, uint32_t addr, uint32_t *left);
 bool  vm_write16(VM *vm, uint32_t addr, uint16_t val);
 
+/* Host pointer for writing [addr, addr+len) of RAM directly (loaders);
+   shared COW pages in the range are copied first. NULL if out of range. */
+uint8_t *vm_ram_range(VM *vm, uint32_t addr, size_t len);
+
+/* Map a shared image read-only at base (page aligned, inside RAM): the
+   pages point at the image itself, which the VM keeps a reference to */
+bool  vm_map_image(VM *vm, uint32_t base, img_t *img);
+
+/* Same for bytes in memory, through the image store (the tail of the
+   last page reads as zero) */
+bool  vm_map_rom(VM *vm, uint32_t base, const uint8_t *data, size_t len);
+
+/* Load an image into RAM at addr: whole pages share the image copy-on-
+   write when addr is page aligned, the rest is copied. Flushes code. */
+bool  vm_load_image(VM *vm, uint32_t addr, img_t *img);
+
+/* Blocks were decoded from [lin, lin_end): trap writes to those pages */
+void  vm_note_code(VM *vm, uint32_t lin, uint32_t lin_end);
+
+/* Guest RAM changed behind the VM's back (e.g. a file load): drop the
+   block cache, code-page traps and the fetch window */
+void  vm_code_flush(VM *vm);
+
+/* Host bytes of guest RAM actually resident (RAM is demand-zero),
+   counting clone bases no other VM shares any more */
+size_t vm_ram_resident(const VM *vm);
+
+/* Return resident all-zero RAM pages to the host; bytes released
+   (none for a snapshot-mapped VM) */
+size_t vm_ram_trim(VM *vm);
+
+/* Dirty-page tracking. Start (or restart) clears the set and flags
+   every RAM page MM_PF_CLEAN, so only the first write to a page after
+   that takes the slow path to mark it. Loaders (vm_ram_range) and
+   vm_reset(clear) mark what they change. */
+bool   vm_dirty_start(VM *vm);
+bool   vm_dirty_test(const VM *vm, uint32_t page);
+size_t vm_dirty_count(const VM *vm);     /* pages */
+
+/* CPU reset to the create-time state, caches dropped. RAM is kept like
+   a hardware reset unless clear_ram, which releases every RAM page
+   (ROM images stay) so it reads as zero and costs nothing until used */
+void  vm_reset(VM *vm, bool clear_ram);
+
 /* Execute one instruction on the given VM */
 x86_status_t vm_step(VM *vm);
+
+/* Run up to 'budget' instructions. Returns the final CPU status and
+   fills *why (may be NULL) with the structured exit reason. */
+x86_status_t vm_run(VM *vm, uint64_t budget, vm_exit_t *why);
+
+/* Turn the JIT tier on/off (false if the host has no backend) */
+bool  vm_set_jit(VM *vm, bool on);
+
+bool  vm_break_add(VM *vm, uint32_t lin);
+void  vm_break_clear(VM *vm);
@@ -0,0 +1,47 @@
+bits 16
+org 0x1000
+
+; Self-modifying code under the JIT. Blocks A (loop_a, end of one page)
+; and B (block_b, alone on the next page) loop until both are translated
+; and A's exit jumps straight into B. Then a block at evict, which maps
+; to B's block-cache slot, pushes B out, and B's MOV immediate is
+; patched (1111 -> 3333). The second pass must run the new bytes.
+
+main:
+    mov di, 0
+    mov dx, 0
+    mov cx, 20
+    jmp loop_a
+
+after_loop:
+    cmp di, 0
+    jnz done
+    mov di, 1
+    jmp evict
+
+patch:
+    add word [block_b + 1], 0x2222  ; B now loads 3333
+    mov cx, 2
+    jmp loop_a
+
+done:
+    hlt
+
+    times 0x2FF0 - 0x1000 - ($ - $$) db 0x90
+
+loop_a:                         ; 0x2FF0
+    sub cx, 1
+    jnz block_b
+    jmp after_loop
+
+    times 0x3000 - 0x1000 - ($ - $$) db 0x90
+
+block_b:                        ; 0x3000, the only code on its page
+    mov ax, 0x1111
+    add dx, 1
+    jnz loop_a
+
+    times 0x4038 - 0x1000 - ($ - $$) db 0x90
+
+evict:                          ; same bcache slot as 0x3000, other page
+    jmp patch
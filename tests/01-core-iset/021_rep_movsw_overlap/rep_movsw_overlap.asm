@@ -0,0 +1,31 @@
+bits 16
+org 0x1000
+
+; REP MOVSW with DI = SI + 1: each word is read whole before it is
+; written, so the copy smears in element order (not byte order).
+; The data sits on its own page, away from the code, so the copies
+; take the direct host-pointer path.
+
+    cld
+    mov si, up
+    mov di, up + 1
+    mov cx, 3
+    rep movsw               ; up: 11 11 22 22 44 44 66 88
+
+    std
+    mov si, down + 4
+    mov di, down + 5
+    mov cx, 3
+    rep movsw               ; down: 11 11 22 33 44 55 66 88
+    cld
+    hlt
+
+    times 0x2000 - 0x1000 - ($ - $$) db 0
+
+up:
+    db 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88
+
+    times 0x2100 - 0x1000 - ($ - $$) db 0
+
+down:
+    db 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88
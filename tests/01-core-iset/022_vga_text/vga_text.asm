@@ -0,0 +1,28 @@
+; vga_text.asm
+bits 16
+org 0x1000
+
+; Text-mode stores through the VGA window: es = ds = B800 come from the
+; manifest, which attaches the window as MMIO. Every element of the
+; REP STOSW goes through the device callbacks, and LODSW reads two
+; cells back through them.
+
+    cld
+    mov di, 0
+    mov ax, 0x1F48          ; 'H', white on blue
+    stosw
+    mov ax, 0x1F49          ; 'I'
+    stosw
+
+    mov di, 160             ; row 1
+    mov ax, 0x072D          ; '-', grey on black
+    mov cx, 80
+    rep stosw
+
+    mov si, 0
+    lodsw                   ; 'H' back
+    push ax
+    pop bx
+    mov si, 318             ; last cell of row 1
+    lodsw
+    hlt
@@ -0,0 +1,18 @@
+; fused_push_fault.asm
+bits 16
+org 0x1000
+
+; A fused PUSH run whose second member faults (ss = FFFF from the
+; manifest). The first push lands on the last RAM page; the second
+; wraps SP and writes FFFF:FFFE = 10FFEE, which is unmapped. The group
+; has to stop there as single steps would: IP just past PUSH BX, the
+; third push not run, and only four MOVs and two pushes retired.
+
+    mov ax, 0x1111
+    mov bx, 0x2222
+    mov cx, 0x3333
+    mov sp, 0x0002          ; FFFF:0002 = FFFF2
+    push ax                 ; -> FFFF0
+    push bx                 ; faults
+    push cx
+    hlt
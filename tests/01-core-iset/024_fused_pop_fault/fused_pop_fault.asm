@@ -0,0 +1,17 @@
+; fused_pop_fault.asm
+bits 16
+org 0x1000
+
+; A fused POP run whose second member faults (ss = FFFF from the
+; manifest). The first pop reads the last RAM word, FFFFE; the second
+; reads FFFF:0010 = 100000, past the end of RAM. The group has to stop
+; there: IP just past POP BX, BX and CX untouched, SP moved once.
+
+    mov ax, 0x1111
+    mov bx, 0x2222
+    mov cx, 0x3333
+    mov sp, 0x000E          ; FFFF:000E = FFFFE
+    pop ax                  ; 0000
+    pop bx                  ; faults
+    pop cx
+    hlt
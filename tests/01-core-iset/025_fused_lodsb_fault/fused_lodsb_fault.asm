@@ -0,0 +1,17 @@
+; fused_lodsb_fault.asm
+bits 16
+org 0x1000
+
+; LODSB ; TEST AL,AL ; JZ runs as one fused group. With ds = FFFF from
+; the manifest, SI = 0010 is 100000, past the end of RAM, so the LODSB
+; faults: the fault is the LODSB's alone, with IP just past it and
+; TEST and JZ neither run nor counted.
+
+    mov ax, 0x4141
+    mov si, 0x0010
+    lodsb                   ; faults
+    test al, al
+    jz done
+    nop
+done:
+    hlt
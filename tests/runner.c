@@ -0,0 +1,677 @@
+// tests/runner.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * In-process test runner for the guest-code suites.
+ *
+ *   x64-test [-j N] [--junit out.xml] [--json out.json] [dir]
+ *
+ * Every subdirectory of `dir` (tests/01-core-iset by default) that has
+ * a test.cfg manifest is one test. The manifest uses the vm.cfg layout:
+ *
+ *   bin        = call_ret.bin
+ *   load-addr  = 0x1000
+ *   cs         = 0x0000
+ *   ip         = 0x1000
+ *   es         = 0xB800
+ *   ss         = 0xFFFF
+ *   max-steps  = 64
+ *   jit        = on
+ *   vga        = on
+ *   expect ax  = 0x3333
+ *   expect mem 0x1FFE = EF BE
+ *   expect com1 = HELLO\r\n
+ *   xfail      = MOV r/m forms not implemented yet
+ *
+ * `expect` takes a register (ax..di, cs, ds, es, ss, ip, flags), halt,
+ * err, retired (instructions executed, a faulting one included), mem
+ * <addr> followed by bytes, or com1 (text the guest wrote to
+ * COM1 must contain; \r \n \t \\ and \xNN escapes). An xfail test is
+ * expected to fail and only counts against the run if it passes. With
+ * jit = on the test runs on the JIT tier where the host has one (the
+ * interpreter otherwise, with the same expectations). With vga = on the
+ * text window at 0xB8000 is MMIO (vm/vga.h); `expect mem` reads it
+ * through the same callbacks the guest does.
+ *
+ * Tests run in worker threads, one private VMManager per worker, and
+ * report in directory order; exit status is 1 if anything failed.
+ */
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE     // dirent d_type, sysconf() under -std=c11
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "vm/vm.h"
+#include "vm/stats.h"       // stats_clock_ns()
+#include "vm/vga.h"
+
+#define RUN_DEFAULT_DIR "tests/01-core-iset"
+#define RUN_MANIFEST    "test.cfg"
+#define RUN_MAX_TESTS   1024
+#define RUN_MAX_EXPECT  32
+#define RUN_MAX_WORKERS 64
+#define RUN_RAM         (1u << 20)
+#define RUN_COM1_MAX    1024
+#define RUN_MEM_MAX     16
+
+typedef enum expect_kind {
+    EXP_REG,
+    EXP_HALT,
+    EXP_ERR,
+    EXP_RETIRED,
+    EXP_MEM,
+    EXP_COM1
+} expect_kind_t;
+
+typedef struct expect {
+    expect_kind_t kind;
+    char     what[8];               // register name (EXP_REG)
+    uint32_t addr;                  // EXP_MEM
+    uint32_t value;                 // EXP_REG / HALT / ERR / RETIRED
+    uint8_t  bytes[RUN_COM1_MAX];   // EXP_MEM bytes or EXP_COM1 text
+    unsigned len;
+} expect_t;
+
+typedef struct test {
+    char     name[64];
+    char     dir[512];
+    char     bin[512];
+    uint32_t load_addr;
+    uint16_t cs, ip, ds, es, ss;
+    uint64_t max_steps;
+    bool     jit;
+    bool     vga;
+
+    expect_t exp[RUN_MAX_EXPECT];
+    unsigned nexp;
+    char     xfail[128];            // reason, empty if the test should pass
+
+    // result
+    bool     error;                 // bad manifest, image or VM setup
+    bool     pass;                  // all expectations held
+    char     msg[256];
+    uint64_t retired;
+    uint64_t ns;
+} test_t;
+
+typedef struct pool {
+    test_t     **tests;
+    unsigned     ntests;
+    atomic_uint  next;
+} pool_t;
+
+/* ============================================================
+ * manifest
+ * ============================================================ */
+
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = 0;
+    return s;
+}
+
+static bool parse_u32(const char *s, uint32_t max, uint32_t *out)
+{
+    char *end = NULL;
+    unsigned long v = strtoul(s, &end, 0);
+    if (end == s || *trim(end) || v > max) return false;
+    *out = (uint32_t)v;
+    return true;
+}
+
+// "HELLO\r\n" -> bytes
+static bool parse_text(const char *s, expect_t *x)
+{
+    x->len = 0;
+    while (*s) {
+        if (x->len >= RUN_COM1_MAX) return false;
+        int ch = (unsigned char)*s++;
+        if (ch == '\\') {
+            switch (*s++) {
+                case 'r':  ch = '\r'; break;
+                case 'n':  ch = '\n'; break;
+                case 't':  ch = '\t'; break;
+                case '\\': ch = '\\'; break;
+                case 'x': {
+                    char hex[3] = { s[0], s[0] ? s[1] : 0, 0 };
+                    char *end = NULL;
+                    ch = (int)strtoul(hex, &end, 16);
+                    if (end != hex + 2) return false;
+                    s += 2;
+                    break;
+                }
+                default: return false;
+            }
+        }
+        x->bytes[x->len++] = (uint8_t)ch;
+    }
+    return x->len > 0;
+}
+
+// "EF BE" -> bytes
+static bool parse_bytes(char *s, expect_t *x)
+{
+    x->len = 0;
+    for (char *tok = strtok(s, " \t"); tok; tok = strtok(NULL, " \t")) {
+        char *end = NULL;
+        unsigned long v = strtoul(tok, &end, 16);
+        if (*end || v > 0xFFu || x->len >= RUN_MEM_MAX) return false;
+        x->bytes[x->len++] = (uint8_t)v;
+    }
+    return x->len > 0;
+}
+
+static bool parse_expect(test_t *t, char *key, char *val)
+{
+    if (t->nexp >= RUN_MAX_EXPECT) return false;
+    expect_t *x = &t->exp[t->nexp];
+    memset(x, 0, sizeof(*x));
+
+    char *what = trim(key);
+    char *arg = what + strcspn(what, " \t");
+    if (*arg) *arg++ = 0;
+    arg = trim(arg);
+
+    bool ok;
+    if (!strcmp(what, "mem")) {
+        x->kind = EXP_MEM;
+        ok = parse_u32(arg, 0xFFFFFu, &x->addr) && parse_bytes(val, x);
+    } else if (!strcmp(what, "com1")) {
+        x->kind = EXP_COM1;
+        ok = !*arg && parse_text(val, x);
+    } else if (!strcmp(what, "retired")) {
+        x->kind = EXP_RETIRED;
+        ok = !*arg && parse_u32(val, UINT32_MAX, &x->value);
+    } else if (!strcmp(what, "halt") || !strcmp(what, "err")) {
+        x->kind = what[0] == 'h' ? EXP_HALT : EXP_ERR;
+        ok = !*arg && parse_u32(val, 1, &x->value);
+    } else {
+        x->kind = EXP_REG;
+        ok = !*arg && strlen(what) < sizeof(x->what) && parse_u32(val, 0xFFFFu, &x->value);
+        if (ok) strcpy(x->what, what);
+    }
+    if (ok) t->nexp++;
+    return ok;
+}
+
+static bool load_manifest(test_t *t, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        snprintf(t->msg, sizeof(t->msg), "cannot open " RUN_MANIFEST);
+        return false;
+    }
+
+    t->load_addr = 0x1000u;
+    t->ip        = 0x1000u;
+    t->max_steps = 100000u;
+
+    char line[1024];
+    unsigned ln = 0;
+    bool ok = true;
+    uint32_t v = 0;
+
+    while (ok && fgets(line, sizeof(line), f)) {
+        ln++;
+        char *p = trim(line);
+        if (!*p || *p == '#') continue;
+
+        char *eq = strchr(p, '=');
+        if (!eq) { ok = false; break; }
+        *eq = 0;
+        char *key = trim(p), *val = trim(eq + 1);
+
+        if (!strncmp(key, "expect", 6) && isspace((unsigned char)key[6])) ok = parse_expect(t, key + 7, val);
+        else if (!strcmp(key, "bin"))       ok = (size_t)snprintf(t->bin, sizeof(t->bin), "%s/%s", t->dir, val) < sizeof(t->bin);
+        else if (!strcmp(key, "load-addr")) { ok = parse_u32(val, 0xFFFFFu, &v); t->load_addr = v; }
+        else if (!strcmp(key, "cs"))        { ok = parse_u32(val, 0xFFFFu, &v);  t->cs = (uint16_t)v; }
+        else if (!strcmp(key, "ip"))        { ok = parse_u32(val, 0xFFFFu, &v);  t->ip = (uint16_t)v; }
+        else if (!strcmp(key, "ds"))        { ok = parse_u32(val, 0xFFFFu, &v);  t->ds = (uint16_t)v; }
+        else if (!strcmp(key, "es"))        { ok = parse_u32(val, 0xFFFFu, &v);  t->es = (uint16_t)v; }
+        else if (!strcmp(key, "ss"))        { ok = parse_u32(val, 0xFFFFu, &v);  t->ss = (uint16_t)v; }
+        else if (!strcmp(key, "max-steps")) { ok = parse_u32(val, UINT32_MAX, &v); t->max_steps = v; }
+        else if (!strcmp(key, "jit"))       { ok = !strcmp(val, "on") || !strcmp(val, "off"); t->jit = !strcmp(val, "on"); }
+        else if (!strcmp(key, "vga"))       { ok = !strcmp(val, "on") || !strcmp(val, "off"); t->vga = !strcmp(val, "on"); }
+        else if (!strcmp(key, "xfail"))     ok = (size_t)snprintf(t->xfail, sizeof(t->xfail), "%s", val) < sizeof(t->xfail) && *val;
+        else ok = false;
+    }
+    fclose(f);
+
+    if (!ok) snprintf(t->msg, sizeof(t->msg), RUN_MANIFEST ":%u: bad line", ln);
+    else if (!t->bin[0]) { snprintf(t->msg, sizeof(t->msg), RUN_MANIFEST ": no bin"); ok = false; }
+    return ok;
+}
+
+/* ============================================================
+ * execution
+ * ============================================================ */
+
+static bool load_bin(VM *vm, const char *path, uint32_t addr)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    size_t room = addr < vm->mem_size ? vm->mem_size - addr : 0;
+    size_t n = room ? fread(vm->mem + addr, 1, room, f) : 0;
+    bool ok = n > 0 && fgetc(f) == EOF;
+    fclose(f);
+    return ok;
+}
+
+static bool reg_value(const x86_cpu_t *c, const char *r, uint32_t *out)
+{
+    static const struct { const char *name; size_t off; } regs[] = {
+        { "ax", offsetof(x86_cpu_t, ax) }, { "bx", offsetof(x86_cpu_t, bx) },
+        { "cx", offsetof(x86_cpu_t, cx) }, { "dx", offsetof(x86_cpu_t, dx) },
+        { "si", offsetof(x86_cpu_t, si) }, { "di", offsetof(x86_cpu_t, di) },
+        { "bp", offsetof(x86_cpu_t, bp) }, { "sp", offsetof(x86_cpu_t, sp) },
+        { "cs", offsetof(x86_cpu_t, cs) }, { "ds", offsetof(x86_cpu_t, ds) },
+        { "es", offsetof(x86_cpu_t, es) }, { "ss", offsetof(x86_cpu_t, ss) },
+        { "ip", offsetof(x86_cpu_t, ip) },
+    };
+
+    if (!strcmp(r, "flags")) { *out = x86_flags(c); return true; }
+    for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) {
+        if (strcmp(r, regs[i].name)) continue;
+        *out = *(const uint16_t*)((const uint8_t*)c + regs[i].off);
+        return true;
+    }
+    return false;
+}
+
+static bool has_text(const uint8_t *hay, unsigned n, const uint8_t *needle, unsigned len)
+{
+    for (unsigned i = 0; i + len <= n; i++)
+        if (!memcmp(hay + i, needle, len)) return true;
+    return false;
+}
+
+// first failing expectation, or NULL
+static const char *check(test_t *t, VM *vm, bool err, const uint8_t *com1, unsigned ncom1)
+{
+    for (unsigned i = 0; i < t->nexp; i++) {
+        const expect_t *x = &t->exp[i];
+        uint32_t got = 0;
+
+        switch (x->kind) {
+            case EXP_REG:
+                if (!reg_value(&vm->cpu, x->what, &got)) {
+                    snprintf(t->msg, sizeof(t->msg), "unknown register %s", x->what);
+                    return t->msg;
+                }
+                break;
+            case EXP_HALT: got = vm->cpu.halted ? 1u : 0u; break;
+            case EXP_ERR:  got = err ? 1u : 0u; break;
+            case EXP_RETIRED: got = (uint32_t)t->retired; break;
+
+            case EXP_MEM:
+                for (unsigned b = 0; b < x->len; b++) {
+                    uint8_t v = 0;
+                    if (!vm_read8(vm, x->addr + b, &v) || v != x->bytes[b]) {
+                        snprintf(t->msg, sizeof(t->msg), "mem %05X: expected %02X, got %02X",
+                                 (unsigned)(x->addr + b), x->bytes[b], v);
+                        return t->msg;
+                    }
+                }
+                continue;
+
+            case EXP_COM1:
+                if (has_text(com1, ncom1, x->bytes, x->len)) continue;
+                snprintf(t->msg, sizeof(t->msg), "com1: expected text not found (%u bytes written)", ncom1);
+                return t->msg;
+        }
+
+        if (got != x->value) {
+            const char *what = x->kind == EXP_REG ? x->what : x->kind == EXP_HALT ? "halt" :
+                               x->kind == EXP_ERR ? "err" : "retired";
+            snprintf(t->msg, sizeof(t->msg), "%s: expected %04X, got %04X", what, (unsigned)x->value, (unsigned)got);
+            return t->msg;
+        }
+    }
+    return NULL;
+}
+
+static void run_test(VMManager *vms, test_t *t)
+{
+    if (t->error) return;       // manifest problem, already reported
+
+    int id = vm_create_default(vms, RUN_RAM, t->name);
+    if (id < 0) {
+        snprintf(t->msg, sizeof(t->msg), "cannot create VM");
+        t->error = true;
+        return;
+    }
+    VM *vm = vm_get(vms, id);
+
+    if (!load_bin(vm, t->bin, t->load_addr)) {
+        snprintf(t->msg, sizeof(t->msg), "cannot load %.200s at %05X", t->bin, (unsigned)t->load_addr);
+        t->error = true;
+        vm_destroy(vms, id);
+        return;
+    }
+    vm_code_flush(vm);
+    if (t->jit) vm_set_jit(vm, true);
+    if (t->vga && !vga_attach(vm)) {
+        snprintf(t->msg, sizeof(t->msg), "cannot attach the VGA window");
+        t->error = true;
+        vm_destroy(vms, id);
+        return;
+    }
+    vm->cpu.cs = t->cs;
+    vm->cpu.ip = t->ip;
+    vm->cpu.ds = t->ds;
+    vm->cpu.es = t->es;
+    vm->cpu.ss = t->ss;
+
+    uint8_t  com1[RUN_COM1_MAX];
+    unsigned ncom1 = 0;
+    vm_exit_t x = {0};
+    uint64_t done = 0;
+    const uint64_t t0 = stats_clock_ns();
+
+    while (done < t->max_steps) {
+        vm_run(vm, t->max_steps - done, &x);
+        done += x.retired;
+
+        if (x.reason != VM_EXIT_IO) {
+            if (x.reason != VM_EXIT_BUDGET) break;
+            continue;
+        }
+        if (!x.io_in && x.port == 0x3F8 && ncom1 < RUN_COM1_MAX)
+            com1[ncom1++] = (uint8_t)x.io_value;
+    }
+
+    t->ns = stats_clock_ns() - t0;
+    t->retired = done;
+    t->pass = !check(t, vm, x.reason == VM_EXIT_FAULT, com1, ncom1);
+
+    if (!t->pass && x.reason == VM_EXIT_FAULT) {
+        const size_t len = strlen(t->msg);
+        snprintf(t->msg + len, sizeof(t->msg) - len, " (fault at %04X:%04X, status %d)", x.cs, x.ip, (int)x.status);
+    }
+    vm_destroy(vms, id);
+}
+
+/* ============================================================
+ * workers
+ * ============================================================ */
+
+static void drain(pool_t *p)
+{
+    // VMManager is not thread-safe; each worker owns one
+    VMManager *vms = (VMManager*)malloc(sizeof(*vms));
+    if (!vms) return;
+    vmman_init(vms);
+
+    for (;;) {
+        unsigned i = atomic_fetch_add(&p->next, 1u);
+        if (i >= p->ntests) break;
+        run_test(vms, p->tests[i]);
+    }
+    vmman_free(vms);
+    free(vms);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker(LPVOID arg) { drain((pool_t*)arg); return 0; }
+#else
+static void *worker(void *arg) { drain((pool_t*)arg); return NULL; }
+#endif
+
+static unsigned cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (unsigned)si.dwNumberOfProcessors : 1u;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1u;
+#endif
+}
+
+static void run_pool(pool_t *p, unsigned nworkers)
+{
+    if (nworkers > p->ntests) nworkers = p->ntests;
+    if (nworkers > RUN_MAX_WORKERS) nworkers = RUN_MAX_WORKERS;
+    if (nworkers <= 1) { drain(p); return; }
+
+    // the main thread is one of the nworkers: spawn the rest
+    unsigned started = 0;
+#ifdef _WIN32
+    HANDLE th[RUN_MAX_WORKERS];
+    for (; started < nworkers - 1u; started++)
+        if (!(th[started] = CreateThread(NULL, 0, worker, p, 0, NULL))) break;
+    drain(p);   // main thread's share; also covers failed spawns
+    for (unsigned i = 0; i < started; i++) {
+        WaitForSingleObject(th[i], INFINITE);
+        CloseHandle(th[i]);
+    }
+#else
+    pthread_t th[RUN_MAX_WORKERS];
+    for (; started < nworkers - 1u; started++)
+        if (pthread_create(&th[started], NULL, worker, p) != 0) break;
+    drain(p);   // main thread's share; also covers failed spawns
+    for (unsigned i = 0; i < started; i++) pthread_join(th[i], NULL);
+#endif
+}
+
+/* ============================================================
+ * discovery
+ * ============================================================ */
+
+static int by_name(const void *a, const void *b)
+{
+    return strcmp((*(test_t* const*)a)->name, (*(test_t* const*)b)->name);
+}
+
+static unsigned discover(const char *root, test_t **out, unsigned max)
+{
+    DIR *d = opendir(root);
+    if (!d) return 0;
+
+    unsigned n = 0;
+    struct dirent *de;
+    while (n < max && (de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.' || strlen(de->d_name) >= sizeof(out[0]->name)) continue;
+
+        char cfg[600];
+        struct stat st;
+        snprintf(cfg, sizeof(cfg), "%s/%s/%s", root, de->d_name, RUN_MANIFEST);
+        if (stat(cfg, &st) != 0) continue;
+
+        test_t *t = (test_t*)calloc(1, sizeof(*t));
+        if (!t) break;
+        strcpy(t->name, de->d_name);
+        snprintf(t->dir, sizeof(t->dir), "%s/%s", root, de->d_name);
+
+        // a bad manifest is reported as an error, not dropped
+        t->error = !load_manifest(t, cfg);
+        out[n++] = t;
+    }
+    closedir(d);
+
+    qsort(out, n, sizeof(*out), by_name);
+    return n;
+}
+
+static const char *status_name(const test_t *t)
+{
+    if (t->error) return "error";
+    if (t->xfail[0]) return t->pass ? "xpass" : "xfail";
+    return t->pass ? "pass" : "fail";
+}
+
+// passed, or failed as the manifest predicted
+static bool test_ok(const test_t *t)
+{
+    return !t->error && (t->xfail[0] ? !t->pass : t->pass);
+}
+
+// shown next to the status; an error (missing image, bad manifest)
+// wins over the xfail reason, which is about the code under test
+static const char *test_note(const test_t *t)
+{
+    if (t->error) return t->msg;
+    if (t->xfail[0]) return t->pass ? "passed but marked xfail" : t->xfail;
+    return t->pass ? "" : t->msg;
+}
+
+/* ============================================================
+ * reports
+ * ============================================================ */
+
+static void xml_text(FILE *f, const char *s)
+{
+    for (; *s; s++) {
+        switch (*s) {
+            case '<':  fputs("&lt;", f);   break;
+            case '>':  fputs("&gt;", f);   break;
+            case '&':  fputs("&amp;", f);  break;
+            case '"':  fputs("&quot;", f); break;
+            default:   fputc(*s, f);       break;
+        }
+    }
+}
+
+static void json_text(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) fprintf(f, "\\u%04x", (unsigned char)*s);
+        else fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static bool write_junit(const char *path, const char *suite, test_t **t, unsigned n, unsigned failed, uint64_t ns)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuite name=\"");
+    xml_text(f, suite);
+    fprintf(f, "\" tests=\"%u\" failures=\"%u\" time=\"%.6f\">\n", n, failed, (double)ns / 1e9);
+    for (unsigned i = 0; i < n; i++) {
+        fprintf(f, "  <testcase name=\"");
+        xml_text(f, t[i]->name);
+        fprintf(f, "\" time=\"%.6f\"", (double)t[i]->ns / 1e9);
+        if (t[i]->pass && !t[i]->xfail[0]) { fprintf(f, "/>\n"); continue; }
+
+        // an expected failure is a skip; anything else not ok is a failure
+        const bool ok = test_ok(t[i]);
+        fprintf(f, ">\n    <%s message=\"", ok ? "skipped" : t[i]->error ? "error" : "failure");
+        xml_text(f, test_note(t[i]));
+        fprintf(f, "\"/>\n  </testcase>\n");
+    }
+    fprintf(f, "</testsuite>\n");
+    return fclose(f) == 0;
+}
+
+static bool write_json(const char *path, test_t **t, unsigned n, unsigned failed)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "{\"tests\":%u,\"failed\":%u,\"results\":[", n, failed);
+    for (unsigned i = 0; i < n; i++) {
+        fprintf(f, "%s\n  {\"name\":", i ? "," : "");
+        json_text(f, t[i]->name);
+        fprintf(f, ",\"status\":\"%s\",\"retired\":%llu,\"ns\":%llu,\"message\":",
+                status_name(t[i]), (unsigned long long)t[i]->retired, (unsigned long long)t[i]->ns);
+        json_text(f, t[i]->msg);
+        fputc('}', f);
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+/* ============================================================
+ * main
+ * ============================================================ */
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-j N] [--junit out.xml] [--json out.json] [dir]\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *root = RUN_DEFAULT_DIR, *junit = NULL, *json = NULL;
+    unsigned jobs = cpu_count();
+
+    for (int i = 1; i < argc; i++) {
+        const bool more = i + 1 < argc;
+        if (!strcmp(argv[i], "-j") && more)             jobs = (unsigned)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--junit") && more)   junit = argv[++i];
+        else if (!strcmp(argv[i], "--json") && more)    json = argv[++i];
+        else if (argv[i][0] != '-')                     root = argv[i];
+        else { usage(argv[0]); return 2; }
+    }
+
+    static test_t *tests[RUN_MAX_TESTS];
+    pool_t pool = { .tests = tests };
+    atomic_init(&pool.next, 0u);
+
+    pool.ntests = discover(root, tests, RUN_MAX_TESTS);
+    if (!pool.ntests) {
+        fprintf(stderr, "no %s manifests under %s\n", RUN_MANIFEST, root);
+        return 2;
+    }
+
+    const uint64_t t0 = stats_clock_ns();
+    run_pool(&pool, jobs ? jobs : 1u);
+    const uint64_t ns = stats_clock_ns() - t0;
+
+    unsigned failed = 0;
+    for (unsigned i = 0; i < pool.ntests; i++) {
+        const test_t *t = tests[i];
+        if (!test_ok(t)) failed++;
+
+        printf("%-6s %-24s %s\n", status_name(t), t->name, test_note(t));
+    }
+    printf("%u/%u ok in %.3f ms\n", pool.ntests - failed, pool.ntests, (double)ns / 1e6);
+
+    int rc = failed ? 1 : 0;
+    if (junit && !write_junit(junit, root, tests, pool.ntests, failed, ns)) { fprintf(stderr, "cannot write %s\n", junit); rc = 1; }
+    if (json && !write_json(json, tests, pool.ntests, failed)) { fprintf(stderr, "cannot write %s\n", json); rc = 1; }
+
+    for (unsigned i = 0; i < pool.ntests; i++) free(tests[i]);
+    return rc;
+}
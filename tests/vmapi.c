@@ -0,0 +1,627 @@
+// tests/vmapi.c
+
+/*
+ * Copyright 2026 Thomas L Hamilton
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host-side checks for the VM API.
+ *
+ *   x64-vmapi [--dir d] [name...]
+ *
+ * The guest-code suites (runner.c) see one VM from the inside; these
+ * checks drive several VMs from the host and look at what a guest
+ * cannot: which clone sees which write, which pages a clone shares,
+ * what a save-state brings back, where the scheduler left each VM of a
+ * fleet. Each check gets a private VMManager
+ * (freed afterwards, so a failing check leaks nothing) and builds its
+ * VMs from the small guest programs below. Save-states go to --dir (the
+ * current directory by default) and are removed after the check.
+ * Names on the command line pick checks; none runs them all. Output
+ * follows x64-test and the exit status is 1 if anything failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "vm/vm.h"
+#include "vm/snapshot.h"
+#include "vm/sched.h"
+#include "vm/imgstore.h"
+#include "vm/stats.h"       // stats_clock_ns()
+
+#define GUEST_RAM   (1024u * 1024u)
+#define GUEST_LOAD  0x1000u         // where CS:IP starts (0000:1000)
+#define GUEST_ROM   0xF0000u
+#define MAX_FILES   8               // save-states one check may write
+#define FLEET       8               // VMs on FLEET_WORKERS scheduler workers
+#define FLEET_WORKERS 2
+
+/* ============================================================
+ * guest programs
+ * ============================================================ */
+
+/* ES:DI = caller's; 0x800 words of 0x5A5A, then stop */
+static const uint8_t prog_stosw[] = {
+    0xFC,                   // cld
+    0xB8, 0x5A, 0x5A,       // mov ax, 0x5A5A
+    0xB9, 0x00, 0x08,       // mov cx, 0x0800
+    0xF3, 0xAB,             // rep stosw
+    0xF4,                   // hlt
+};
+
+/* DS:SI = ROM, ES:DI = RAM; 256 rounds of mixed ALU work with DF set
+   (so FLAGS is never zero), each storing a word below the last */
+static const uint8_t prog_mix[] = {
+    0xFD,                   // std
+    0xB9, 0x00, 0x01,       // mov cx, 0x0100
+    0x05, 0x19, 0x79,       // l: add ax, 0x7919
+    0x83, 0xD3, 0x00,       //    adc bx, 0
+    0x03, 0x1C,             //    add bx, [si]
+    0x4E,                   //    dec si
+    0x29, 0xC2,             //    sub dx, ax
+    0xAB,                   //    stosw
+    0x49,                   //    dec cx
+    0x75, 0xF1,             //    jnz l
+    0xF4,                   // hlt
+};
+
+/* AX += BX, DX times 1000 (alu_loop-like, ~3000 instructions a round) */
+static const uint8_t prog_count[] = {
+    0xB9, 0xE8, 0x03,       // o: mov cx, 1000
+    0x01, 0xD8,             // i: add ax, bx
+    0x49,                   //    dec cx
+    0x75, 0xFB,             //    jnz i
+    0x4A,                   //    dec dx
+    0x75, 0xF5,             //    jnz o
+    0xF4,                   // hlt
+};
+
+/* forever */
+static const uint8_t prog_spin[] = {
+    0xEB, 0xFE,             // jmp $
+};
+
+/* ============================================================
+ * helpers
+ * ============================================================ */
+
+static const char *file_dir = ".";
+static char files[MAX_FILES][512];
+static unsigned nfiles;
+
+/* path for a save-state called name, removed after the check */
+static const char *file_path(const char *name)
+{
+    if (nfiles == MAX_FILES) return "";
+    char *p = files[nfiles++];
+    snprintf(p, sizeof(files[0]), "%s/vmapi-%s.snap", file_dir, name);
+    return p;
+}
+
+static void files_remove(void)
+{
+    for (unsigned i = 0; i < nfiles; i++) remove(files[i]);
+    nfiles = 0;
+}
+
+static char fail_msg[256];
+
+static bool failf(int line, const char *fmt, ...)
+{
+    const int n = snprintf(fail_msg, sizeof(fail_msg), "line %d: ", line);
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(fail_msg + n, sizeof(fail_msg) - (size_t)n, fmt, ap);
+    va_end(ap);
+    return false;
+}
+
+#define EXPECT(cond, ...) do { if (!(cond)) return failf(__LINE__, __VA_ARGS__); } while (0)
+
+static VM *fresh(VMManager *m, const char *name)
+{
+    return vm_get(m, vm_create_default(m, GUEST_RAM, name));
+}
+
+/* fresh VM with prog at CS:IP */
+static VM *guest(VMManager *m, const char *name, const uint8_t *prog, size_t len)
+{
+    VM *vm = fresh(m, name);
+    uint8_t *dst = vm ? vm_ram_range(vm, GUEST_LOAD, len) : NULL;
+    if (!dst) return NULL;
+
+    memcpy(dst, prog, len);
+    vm_code_flush(vm);
+    return vm;
+}
+
+static VM *clone_of(VMManager *m, const VM *src, const char *name)
+{
+    return vm_get(m, vm_clone(m, src->id, name));
+}
+
+static bool fill(VM *vm, uint32_t addr, uint8_t val, size_t len)
+{
+    uint8_t *p = vm_ram_range(vm, addr, len);
+    if (p) memset(p, val, len);
+    return p != NULL;
+}
+
+/* byte at addr, -1 if it does not read */
+static int peek(VM *vm, uint32_t addr)
+{
+    uint8_t b;
+    return vm_read8(vm, addr, &b) ? b : -1;
+}
+
+/* first address in [addr, addr+len) not reading as val, or -1 */
+static long differs(VM *vm, uint32_t addr, uint8_t val, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        if (peek(vm, addr + (uint32_t)i) != val) return (long)(addr + i);
+    return -1;
+}
+
+static bool run_to_halt(VM *vm, uint64_t budget)
+{
+    vm_exit_t x;
+    vm_run(vm, budget, &x);
+    return x.reason == VM_EXIT_HALT;
+}
+
+/* first register (or halted) that differs, NULL if none */
+static const char *cpu_diff(const x86_cpu_t *a, const x86_cpu_t *b)
+{
+    const struct { const char *name; unsigned a, b; } r[] = {
+        { "ax", a->ax, b->ax }, { "bx", a->bx, b->bx }, { "cx", a->cx, b->cx }, { "dx", a->dx, b->dx },
+        { "sp", a->sp, b->sp }, { "bp", a->bp, b->bp }, { "si", a->si, b->si }, { "di", a->di, b->di },
+        { "cs", a->cs, b->cs }, { "ds", a->ds, b->ds }, { "es", a->es, b->es }, { "ss", a->ss, b->ss },
+        { "ip", a->ip, b->ip }, { "flags", x86_flags(a), x86_flags(b) }, { "halted", a->halted, b->halted },
+    };
+    for (size_t i = 0; i < sizeof(r) / sizeof(r[0]); i++)
+        if (r[i].a != r[i].b) return r[i].name;
+    return NULL;
+}
+
+/* first guest address reading differently in a and b, or -1 */
+static long ram_diff(VM *a, VM *b)
+{
+    for (uint32_t at = 0; at < GUEST_RAM; at++)
+        if (peek(a, at) != peek(b, at)) return (long)at;
+    return -1;
+}
+
+/* ============================================================
+ * copy-on-write clones
+ * ============================================================ */
+
+// writes by a clone, its source and a sibling after the clone stay put
+static bool clone_isolation(VMManager *m)
+{
+    VM *src = fresh(m, "src");
+    EXPECT(src && fill(src, 0x20000, 0x11, 0x2000), "cannot set up the source");
+
+    VM *a = clone_of(m, src, "a");
+    VM *b = clone_of(m, src, "b");
+    EXPECT(a && b, "vm_clone failed");
+
+    EXPECT(vm_write8(a, 0x20000, 0xAA) && vm_write8(src, 0x21000, 0xBB) && vm_write8(b, 0x20800, 0xCC),
+           "vm_write8 failed");
+
+    static const struct { uint32_t addr; int src, a, b; } want[] = {
+        { 0x20000, 0x11, 0xAA, 0x11 },
+        { 0x20800, 0x11, 0x11, 0xCC },
+        { 0x21000, 0xBB, 0x11, 0x11 },
+        { 0x20001, 0x11, 0x11, 0x11 },
+        { 0x21FFF, 0x11, 0x11, 0x11 },
+    };
+    for (size_t i = 0; i < sizeof(want) / sizeof(want[0]); i++) {
+        const uint32_t at = want[i].addr;
+        EXPECT(peek(src, at) == want[i].src && peek(a, at) == want[i].a && peek(b, at) == want[i].b,
+               "%05X reads %02X/%02X/%02X in src/a/b, want %02X/%02X/%02X", (unsigned)at,
+               peek(src, at), peek(a, at), peek(b, at), want[i].src, want[i].a, want[i].b);
+    }
+    return true;
+}
+
+// the REP string engine and a word write straddling two shared pages
+static bool clone_unshare_paths(VMManager *m)
+{
+    VM *src = guest(m, "src", prog_stosw, sizeof(prog_stosw));
+    EXPECT(src && fill(src, 0x30000, 0x22, 0x5000), "cannot set up the source");
+
+    VM *a = clone_of(m, src, "a");
+    VM *b = clone_of(m, src, "b");
+    EXPECT(a && b, "vm_clone failed");
+
+    // 0x30FF0-0x31FEF: the tail of one shared page and most of the next
+    a->cpu.es = 0x3000;
+    a->cpu.di = 0x0FF0;
+    EXPECT(run_to_halt(a, 64), "rep stosw did not reach hlt");
+    EXPECT(a->cpu.cx == 0 && a->cpu.di == 0x1FF0, "cx=%04X di=%04X after rep stosw", a->cpu.cx, a->cpu.di);
+
+    long at;
+    EXPECT((at = differs(a, 0x30FF0, 0x5A, 0x1000)) < 0, "clone a: %05lX missed the store", at);
+    EXPECT(peek(a, 0x30FEF) == 0x22 && peek(a, 0x31FF0) == 0x22, "clone a: store ran past its ends");
+    EXPECT((at = differs(src, 0x30000, 0x22, 0x2000)) < 0, "source sees a's store at %05lX", at);
+    EXPECT((at = differs(b, 0x30000, 0x22, 0x2000)) < 0, "sibling sees a's store at %05lX", at);
+
+    // low byte on page 0x33, high byte on 0x34: both must be copied
+    uint16_t w = 0;
+    EXPECT(vm_write16(b, 0x33FFF, 0xBEEF), "vm_write16 failed");
+    EXPECT(vm_read16(b, 0x33FFF, &w) && w == 0xBEEF, "clone b reads %04X back", w);
+    EXPECT(peek(b, 0x33FFE) == 0x22 && peek(b, 0x34001) == 0x22, "clone b: word write spilled over");
+    EXPECT(peek(src, 0x33FFF) == 0x22 && peek(src, 0x34000) == 0x22, "source sees b's word write");
+    EXPECT(peek(a, 0x33FFF) == 0x22 && peek(a, 0x34000) == 0x22, "sibling sees b's word write");
+    return true;
+}
+
+// cloning something that has copied nothing since its last freeze adds no base
+static bool clone_shares_base(VMManager *m)
+{
+    VM *src = fresh(m, "src");
+    EXPECT(src && fill(src, 0x20000, 0x33, 0x1000), "cannot set up the source");
+
+    VM *a = clone_of(m, src, "a");
+    EXPECT(a && src->nbases == 1 && a->nbases == 1 && a->bases[0] == src->bases[0],
+           "first clone: %u/%u bases", src->nbases, a ? a->nbases : 0u);
+    vm_ram_base_t *base = src->bases[0];
+
+    VM *aa = clone_of(m, a, "aa");
+    VM *s2 = clone_of(m, src, "s2");
+    EXPECT(aa && s2, "vm_clone failed");
+    EXPECT(a->nbases == 1 && aa->nbases == 1 && aa->bases[0] == base, "clone of a clone: %u bases", aa->nbases);
+    EXPECT(src->nbases == 1 && s2->nbases == 1 && s2->bases[0] == base, "second clone of src: %u bases", s2->nbases);
+    EXPECT(base->refs == 4, "base has %u refs, want 4", base->refs);
+
+    // once a has a page of its own, the next clone freezes it into a new base
+    EXPECT(vm_write8(a, 0x20000, 0x44), "vm_write8 failed");
+    VM *ab = clone_of(m, a, "ab");
+    EXPECT(ab && a->nbases == 2 && ab->nbases == 2 && ab->bases[0] == base && ab->bases[1] == a->bases[1],
+           "clone after a write: %u bases", ab ? ab->nbases : 0u);
+    EXPECT(base->refs == 5 && a->bases[1]->refs == 2, "refs %u/%u, want 5/2", base->refs, a->bases[1]->refs);
+    EXPECT(peek(ab, 0x20000) == 0x44 && peek(aa, 0x20000) == 0x33 && peek(src, 0x20000) == 0x33,
+           "20000 reads %02X/%02X/%02X in ab/aa/src", peek(ab, 0x20000), peek(aa, 0x20000), peek(src, 0x20000));
+    return true;
+}
+
+// the base outlives the VM it was frozen from
+static bool clone_outlives_source(VMManager *m)
+{
+    VM *src = fresh(m, "src");
+    EXPECT(src && fill(src, 0x20000, 0x55, 0x8000), "cannot set up the source");
+
+    VM *a = clone_of(m, src, "a");
+    VM *b = clone_of(m, src, "b");
+    EXPECT(a && b, "vm_clone failed");
+    vm_ram_base_t *base = src->bases[0];
+
+    EXPECT(vm_destroy(m, src->id), "cannot destroy the source");
+    EXPECT(base->refs == 2, "base has %u refs after the source went, want 2", base->refs);
+
+    long at;
+    EXPECT((at = differs(a, 0x20000, 0x55, 0x8000)) < 0, "clone a lost %05lX", at);
+    EXPECT(vm_write8(a, 0x20000, 0xAA), "vm_write8 failed");
+    EXPECT((at = differs(b, 0x20000, 0x55, 0x8000)) < 0, "clone b lost %05lX", at);
+
+    // the last clone standing is charged for the base
+    EXPECT(vm_destroy(m, b->id), "cannot destroy clone b");
+    EXPECT(base->refs == 1, "base has %u refs, want 1", base->refs);
+    EXPECT(vm_ram_resident(a) >= 0x8000, "clone a counts %zu resident bytes", vm_ram_resident(a));
+    EXPECT(peek(a, 0x20000) == 0xAA && (at = differs(a, 0x20001, 0x55, 0x7FFF)) < 0, "clone a lost %05lX", at);
+    return true;
+}
+
+/* ============================================================
+ * save-states
+ * ============================================================ */
+
+// a VM saved mid-run comes back whole and carries on the same way
+static bool snap_roundtrip(VMManager *m)
+{
+    uint8_t rom[0x2000];
+    for (size_t i = 0; i < sizeof(rom); i++) rom[i] = (uint8_t)(i * 7u + 3u);
+
+    VM *a = guest(m, "a", prog_mix, sizeof(prog_mix));
+    img_t *img = img_from(rom, sizeof(rom));
+    const bool mapped = a && img && vm_map_image(a, GUEST_ROM, img);
+    img_release(img);
+    EXPECT(mapped, "cannot set up the VM");
+
+    a->cpu.ds = GUEST_ROM >> 4;
+    a->cpu.si = 0x0200;
+    a->cpu.es = 0x2000;
+    a->cpu.di = 0x0400;
+
+    // stop inside the loop, between a store and the next one
+    vm_exit_t x;
+    vm_run(a, 777, &x);
+    EXPECT(x.reason == VM_EXIT_BUDGET && a->cpu.cx != 0, "the program ended early (cx=%04X)", a->cpu.cx);
+    EXPECT(x86_flags(&a->cpu) & X86_FL_DF, "flags %04X lack DF", x86_flags(&a->cpu));
+
+    const char *path = file_path("roundtrip");
+    EXPECT(vm_save(a, path), "vm_save %s failed", path);
+    VM *b = vm_get(m, vm_restore(m, path, "b"));
+    EXPECT(b, "vm_restore %s failed", path);
+
+    const char *r;
+    long at;
+    EXPECT(!(r = cpu_diff(&a->cpu, &b->cpu)), "%s differs after restore", r);
+    EXPECT((at = ram_diff(a, b)) < 0, "%05lX differs after restore", at);
+
+    // the ROM came back read-only
+    EXPECT(vm_write8(b, GUEST_ROM, 0xFF) && peek(b, GUEST_ROM) == rom[0], "ROM at %05X took a write", GUEST_ROM);
+
+    EXPECT(run_to_halt(a, 10000) && run_to_halt(b, 10000), "the program did not halt");
+    EXPECT(!(r = cpu_diff(&a->cpu, &b->cpu)), "%s differs at hlt", r);
+    EXPECT((at = ram_diff(a, b)) < 0, "%05lX differs at hlt", at);
+
+    // 256 words from ES:0400 down to ES:0202, the last one the final ax
+    uint16_t first = 0, last = 0;
+    EXPECT(vm_read16(b, 0x20400, &first) && first == 0x7919 && vm_read16(b, 0x20202, &last) && last == b->cpu.ax &&
+           peek(b, 0x20402) == 0 && peek(b, 0x20201) == 0, "stores at %04X..%04X are off", first, last);
+    return true;
+}
+
+/* vm_snap_diff(a, b) listing into out (cap bytes); pages or -1 */
+static long snap_diff_text(const char *a, const char *b, char *out, size_t cap)
+{
+    FILE *f = tmpfile();
+    if (!f) return -1;
+
+    const long n = vm_snap_diff(a, b, f);
+    rewind(f);
+    const size_t len = fread(out, 1, cap - 1u, f);
+    out[len] = '\0';
+    fclose(f);
+    return n;
+}
+
+// a delta holds every page written since its parent, zeroed ones included
+static bool snap_delta(VMManager *m)
+{
+    VM *a = guest(m, "a", prog_stosw, sizeof(prog_stosw));
+    EXPECT(a && fill(a, 0x40000, 0x44, 0x10) && fill(a, 0x70000, 0x77, 0x1000), "cannot set up the VM");
+
+    const char *full = file_path("full"), *delta = file_path("delta"), *reset = file_path("reset");
+    EXPECT(vm_save(a, full), "vm_save %s failed", full);
+    EXPECT(vm_dirty_count(a) == 0, "%zu pages dirty right after a save", vm_dirty_count(a));
+
+    // one page through vm_write8, two through REP STOSW, one through a
+    // loader, and one zeroed and handed back to the host
+    EXPECT(vm_write8(a, 0x40001, 0x99), "vm_write8 failed");
+    a->cpu.es = 0x5000;
+    a->cpu.di = 0x0FF0;
+    EXPECT(run_to_halt(a, 64), "rep stosw did not reach hlt");
+    uint8_t *p = vm_ram_range(a, 0x60000, 4);
+    EXPECT(p, "vm_ram_range failed");
+    memcpy(p, "DATA", 4);
+    EXPECT(fill(a, 0x70000, 0x00, 0x1000) && vm_ram_trim(a) > 0, "cannot trim the zeroed page");
+    EXPECT(vm_dirty_count(a) == 5, "%zu pages dirty, want 5", vm_dirty_count(a));
+
+    EXPECT(vm_save_delta(a, delta), "vm_save_delta %s failed", delta);
+    VM *b = vm_get(m, vm_restore(m, delta, "b"));
+    EXPECT(b, "vm_restore %s failed", delta);
+    EXPECT(vm_dirty_count(b) == 0, "%zu pages dirty right after a restore", vm_dirty_count(b));
+
+    long at;
+    EXPECT(peek(b, 0x40000) == 0x44 && peek(b, 0x40001) == 0x99, "vm_write8 page lost");
+    EXPECT((at = differs(b, 0x50FF0, 0x5A, 0x1000)) < 0, "rep stosw store lost at %05lX", at);
+    EXPECT(peek(b, 0x60000) == 'D' && peek(b, 0x60003) == 'A', "loader page lost");
+    EXPECT((at = differs(b, 0x70000, 0x00, 0x1000)) < 0, "trimmed page reads %02X at %05lX", peek(b, (uint32_t)at), at);
+    EXPECT((at = ram_diff(a, b)) < 0, "%05lX differs after restore", at);
+
+    char text[512];
+    long n = snap_diff_text(full, delta, text, sizeof(text));
+    EXPECT(n == 5 && !strcmp(text, "00040000-00040FFF  1 page\n"
+                                   "00050000-00051FFF  2 pages\n"
+                                   "00060000-00060FFF  1 page\n"
+                                   "00070000-00070FFF  1 page\n"),
+           "vm_snap_diff found %ld pages:\n%s", n, text);
+
+    // a cleared VM releases all of its RAM: none of it is resident, all
+    // of it is in the next delta and reads back as zero
+    vm_reset(a, true);
+    EXPECT(vm_dirty_count(a) == GUEST_RAM >> MM_PAGE_SHIFT, "%zu pages dirty after a clear", vm_dirty_count(a));
+    EXPECT(vm_save_delta(a, reset), "vm_save_delta %s failed", reset);
+    VM *c = vm_get(m, vm_restore(m, reset, "c"));
+    EXPECT(c, "vm_restore %s failed", reset);
+    EXPECT((at = differs(c, 0, 0x00, GUEST_RAM)) < 0, "%05lX reads %02X after a clear", at, peek(c, (uint32_t)at));
+
+    // code page, 40, 50-51, 60
+    n = snap_diff_text(delta, reset, text, sizeof(text));
+    EXPECT(n == 5, "vm_snap_diff found %ld pages:\n%s", n, text);
+    return true;
+}
+
+/* ============================================================
+ * scheduler
+ * ============================================================ */
+
+// clones of one image, more of them than workers: every VM halts with
+// its own result whether it was paused, stolen or left alone
+static bool sched_fleet(VMManager *m)
+{
+    VM *src = guest(m, "src", prog_count, sizeof(prog_count));
+    EXPECT(src, "cannot set up the source");
+
+    // even VMs finish in one slice, odd ones take several; start order
+    // deals them round robin, so worker 0 runs dry and has to steal.
+    // The last one adds 0 for 65536 rounds: it keeps running until the
+    // host parks it and cuts its count short.
+    VM *v[FLEET];
+    uint16_t want[FLEET];
+    for (unsigned i = 0; i < FLEET; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "vm%u", i);
+        v[i] = clone_of(m, src, name);
+        EXPECT(v[i], "vm_clone failed");
+        v[i]->cpu.bx = i == FLEET - 1u ? 0u : (uint16_t)(2u * i + 1u);
+        v[i]->cpu.dx = i == FLEET - 1u ? 0u : (i & 1u) ? 300u : 20u;
+        want[i] = (uint16_t)(v[i]->cpu.bx * 1000u * v[i]->cpu.dx);
+    }
+    VM *spin = v[FLEET - 1u];
+
+    sched_t *s = sched_create(m, FLEET_WORKERS);
+    EXPECT(s, "sched_create failed");
+    bool ok = true;
+    for (unsigned i = 0; i < FLEET; i++) ok = sched_start(s, v[i]->id) && ok;
+
+    // park one long VM at once and hold it while the short ones halt
+    sched_info_t in;
+    const bool paused = sched_pause(s, v[1]->id);
+    sched_info(s, v[1]->id, &in);
+    const vm_sched_state_t held = in.state;
+
+    sched_stats_t st;
+    bool shorts = false;
+    do {
+        shorts = true;
+        for (unsigned i = 0; i < FLEET - 1u; i += 2u) shorts = shorts && !sched_running(s, v[i]->id);
+        sched_get_stats(s, &st);
+    } while ((!shorts || !st.steals) && sched_running(s, spin->id));
+    const bool others = sched_running(s, spin->id);
+
+    const bool cut = sched_pause(s, spin->id);
+    spin->cpu.cx = 1;
+    spin->cpu.dx = 1;
+    ok = sched_start(s, spin->id) && sched_start(s, v[1]->id) && ok;
+    sched_wait(s);
+
+    sched_get_stats(s, &st);
+    uint64_t slices = 0;
+    const char *bad = NULL;
+    for (unsigned i = 0; i < FLEET && !bad; i++) {
+        sched_info(s, v[i]->id, &in);
+        slices += in.slices;
+        if (in.state != VM_SCHED_STOPPED || in.last.reason != VM_EXIT_HALT) bad = v[i]->name;
+        else if (v[i]->cpu.ax != want[i] || v[i]->cpu.cx || v[i]->cpu.dx || !v[i]->cpu.halted) bad = v[i]->name;
+    }
+    sched_destroy(s);
+
+    EXPECT(ok, "sched_start failed");
+    EXPECT(paused && held == VM_SCHED_PAUSED, "vm1 was not parked (state %d)", (int)held);
+    EXPECT(others && cut, "%s stopped before the short VMs were done", spin->name);
+    EXPECT(!bad, "%s did not halt with its own result", bad);
+    EXPECT(st.workers == FLEET_WORKERS && st.slices == slices, "%llu slices in all, %llu counted per VM",
+           (unsigned long long)st.slices, (unsigned long long)slices);
+    EXPECT(st.steals > 0, "no steals with %u VMs on %u workers", FLEET, FLEET_WORKERS);
+    return true;
+}
+
+// destroying the scheduler under queued VMs parks them, still usable
+static bool sched_destroy_queued(VMManager *m)
+{
+    VM *src = guest(m, "src", prog_spin, sizeof(prog_spin));
+    EXPECT(src, "cannot set up the source");
+
+    VM *v[FLEET];
+    for (unsigned i = 0; i < FLEET; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "vm%u", i);
+        EXPECT((v[i] = clone_of(m, src, name)) != NULL, "vm_clone failed");
+    }
+
+    sched_t *s = sched_create(m, FLEET_WORKERS);
+    EXPECT(s, "sched_create failed");
+    bool ok = true;
+    for (unsigned i = 0; i < FLEET; i++) ok = sched_start(s, v[i]->id) && ok;
+    sched_destroy(s);
+    EXPECT(ok, "sched_start failed");
+
+    // back on this thread: each one runs where it was left
+    for (unsigned i = 0; i < FLEET; i++) {
+        vm_exit_t x;
+        EXPECT(v[i]->sched.state == VM_SCHED_PAUSED, "%s left in state %d", v[i]->name, (int)v[i]->sched.state);
+        vm_run(v[i], 100, &x);
+        EXPECT(x.reason == VM_EXIT_BUDGET && v[i]->cpu.ip == GUEST_LOAD, "%s: exit %d at ip %04X",
+               v[i]->name, (int)x.reason, v[i]->cpu.ip);
+    }
+    return true;
+}
+
+/* ============================================================
+ * driver
+ * ============================================================ */
+
+typedef struct check {
+    const char *name;
+    bool (*fn)(VMManager *m);
+} check_t;
+
+static const check_t checks[] = {
+    { "clone_isolation",       clone_isolation },
+    { "clone_unshare_paths",   clone_unshare_paths },
+    { "clone_shares_base",     clone_shares_base },
+    { "clone_outlives_source", clone_outlives_source },
+    { "snap_roundtrip",        snap_roundtrip },
+    { "snap_delta",            snap_delta },
+    { "sched_fleet",           sched_fleet },
+    { "sched_destroy_queued",  sched_destroy_queued },
+};
+
+static bool selected(const char *name, char **names, int n)
+{
+    for (int i = 0; i < n; i++)
+        if (!strcmp(names[i], name)) return true;
+    return n == 0;
+}
+
+int main(int argc, char **argv)
+{
+    char *names[sizeof(checks) / sizeof(checks[0])];
+    int nnames = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--dir") && i + 1 < argc) file_dir = argv[++i];
+        else if (argv[i][0] != '-' && nnames < (int)(sizeof(names) / sizeof(names[0]))) names[nnames++] = argv[i];
+        else {
+            fprintf(stderr, "usage: %s [--dir d] [name...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    unsigned ran = 0, failed = 0;
+    const uint64_t t0 = stats_clock_ns();
+
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        if (!selected(checks[i].name, names, nnames)) continue;
+
+        VMManager m;
+        vmman_init(&m);
+        fail_msg[0] = '\0';
+        const bool ok = checks[i].fn(&m);
+        vmman_free(&m);
+        files_remove();
+
+        ran++;
+        if (!ok) failed++;
+        printf("%-6s %-24s %s\n", ok ? "pass" : "fail", checks[i].name, ok ? "" : fail_msg);
+    }
+    if (!ran) {
+        fprintf(stderr, "no such check\n");
+        return 2;
+    }
+
+    const uint64_t ns = stats_clock_ns() - t0;
+    printf("%u/%u ok in %.3f ms\n", ran - failed, ran, (double)ns / 1e6);
+    return failed ? 1 : 0;
+}